@@ -0,0 +1,437 @@
+/***************************************************
+ *
+ *  MachineActivation.cpp
+ *
+ *  MachineActivation class -
+ *		sigmoid activation & derivative for the
+ *		MachineVariables class:  exact (libm),
+ *		interpolated lookup table, or rational
+ *		approximation, with an accuracy &
+ *		speed benchmark.
+ *
+ **************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "MachineActivation.h"
+
+/* approximations are evaluated in single precision for float   */
+/* networks, otherwise in double (fixed point nets are converted) */
+#if MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_FLOAT
+typedef float  ActivationReal;
+#else
+typedef double ActivationReal;
+#endif
+
+/* linear interpolation error is at most h^2 / 8 * max|f''|:  these */
+/* are max|sigmoid''| (1 / (6 * sqrt(3))) and max|sigmoid'''| (1/8)  */
+#define SIGMOID_SECOND_MAX  0.0962250448649376
+#define SIGMOID_THIRD_MAX   0.125
+
+#define TABLE_MAXIMUM_LENGTH  65535
+
+/* tanh([7/6] Pade approximant) reaches 1 at |y| = RATIONAL_LIMIT */
+#define RATIONAL_LIMIT  4.9718
+
+/* benchmark & error sweep parameters */
+#define BENCHMARK_UNITS       256
+#define BENCHMARK_PASSES      8192
+#define ERROR_SWEEP_LIMIT     20.0
+#define ERROR_SWEEP_STEPS     10240
+
+static ActivationReal rationalSigmoid(ActivationReal x)
+{
+  /* sigmoid(x) = (1 + tanh(x / 2)) / 2 */
+  ActivationReal y = x * (ActivationReal)0.5;
+
+  if (y >= (ActivationReal)RATIONAL_LIMIT)
+  {
+    return 1;
+  }
+  if (y <= (ActivationReal)-RATIONAL_LIMIT)
+  {
+    return 0;
+  }
+
+  ActivationReal y2 = y * y;
+  ActivationReal n  = y * (135135 + y2 * (17325 + y2 * (378 + y2)));
+  ActivationReal d  = 135135 + y2 * (62370 + y2 * (3150 + 28 * y2));
+
+  return (ActivationReal)0.5 + (ActivationReal)0.5 * n / d;
+}
+
+static ActivationReal rationalDerivative(ActivationReal x)
+{
+  /* derivative of rationalSigmoid( ) itself, so the weight updates */
+  /* follow the function the forward pass actually computed        */
+  ActivationReal y = x * (ActivationReal)0.5;
+
+  if ((y >= (ActivationReal)RATIONAL_LIMIT) ||
+      (y <= (ActivationReal)-RATIONAL_LIMIT))
+  {
+    return 0;
+  }
+
+  ActivationReal y2 = y * y;
+  ActivationReal n  = y * (135135 + y2 * (17325 + y2 * (378 + y2)));
+  ActivationReal d  = 135135 + y2 * (62370 + y2 * (3150 + 28 * y2));
+  ActivationReal dn = 135135 + y2 * (51975 + y2 * (1890 + 7 * y2));
+  ActivationReal dd = y * (124740 + y2 * (12600 + 168 * y2));
+
+  return (ActivationReal)0.25 * (dn * d - n * dd) / (d * d);
+}
+
+MachineActivation::MachineActivation( )
+{
+  iType             = MACHINE_ACTIVATION_EXACT;
+  dErrorBound       = MACHINE_ACTIVATION_ERROR_BOUND;
+  dTableLimit       = 0;
+  dTableScale       = 0;
+  lTableLimitRaw    = 0;
+  llTableScaleQ16   = 0;
+  usTableLength     = 0;
+  pdSigmoidTable    = NULL;
+  pdDerivativeTable = NULL;
+}
+
+MachineActivation::~MachineActivation( )
+{
+  release( );
+}
+
+bool MachineActivation::configure(int iLocalType, double dLocalErrorBound)
+{
+  release( );
+
+  iType       = iLocalType;
+  dErrorBound = (dLocalErrorBound > 0) ? dLocalErrorBound
+                                       : MACHINE_ACTIVATION_ERROR_BOUND;
+
+  if (iType != MACHINE_ACTIVATION_TABLE)
+  {
+    return true;
+  }
+
+  /* beyond +/-ln(1 / bound) the sigmoid is within bound of 0 or 1, */
+  /* and its derivative within bound of 0                           */
+  double dSpacingA = sqrt(8 * dErrorBound / SIGMOID_SECOND_MAX);
+  double dSpacingD = sqrt(8 * dErrorBound / SIGMOID_THIRD_MAX);
+  double dSpacing  = (dSpacingA < dSpacingD) ? dSpacingA : dSpacingD;
+  double dLength;
+
+  dTableLimit = log(1 / dErrorBound);
+  dLength     = ceil(2 * dTableLimit / dSpacing) + 1;
+
+  if (dLength > TABLE_MAXIMUM_LENGTH)
+  {
+    /* warn that the error bound cannot be met by the table */
+    printf("Activation error bound %g needs %.0f table entries, using %u\n",
+           dErrorBound, dLength, TABLE_MAXIMUM_LENGTH);
+    dLength = TABLE_MAXIMUM_LENGTH;
+  }
+
+  usTableLength = (unsigned short)dLength;
+  dTableScale   = (usTableLength - 1) / (2 * dTableLimit);
+
+#if MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_FIXED
+  lTableLimitRaw  = MachineScalar(dTableLimit).getRaw( );
+  llTableScaleQ16 = (long long)(dTableScale * 65536.0 + 0.5);
+#endif
+
+  /* ALLOCATION of the activation & derivative tables */
+  pdSigmoidTable    = new MachineScalar[usTableLength];
+  pdDerivativeTable = new MachineScalar[usTableLength];
+
+  if (!pdSigmoidTable || !pdDerivativeTable)
+  {
+    /* warn that the tables could not be allocated */
+    printf("Unable to allocate activation tables within ");
+    printf("MachineActivation::configure( )\n");
+    release( );
+    iType = MACHINE_ACTIVATION_EXACT;
+    return false;
+  }
+
+  for (unsigned short k = 0; k < usTableLength; k++)
+  {
+    double dNet        = k / dTableScale - dTableLimit;
+    double dActivation = 1 / ( 1 + exp(-1 * dNet) );
+
+    pdSigmoidTable[k]    = dActivation;
+    pdDerivativeTable[k] = dActivation * (1 - dActivation);
+  }
+
+  return true;
+}
+
+void MachineActivation::release( )
+{
+  /* DEALLOCATION of the activation & derivative tables */
+  if (pdSigmoidTable)
+  {
+    delete [] pdSigmoidTable;
+  }
+  if (pdDerivativeTable)
+  {
+    delete [] pdDerivativeTable;
+  }
+
+  dTableLimit       = 0;
+  dTableScale       = 0;
+  lTableLimitRaw    = 0;
+  llTableScaleQ16   = 0;
+  usTableLength     = 0;
+  pdSigmoidTable    = NULL;
+  pdDerivativeTable = NULL;
+}
+
+int MachineActivation::getType( ) const
+{
+  return iType;
+}
+
+double MachineActivation::getErrorBound( ) const
+{
+  return dErrorBound;
+}
+
+const char * MachineActivation::getName( ) const
+{
+  switch (iType)
+  {
+    case MACHINE_ACTIVATION_TABLE:
+      return "table";
+    case MACHINE_ACTIVATION_RATIONAL:
+      return "rational";
+    default:
+      return "exact";
+  }
+}
+
+unsigned short MachineActivation::getTableLength( ) const
+{
+  return usTableLength;
+}
+
+int MachineActivation::locate(const MachineScalar & oNet, unsigned short & k,
+                              MachineScalar & oFraction) const
+{
+#if MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_FIXED
+  /* position in 16 fraction bits, from the raw net:  no floating */
+  /* point, which FPU-less targets would have to emulate          */
+  long long llPosition = (((long long)oNet.getRaw( ) + lTableLimitRaw) *
+                          llTableScaleQ16) >> MACHINE_FIXED_FRACTION_BITS;
+
+  if (llPosition <= 0)
+  {
+    return -1;
+  }
+  if (llPosition >= ((long long)(usTableLength - 1) << 16))
+  {
+    return 1;
+  }
+
+  k         = (unsigned short)(llPosition >> 16);
+  oFraction = MachineFixed::fromRaw((long)(llPosition & 0xFFFF) <<
+                                    (MACHINE_FIXED_FRACTION_BITS - 16));
+#else
+  ActivationReal dPosition = ((ActivationReal)machineToDouble(oNet) +
+                              (ActivationReal)dTableLimit) *
+                              (ActivationReal)dTableScale;
+
+  if (dPosition <= 0)
+  {
+    return -1;
+  }
+  if (dPosition >= usTableLength - 1)
+  {
+    return 1;
+  }
+
+  k         = (unsigned short)dPosition;
+  oFraction = MachineScalar(dPosition - k);
+#endif
+
+  return 0;
+}
+
+void MachineActivation::activate(const MachineScalar * pdNet,
+                                 MachineScalar * pdActivation,
+                                 unsigned short usLength) const
+{
+  switch (iType)
+  {
+    case MACHINE_ACTIVATION_TABLE:
+      for (unsigned short i = 0; i < usLength; i++)
+      {
+        unsigned short k = 0;
+        MachineScalar  oFraction;
+        int            iSide = locate(pdNet[i], k, oFraction);
+
+        if (iSide < 0)
+        {
+          pdActivation[i] = 0;
+        }
+        else if (iSide > 0)
+        {
+          pdActivation[i] = 1;
+        }
+        else
+        {
+          pdActivation[i] = pdSigmoidTable[k] +
+                            oFraction *
+                            (pdSigmoidTable[k + 1] - pdSigmoidTable[k]);
+        }
+      }
+      break;
+
+    case MACHINE_ACTIVATION_RATIONAL:
+      for (unsigned short i = 0; i < usLength; i++)
+      {
+        pdActivation[i] = rationalSigmoid((ActivationReal)machineToDouble(pdNet[i]));
+      }
+      break;
+
+    default:
+      for (unsigned short i = 0; i < usLength; i++)
+      {
+        pdActivation[i] = machineSigmoid(pdNet[i]);
+      }
+      break;
+  }
+}
+
+void MachineActivation::delta(const MachineScalar * pdNet,
+                              const MachineScalar * pdActivation,
+                              const MachineScalar * pdError,
+                              MachineScalar * pdDelta,
+                              unsigned short usLength) const
+{
+  switch (iType)
+  {
+    case MACHINE_ACTIVATION_TABLE:
+      for (unsigned short i = 0; i < usLength; i++)
+      {
+        unsigned short k = 0;
+        MachineScalar  oFraction;
+
+        if (locate(pdNet[i], k, oFraction))
+        {
+          pdDelta[i] = 0;
+        }
+        else
+        {
+          pdDelta[i] = pdError[i] *
+                       (pdDerivativeTable[k] +
+                        oFraction *
+                        (pdDerivativeTable[k + 1] - pdDerivativeTable[k]));
+        }
+      }
+      break;
+
+    case MACHINE_ACTIVATION_RATIONAL:
+      for (unsigned short i = 0; i < usLength; i++)
+      {
+        pdDelta[i] = pdError[i] *
+                     MachineScalar(rationalDerivative(
+                                   (ActivationReal)machineToDouble(pdNet[i])));
+      }
+      break;
+
+    default:
+      /* the derivative of the activation function is the activation */
+      /*     of the unit multiplied by (one minus its activation)    */
+      for (unsigned short i = 0; i < usLength; i++)
+      {
+        pdDelta[i] = pdError[i] * pdActivation[i] * (1 - pdActivation[i]);
+      }
+      break;
+  }
+}
+
+double MachineActivation::measureError(double * pdDerivativeError) const
+{
+  MachineScalar oNet, oActivation, oDelta;
+  MachineScalar oOne = 1;
+  double dWorst = 0, dWorstDerivative = 0;
+
+  for (int k = 0; k <= ERROR_SWEEP_STEPS; k++)
+  {
+    double dNet        = -ERROR_SWEEP_LIMIT +
+                         (2 * ERROR_SWEEP_LIMIT * k) / ERROR_SWEEP_STEPS;
+    double dActivation = 1 / ( 1 + exp(-1 * dNet) );
+
+    oNet = dNet;
+    activate(&oNet, &oActivation, 1);
+    delta(&oNet, &oActivation, &oOne, &oDelta, 1);
+
+    double dError = fabs(machineToDouble(oActivation) - dActivation);
+    double dDerivativeError = fabs(machineToDouble(oDelta) -
+                                   dActivation * (1 - dActivation));
+
+    if (dError > dWorst)
+    {
+      dWorst = dError;
+    }
+    if (dDerivativeError > dWorstDerivative)
+    {
+      dWorstDerivative = dDerivativeError;
+    }
+  }
+
+  if (pdDerivativeError)
+  {
+    *pdDerivativeError = dWorstDerivative;
+  }
+  return dWorst;
+}
+
+void MachineActivation::benchmark(double dLocalErrorBound)
+{
+  static MachineScalar adNet[BENCHMARK_UNITS];
+  static MachineScalar adActivation[BENCHMARK_UNITS];
+  static MachineScalar adError[BENCHMARK_UNITS];
+  static MachineScalar adDelta[BENCHMARK_UNITS];
+  static const int aiTypes[] = { MACHINE_ACTIVATION_EXACT,
+                                 MACHINE_ACTIVATION_TABLE,
+                                 MACHINE_ACTIVATION_RATIONAL };
+
+  for (int i = 0; i < BENCHMARK_UNITS; i++)
+  {
+    /* nets spread over the range a trained network produces */
+    adNet[i]   = -12.0 + (24.0 * i) / BENCHMARK_UNITS;
+    adError[i] = 0.5;
+  }
+
+  for (unsigned int t = 0; t < sizeof(aiTypes) / sizeof(aiTypes[0]); t++)
+  {
+    MachineActivation oActivation;
+    clock_t tStart;
+    double  dActivateNs, dDeltaNs, dError, dDerivativeError;
+    double  dUnits = (double)BENCHMARK_UNITS * BENCHMARK_PASSES;
+
+    oActivation.configure(aiTypes[t], dLocalErrorBound);
+
+    tStart = clock( );
+    for (int p = 0; p < BENCHMARK_PASSES; p++)
+    {
+      oActivation.activate(adNet, adActivation, BENCHMARK_UNITS);
+    }
+    dActivateNs = 1.0e9 * (clock( ) - tStart) / CLOCKS_PER_SEC / dUnits;
+
+    tStart = clock( );
+    for (int p = 0; p < BENCHMARK_PASSES; p++)
+    {
+      oActivation.delta(adNet, adActivation, adError, adDelta, BENCHMARK_UNITS);
+    }
+    dDeltaNs = 1.0e9 * (clock( ) - tStart) / CLOCKS_PER_SEC / dUnits;
+
+    dError = oActivation.measureError(&dDerivativeError);
+
+    printf("Activation %-8s (%5u entries):  %6.1f ns/unit, max error %.2e;  "
+           "derivative %6.1f ns/unit, max error %.2e\n",
+           oActivation.getName( ), oActivation.getTableLength( ),
+           dActivateNs, dError, dDeltaNs, dDerivativeError);
+  }
+}
@@ -0,0 +1,84 @@
+/***************************************************
+ *
+ * 	MachineActivation.h
+ *
+ *	unit activation (logistic sigmoid) and
+ *	its derivative:  exact (libm), an
+ *	interpolated lookup table sized from an
+ *	error bound, or a rational approximation
+ *
+ **************************************************/
+
+  #ifndef MACHINEACTIVATION_H
+  #define MACHINEACTIVATION_H 1
+
+  #include "MachineScalar.h"
+
+  /* activation types, see MachineParameters::setActivationType( ) */
+  #define MACHINE_ACTIVATION_EXACT     0
+  #define MACHINE_ACTIVATION_TABLE     1
+  #define MACHINE_ACTIVATION_RATIONAL  2
+
+  /* exact in floating point;  fixed point builds default to the table, */
+  /* which they index without any floating point arithmetic             */
+  #ifndef MACHINE_ACTIVATION_DEFAULT
+  #if MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_FIXED
+  #define MACHINE_ACTIVATION_DEFAULT  MACHINE_ACTIVATION_TABLE
+  #else
+  #define MACHINE_ACTIVATION_DEFAULT  MACHINE_ACTIVATION_EXACT
+  #endif
+  #endif
+
+  /* default accuracy budget of the lookup table:  maximum absolute  */
+  /* error of both the activation and the derivative over all nets   */
+  #define MACHINE_ACTIVATION_ERROR_BOUND  1.0e-5
+
+  class MachineActivation
+  {
+  public:
+		MachineActivation( );
+		~MachineActivation( );
+        bool configure(int iLocalType, double dLocalErrorBound);
+        void release( );
+
+        int            getType( ) const;
+        double         getErrorBound( ) const;
+        const char *   getName( ) const;
+        unsigned short getTableLength( ) const;
+
+        /* pdActivation[i] = sigmoid(pdNet[i]) */
+        void activate(const MachineScalar * pdNet, MachineScalar * pdActivation,
+                      unsigned short usLength) const;
+
+        /* pdDelta[i] = pdError[i] * sigmoid'(pdNet[i]), where the exact  */
+        /* derivative is taken from the activation as a * (1 - a)         */
+        void delta(const MachineScalar * pdNet, const MachineScalar * pdActivation,
+                   const MachineScalar * pdError, MachineScalar * pdDelta,
+                   unsigned short usLength) const;
+
+        /* maximum absolute error against the double precision sigmoid */
+        double measureError(double * pdDerivativeError) const;
+
+        /* prints ns/unit & maximum error of every activation type */
+        static void benchmark(double dLocalErrorBound);
+
+  private:
+        /* table entry k & the fraction of the way to entry k + 1 for  */
+        /* pdNet;  -1 below the table, 1 above it, else 0              */
+        int locate(const MachineScalar & oNet, unsigned short & k,
+                   MachineScalar & oFraction) const;
+
+        int             iType;
+        double          dErrorBound;
+
+        /* table spans nets of [-dTableLimit, dTableLimit] */
+        double          dTableLimit;
+        double          dTableScale;         /* entries per unit of net */
+        long            lTableLimitRaw;      /* fixed point:  Q-format   */
+        long long       llTableScaleQ16;     /*   & 16 fraction bits     */
+        unsigned short  usTableLength;
+        MachineScalar * pdSigmoidTable;
+        MachineScalar * pdDerivativeTable;
+  };
+
+  #endif  // #ifndef MACHINEACTIVATION_H
@@ -0,0 +1,424 @@
+/***************************************************
+ *
+ *  MachineCheckpoint.cpp
+ *
+ *  MachineCheckpoint class - saves & restores
+ *		the trained state of a MachineVariables
+ *		network, so start-up need not retrain
+ *		on the canned data.
+ *
+ **************************************************/
+#include "MachineCheckpoint.h"
+#include "MachineVariables.h"
+
+#define HEADER_BYTES  (4 + 2 + 2 + 4 + 8 + 24 + 8 + 4 * MACHINE_RANDOM_STATE_WORDS)
+#define CRC_BYTES     4
+
+/*------------------------------------------------------------------------
+
+  Little-endian field access, independent of the host byte order
+
+ ------------------------------------------------------------------------*/
+
+void MachineCheckpoint::putBytes(unsigned char *& pucOut,
+                                 unsigned long long ullValue, int iBytes)
+{
+  for (int i = 0; i < iBytes; i++)
+  {
+    *pucOut++ = (unsigned char)(ullValue >> (8 * i));
+  }
+}
+
+unsigned long long MachineCheckpoint::getBytes(const unsigned char *& pucIn,
+                                              int iBytes)
+{
+  unsigned long long ullValue = 0;
+
+  for (int i = 0; i < iBytes; i++)
+  {
+    ullValue |= (unsigned long long)*pucIn++ << (8 * i);
+  }
+  return ullValue;
+}
+
+/* doubles travel as their IEEE-754 bit patterns */
+void MachineCheckpoint::putDouble(unsigned char *& pucOut, double dValue)
+{
+  unsigned long long ullBits;
+
+  memcpy(&ullBits, &dValue, sizeof(ullBits));
+  putBytes(pucOut, ullBits, 8);
+}
+
+double MachineCheckpoint::getDouble(const unsigned char *& pucIn)
+{
+  unsigned long long ullBits = getBytes(pucIn, 8);
+  double dValue;
+
+  memcpy(&dValue, &ullBits, sizeof(dValue));
+  return dValue;
+}
+
+/*------------------------------------------------------------------------
+
+  MachineCheckpoint
+
+ ------------------------------------------------------------------------*/
+
+unsigned short MachineCheckpoint::getMatrices(const MachineVariables & oVars)
+{
+  return (oVars.oContextToHidden.usRows != 0) ? 3 : 2;
+}
+
+unsigned long MachineCheckpoint::matrixBytes(const MachineWeightMatrix & oMatrix,
+                                             const MachineOptimizerState & oState)
+{
+  return 4 + (2 + oState.usPlanes) * 8 *
+             (unsigned long)oMatrix.usRows * oMatrix.usColumns;
+}
+
+void MachineCheckpoint::putMatrix(unsigned char *& pucOut,
+                                  const MachineWeightMatrix & oMatrix,
+                                  const MachineOptimizerState & oState)
+{
+  putBytes(pucOut, oMatrix.usRows, 2);
+  putBytes(pucOut, oMatrix.usColumns, 2);
+
+  for (unsigned short j = 0; j < oMatrix.usRows; j++)
+  {
+    for (unsigned short i = 0; i < oMatrix.usColumns; i++)
+    {
+      putDouble(pucOut, machineToDouble(oMatrix.rowWts(j)[i]));
+    }
+  }
+
+  for (unsigned short j = 0; j < oMatrix.usRows; j++)
+  {
+    const MachineScalar * pdDeltaWts = oMatrix.DeltaWts +
+                                       (unsigned long)j * oMatrix.usStride;
+
+    for (unsigned short i = 0; i < oMatrix.usColumns; i++)
+    {
+      putDouble(pucOut, machineToDouble(pdDeltaWts[i]));
+    }
+  }
+
+  for (unsigned short p = 0; p < oState.usPlanes; p++)
+  {
+    for (unsigned short j = 0; j < oMatrix.usRows; j++)
+    {
+      const MachineScalar * pdPlane = oState.apdPlanes[p] +
+                                      (unsigned long)j * oState.usStride;
+
+      for (unsigned short i = 0; i < oMatrix.usColumns; i++)
+      {
+        putDouble(pucOut, machineToDouble(pdPlane[i]));
+      }
+    }
+  }
+}
+
+bool MachineCheckpoint::checkMatrix(const unsigned char *& pucIn,
+                                    const MachineWeightMatrix & oMatrix,
+                                    const MachineOptimizerState & oState)
+{
+  unsigned short usRows    = (unsigned short)getBytes(pucIn, 2);
+  unsigned short usColumns = (unsigned short)getBytes(pucIn, 2);
+
+  pucIn += (2 + oState.usPlanes) * 8 *
+           (unsigned long)oMatrix.usRows * oMatrix.usColumns;
+
+  return (usRows == oMatrix.usRows) && (usColumns == oMatrix.usColumns);
+}
+
+void MachineCheckpoint::getMatrix(const unsigned char *& pucIn,
+                                  MachineWeightMatrix & oMatrix,
+                                  MachineOptimizerState & oState)
+{
+  pucIn += 4;
+
+  for (unsigned short j = 0; j < oMatrix.usRows; j++)
+  {
+    for (unsigned short i = 0; i < oMatrix.usColumns; i++)
+    {
+      oMatrix.rowWts(j)[i] = getDouble(pucIn);
+    }
+  }
+
+  for (unsigned short j = 0; j < oMatrix.usRows; j++)
+  {
+    for (unsigned short i = 0; i < oMatrix.usColumns; i++)
+    {
+      oMatrix.rowDeltaWts(j)[i] = getDouble(pucIn);
+    }
+  }
+
+  for (unsigned short p = 0; p < oState.usPlanes; p++)
+  {
+    for (unsigned short j = 0; j < oMatrix.usRows; j++)
+    {
+      for (unsigned short i = 0; i < oMatrix.usColumns; i++)
+      {
+        oState.rowPlane(p, j)[i] = getDouble(pucIn);
+      }
+    }
+  }
+
+  /* derivatives of an unfinished batch are never carried over */
+  memset((void *)oMatrix.WED, 0,
+         (unsigned long)oMatrix.usRows * oMatrix.usStride * sizeof(MachineScalar));
+}
+
+unsigned long MachineCheckpoint::getSize(const MachineVariables & oVars)
+{
+  unsigned long ulBytes = HEADER_BYTES + CRC_BYTES +
+                          matrixBytes(oVars.oInputToHidden,
+                                      oVars.oInputToHiddenState) +
+                          matrixBytes(oVars.oHiddenToOutput,
+                                      oVars.oHiddenToOutputState);
+
+  if (getMatrices(oVars) == 3)
+  {
+    ulBytes += matrixBytes(oVars.oContextToHidden, oVars.oContextToHiddenState);
+  }
+
+  return ulBytes;
+}
+
+unsigned long MachineCheckpoint::save(MachineVariables & oVars,
+                                      unsigned char * pucBuffer,
+                                      unsigned long ulCapacity)
+{
+  unsigned long ulBytes = getSize(oVars);
+  unsigned long aulRandom[MACHINE_RANDOM_STATE_WORDS];
+  unsigned char * pucOut = pucBuffer;
+
+  if (!oVars.oInputToHidden.Wts)
+  {
+    /* warn that the network has not been initialized */
+    printf("Uninitialized network within MachineCheckpoint::save( )\n");
+    return 0;
+  }
+
+  if (ulCapacity < ulBytes)
+  {
+    /* warn that the buffer cannot hold the checkpoint */
+    printf("Checkpoint needs %lu bytes within MachineCheckpoint::save( )\n",
+           ulBytes);
+    return 0;
+  }
+
+  /* input columns left idle by the sparse path take their momentum first */
+  oVars.settleWeights( );
+
+  *pucOut++ = 'M';
+  *pucOut++ = 'S';
+  *pucOut++ = 'C';
+  *pucOut++ = 'K';
+  putBytes(pucOut, MACHINE_CHECKPOINT_VERSION, 2);
+  putBytes(pucOut, HEADER_BYTES, 2);
+
+  *pucOut++ = MACHINE_NUMERIC_MODE;
+  *pucOut++ = (unsigned char)oVars.oActivation.getType( );
+  *pucOut++ = (unsigned char)getMatrices(oVars);
+  *pucOut++ = (unsigned char)oVars.oOptimizer.getType( );
+
+  putBytes(pucOut, oVars.ucInputVectorLength, 2);
+  putBytes(pucOut, oVars.ucHiddenVectorLength, 2);
+  putBytes(pucOut, oVars.ucOutputVectorLength, 2);
+  putBytes(pucOut, oVars.usBatchSize, 2);
+
+  putBytes(pucOut, oVars.ulTrainingSteps, 8);
+  putBytes(pucOut, oVars.ulWeightUpdates, 8);
+  putBytes(pucOut, oVars.ulEpochs, 8);
+  putDouble(pucOut, oVars.dPerturbCurrent);
+
+  oVars.oRandom.getState(aulRandom);
+
+  for (int w = 0; w < MACHINE_RANDOM_STATE_WORDS; w++)
+  {
+    putBytes(pucOut, aulRandom[w], 4);
+  }
+
+  putMatrix(pucOut, oVars.oInputToHidden, oVars.oInputToHiddenState);
+  putMatrix(pucOut, oVars.oHiddenToOutput, oVars.oHiddenToOutputState);
+
+  if (getMatrices(oVars) == 3)
+  {
+    putMatrix(pucOut, oVars.oContextToHidden, oVars.oContextToHiddenState);
+  }
+
+  putBytes(pucOut, crc32(pucBuffer, pucOut - pucBuffer), 4);
+
+  return ulBytes;
+}
+
+bool MachineCheckpoint::load(MachineVariables & oVars,
+                             const unsigned char * pucBuffer,
+                             unsigned long ulBytes)
+{
+  unsigned long aulRandom[MACHINE_RANDOM_STATE_WORDS];
+  const unsigned char * pucIn = pucBuffer;
+
+  if (!oVars.oInputToHidden.Wts)
+  {
+    /* warn that the network has not been initialized */
+    printf("Uninitialized network within MachineCheckpoint::load( )\n");
+    return false;
+  }
+
+  if ((ulBytes != getSize(oVars)) ||
+      memcmp(pucBuffer, "MSCK", 4))
+  {
+    /* warn that this is not a checkpoint of this network */
+    printf("Checkpoint does not match the network within ");
+    printf("MachineCheckpoint::load( )\n");
+    return false;
+  }
+
+  pucIn += 4;
+
+  if ((getBytes(pucIn, 2) != MACHINE_CHECKPOINT_VERSION) ||
+      (getBytes(pucIn, 2) != HEADER_BYTES))
+  {
+    /* warn that the checkpoint was written by another version */
+    printf("Unsupported checkpoint version within MachineCheckpoint::load( )\n");
+    return false;
+  }
+
+  {
+    const unsigned char * pucCrc = pucBuffer + ulBytes - CRC_BYTES;
+
+    if (getBytes(pucCrc, 4) != crc32(pucBuffer, ulBytes - CRC_BYTES))
+    {
+      /* warn that the checkpoint is corrupt */
+      printf("Checkpoint CRC mismatch within MachineCheckpoint::load( )\n");
+      return false;
+    }
+  }
+
+  /* numeric mode & activation are informational:  weights are */
+  /* stored as doubles and convert to any MachineScalar         */
+  {
+    unsigned short usMatrices  = pucIn[2];
+    unsigned short usOptimizer = pucIn[3];
+
+    pucIn += 4;
+
+    unsigned short usInput  = (unsigned short)getBytes(pucIn, 2);
+    unsigned short usHidden = (unsigned short)getBytes(pucIn, 2);
+    unsigned short usOutput = (unsigned short)getBytes(pucIn, 2);
+
+    if ((usMatrices != getMatrices(oVars)) ||
+        (usInput  != oVars.ucInputVectorLength) ||
+        (usHidden != oVars.ucHiddenVectorLength) ||
+        (usOutput != oVars.ucOutputVectorLength))
+    {
+      /* warn that the layer sizes differ */
+      printf("Checkpoint layer sizes differ within MachineCheckpoint::load( )\n");
+      return false;
+    }
+
+    if (usOptimizer != oVars.oOptimizer.getType( ))
+    {
+      /* warn that the optimizer state belongs to another rule */
+      printf("Checkpoint optimizer differs within MachineCheckpoint::load( )\n");
+      return false;
+    }
+  }
+
+  /* every check is made before anything in oVars changes */
+  {
+    const unsigned char * pucScan = pucBuffer + HEADER_BYTES;
+    const unsigned char * pucRandom = pucBuffer + HEADER_BYTES -
+                                      4 * MACHINE_RANDOM_STATE_WORDS;
+    MachineRandom oRandom;
+
+    for (int w = 0; w < MACHINE_RANDOM_STATE_WORDS; w++)
+    {
+      aulRandom[w] = (unsigned long)getBytes(pucRandom, 4);
+    }
+
+    if (!checkMatrix(pucScan, oVars.oInputToHidden, oVars.oInputToHiddenState) ||
+        !checkMatrix(pucScan, oVars.oHiddenToOutput, oVars.oHiddenToOutputState) ||
+        ((getMatrices(oVars) == 3) &&
+         !checkMatrix(pucScan, oVars.oContextToHidden,
+                      oVars.oContextToHiddenState)) ||
+        !oRandom.setState(aulRandom))
+    {
+      /* warn that the checkpoint contents are inconsistent */
+      printf("Inconsistent checkpoint within MachineCheckpoint::load( )\n");
+      return false;
+    }
+  }
+
+  oVars.usBatchSize     = (unsigned short)getBytes(pucIn, 2);
+  oVars.ulTrainingSteps = (unsigned long)getBytes(pucIn, 8);
+  oVars.ulWeightUpdates = (unsigned long)getBytes(pucIn, 8);
+  oVars.ulEpochs        = (unsigned long)getBytes(pucIn, 8);
+  oVars.dPerturbCurrent = getDouble(pucIn);
+  oVars.oRandom.setState(aulRandom);
+  pucIn += 4 * MACHINE_RANDOM_STATE_WORDS;
+
+  getMatrix(pucIn, oVars.oInputToHidden, oVars.oInputToHiddenState);
+  getMatrix(pucIn, oVars.oHiddenToOutput, oVars.oHiddenToOutputState);
+
+  if (getMatrices(oVars) == 3)
+  {
+    getMatrix(pucIn, oVars.oContextToHidden, oVars.oContextToHiddenState);
+  }
+
+  /* every column is current, no batch is under way */
+  for (int i = 0; i <= oVars.ucInputVectorLength; i++)
+  {
+    oVars.pulColumnUpdates[i] = oVars.ulWeightUpdates;
+    oVars.pbTouched[i]        = false;
+  }
+  oVars.usTouched    = 0;
+  oVars.usBatchCount = 0;
+  oVars.EpochError   = 0;
+  oVars.resetUnits(true);
+
+  /* a recurrent sequence starts over from a cleared context */
+  if (oVars.usRecurrentWindow)
+  {
+    oVars.resetHistory( );
+  }
+
+  /* the rate schedule carries on from the saved epoch count */
+  oVars.oSchedule.resume(oVars.ulEpochs);
+  oVars.oOptimizer.setRateScale(oVars.oSchedule.getScale( ));
+
+  return true;
+}
+
+unsigned long MachineCheckpoint::crc32(const unsigned char * pucBytes,
+                                       unsigned long ulBytes)
+{
+  static unsigned long aulTable[256];
+  static bool bTable = false;
+  unsigned long ulCrc = 0xFFFFFFFFUL;
+
+  /* reflected polynomial 0xEDB88320, as used by zlib & Ethernet */
+  if (!bTable)
+  {
+    for (unsigned long n = 0; n < 256; n++)
+    {
+      unsigned long c = n;
+
+      for (int k = 0; k < 8; k++)
+      {
+        c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+      }
+      aulTable[n] = c;
+    }
+    bTable = true;
+  }
+
+  for (unsigned long n = 0; n < ulBytes; n++)
+  {
+    ulCrc = aulTable[(ulCrc ^ pucBytes[n]) & 0xFF] ^ (ulCrc >> 8);
+  }
+
+  return (ulCrc ^ 0xFFFFFFFFUL) & 0xFFFFFFFFUL;
+}
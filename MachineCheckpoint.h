@@ -0,0 +1,100 @@
+/***************************************************
+ *
+ * 	MachineCheckpoint.h
+ *
+ *	versioned binary checkpoint of a trained
+ *	network:  layer sizes, weights, momentum,
+ *	optimizer state, generator state &
+ *	training counters, all little-endian
+ *	and closed by a CRC-32
+ *
+ **************************************************/
+
+  #ifndef MACHINECHECKPOINT_H
+  #define MACHINECHECKPOINT_H 1
+
+  #include "MachineRuntime.h"
+
+  /* checkpoints are built in memory;  reading & writing them as files */
+  /* needs a file system, so by default only hosts have the file API   */
+  #ifndef MACHINE_CHECKPOINT_FILES
+  #if MACHINE_RUNTIME == MACHINE_RUNTIME_POSIX
+  #define MACHINE_CHECKPOINT_FILES 1
+  #else
+  #define MACHINE_CHECKPOINT_FILES 0
+  #endif
+  #endif
+
+  /* files loaded at start-up & written after training */
+  #ifndef MACHINE_CHECKPOINT_FILE
+  #define MACHINE_CHECKPOINT_FILE  "MachineCheckpoint.bin"
+  #endif
+  #ifndef MACHINE_MODEL_FILE
+  #define MACHINE_MODEL_FILE       "MachineModel.bin"
+  #endif
+
+  /* layout, version 1 (all fields little-endian):                    */
+  /*   "MSCK", u16 version, u16 header bytes                          */
+  /*   u8 numeric mode, u8 activation, u8 matrices, u8 optimizer      */
+  /*   u16 input, hidden & output lengths, u16 batch size             */
+  /*   u64 training steps, weight updates & epochs                    */
+  /*   f64 current perturbation amplitude                             */
+  /*   u32 x MACHINE_RANDOM_STATE_WORDS generator state               */
+  /*   per matrix:  u16 rows, u16 columns, f64 weights (row-major),   */
+  /*                f64 delta weights (row-major), then f64 planes of */
+  /*                optimizer state (row-major, none for momentum SGD, */
+  /*                so its checkpoints match those written before)     */
+  /*   u32 CRC-32 (IEEE) of every byte before it                      */
+  #define MACHINE_CHECKPOINT_VERSION  1
+
+  class MachineVariables;
+  class MachineWeightMatrix;
+  class MachineOptimizerState;
+
+  class MachineCheckpoint
+  {
+  public:
+        /* bytes save( ) writes for oVars */
+        static unsigned long getSize(const MachineVariables & oVars);
+
+        /* bytes written, or 0 when ulCapacity is too small;  weight */
+        /* error derivatives of an unfinished batch are not saved,   */
+        /* and idle input columns take their pending momentum first  */
+        static unsigned long save(MachineVariables & oVars,
+                                  unsigned char * pucBuffer,
+                                  unsigned long ulCapacity);
+
+        /* false, leaving oVars untouched, unless the checkpoint is */
+        /* intact and matches the layer sizes oVars was built with  */
+        static bool load(MachineVariables & oVars,
+                         const unsigned char * pucBuffer,
+                         unsigned long ulBytes);
+
+        static unsigned long crc32(const unsigned char * pucBytes,
+                                   unsigned long ulBytes);
+
+        /* little-endian fields of iBytes bytes, whatever the host's */
+        /* byte order & word size;  shared with the model image      */
+        static void putBytes(unsigned char *& pucOut,
+                             unsigned long long ullValue, int iBytes);
+        static unsigned long long getBytes(const unsigned char *& pucIn,
+                                           int iBytes);
+        static void putDouble(unsigned char *& pucOut, double dValue);
+        static double getDouble(const unsigned char *& pucIn);
+
+  private:
+        static unsigned short getMatrices(const MachineVariables & oVars);
+        static unsigned long matrixBytes(const MachineWeightMatrix & oMatrix,
+                                         const MachineOptimizerState & oState);
+        static void putMatrix(unsigned char *& pucOut,
+                              const MachineWeightMatrix & oMatrix,
+                              const MachineOptimizerState & oState);
+        static bool checkMatrix(const unsigned char *& pucIn,
+                                const MachineWeightMatrix & oMatrix,
+                                const MachineOptimizerState & oState);
+        static void getMatrix(const unsigned char *& pucIn,
+                              MachineWeightMatrix & oMatrix,
+                              MachineOptimizerState & oState);
+  };
+
+  #endif  // #ifndef MACHINECHECKPOINT_H
@@ -0,0 +1,85 @@
+/***************************************************
+ *
+ * 	MachineDataSet.h
+ *
+ *	built-in pattern set, folded & decoded
+ *	once into packed frames, input vectors
+ *	and target vectors in the network's
+ *	numeric type, all held contiguously
+ *
+ **************************************************/
+
+  #ifndef MACHINEDATASET_H
+  #define MACHINEDATASET_H 1
+
+  #include "MachineScalar.h"
+
+  /* Count patterns for a network of Inputs input units (bias excluded) */
+  /* & Targets output units.  Each pattern is given as usTerms bitmaps  */
+  /* ORed into one frame:  the first usFrameInputs bits are inputs, the */
+  /* targets follow directly, and input units past the frame's inputs   */
+  /* read as zero, as in MachineEngine::storePattern( ).                */
+  /* A data set defined at namespace scope is built during static       */
+  /* initialization, so nothing is folded or decoded while training    */
+  template<unsigned short Count, unsigned short Inputs, unsigned short Targets>
+  class MachineDataSet
+  {
+  public:
+        enum { COUNT = Count, INPUTS = Inputs, TARGETS = Targets };
+
+		MachineDataSet(const unsigned long * pulTerms, unsigned short usTerms,
+                       unsigned short usFrameInputs);
+
+        unsigned long getFrame(unsigned short usPattern) const
+        {
+          return aulFrames[usPattern];
+        }
+        const MachineScalar * getInputs(unsigned short usPattern) const
+        {
+          return aadInputs[usPattern];
+        }
+        const MachineScalar * getTargets(unsigned short usPattern) const
+        {
+          return aadTargets[usPattern];
+        }
+
+  private:
+        unsigned long aulFrames[Count];
+        MachineScalar aadInputs[Count][Inputs];
+        MachineScalar aadTargets[Count][Targets];
+  };
+
+  template<unsigned short Count, unsigned short Inputs, unsigned short Targets>
+  MachineDataSet<Count, Inputs, Targets>::MachineDataSet(const unsigned long * pulTerms,
+                                                         unsigned short usTerms,
+                                                         unsigned short usFrameInputs)
+  {
+    /* plain shifts rather than MachineBitDecoder, whose table may not */
+    /* be built yet while static objects are being initialized         */
+    for (unsigned short n = 0; n < Count; n++)
+    {
+      unsigned long ulFrame = 0;
+
+      for (unsigned short t = 0; t < usTerms; t++)
+      {
+        ulFrame |= pulTerms[(unsigned long)n * usTerms + t];
+      }
+
+      aulFrames[n] = ulFrame;
+
+      for (unsigned short i = 0; i < Inputs; i++)
+      {
+        aadInputs[n][i] = (i < usFrameInputs) ? (int)((ulFrame >> i) & 1) : 0;
+      }
+
+      for (unsigned short i = 0; i < Targets; i++)
+      {
+        unsigned short usBit = usFrameInputs + i;
+
+        aadTargets[n][i] = (usBit < sizeof(unsigned long) * 8) ?
+                           (int)((ulFrame >> usBit) & 1) : 0;
+      }
+    }
+  }
+
+  #endif  // #ifndef MACHINEDATASET_H
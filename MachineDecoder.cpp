@@ -0,0 +1,101 @@
+/***************************************************
+ *
+ *  MachineDecoder.cpp
+ *
+ *  MachineBitDecoder class - turns the packed
+ *		pattern bitmaps received from the
+ *		device driver into unit activations
+ *		(and decisions back into bitmaps).
+ *
+ **************************************************/
+#include "MachineDecoder.h"
+
+MachineScalar MachineBitDecoder::aadExpand[256][8];
+
+/* builds the expansion table during static initialization, so the */
+/* decode & trainer tasks only ever read it                         */
+class MachineBitDecoderTable
+{
+public:
+  MachineBitDecoderTable( )
+  {
+    for (int b = 0; b < 256; b++)
+    {
+      for (int k = 0; k < 8; k++)
+      {
+        MachineBitDecoder::aadExpand[b][k] = (b >> k) & 1;
+      }
+    }
+  }
+};
+
+static MachineBitDecoderTable oExpandTable;
+
+void MachineBitDecoder::decode(const unsigned char * pucFrame,
+                               unsigned short usFrameBytes,
+                               unsigned short usFirstBit, unsigned short usCount,
+                               MachineScalar * pdOut)
+{
+  unsigned int uiBit = usFirstBit;
+  unsigned int uiEnd = usFirstBit + usCount;
+  unsigned int uiFrameBits = usFrameBytes * 8;
+
+  /* only the part of the range inside the frame is looked up */
+  unsigned int uiStop = (uiEnd < uiFrameBits) ? uiEnd : uiFrameBits;
+
+  /* leading bits, up to a byte boundary */
+  while ((uiBit < uiStop) && (uiBit & 7))
+  {
+    *pdOut++ = aadExpand[pucFrame[uiBit >> 3]][uiBit & 7];
+    uiBit++;
+  }
+
+  /* whole bytes, eight units per lookup */
+  while (uiBit + 8 <= uiStop)
+  {
+    const MachineScalar * pdRow = aadExpand[pucFrame[uiBit >> 3]];
+
+    for (int k = 0; k < 8; k++)
+    {
+      pdOut[k] = pdRow[k];
+    }
+
+    pdOut += 8;
+    uiBit += 8;
+  }
+
+  /* trailing bits of the last byte */
+  if (uiBit < uiStop)
+  {
+    const MachineScalar * pdRow = aadExpand[pucFrame[uiBit >> 3]];
+
+    for (unsigned int k = 0; k < uiStop - uiBit; k++)
+    {
+      pdOut[k] = pdRow[k];
+    }
+
+    pdOut += uiStop - uiBit;
+    uiBit  = uiStop;
+  }
+
+  /* past the end of the frame */
+  for (; uiBit < uiEnd; uiBit++)
+  {
+    *pdOut++ = 0;
+  }
+}
+
+void MachineBitDecoder::encode(unsigned long ulBits, unsigned short usCount,
+                               unsigned short usFirstBit,
+                               unsigned char * pucFrame, unsigned short usFrameBytes)
+{
+  for (unsigned short i = 0; (i < usCount) && (i < sizeof(unsigned long) * 8); i++)
+  {
+    unsigned int uiBit = usFirstBit + i;
+
+    if ((ulBits & (1UL << i)) && (uiBit < (unsigned int)usFrameBytes * 8))
+    {
+      pucFrame[uiBit >> 3] |= (unsigned char)(1 << (uiBit & 7));
+    }
+  }
+}
@@ -0,0 +1,43 @@
+/***************************************************
+ *
+ * 	MachineDecoder.h
+ *
+ *	table-driven expansion of packed pattern
+ *	bitmaps straight into unit activations,
+ *	a byte (eight units) per table lookup
+ *
+ **************************************************/
+
+  #ifndef MACHINEDECODER_H
+  #define MACHINEDECODER_H 1
+
+  #include "MachineScalar.h"
+
+  /* bitmaps are little-endian:  bit n of a frame is bit (n % 8) of */
+  /* byte (n / 8), so frames may be any number of bytes wide        */
+  class MachineBitDecoder
+  {
+  public:
+        /* writes usCount activations (1 or 0) for bits usFirstBit    */
+        /* onward of a usFrameBytes frame;  bits past the end of the  */
+        /* frame read as 0                                             */
+        static void decode(const unsigned char * pucFrame,
+                           unsigned short usFrameBytes,
+                           unsigned short usFirstBit, unsigned short usCount,
+                           MachineScalar * pdOut);
+
+        /* sets bit usFirstBit + i of the frame for every set bit i */
+        /* of ulBits;  other bits of the frame are left alone        */
+        static void encode(unsigned long ulBits, unsigned short usCount,
+                           unsigned short usFirstBit,
+                           unsigned char * pucFrame, unsigned short usFrameBytes);
+
+  private:
+        /* aadExpand[b][k] is bit k of byte value b, as a scalar;  */
+        /* filled once, before main( ), by the constructor below    */
+        static MachineScalar aadExpand[256][8];
+
+        friend class MachineBitDecoderTable;
+  };
+
+  #endif  // #ifndef MACHINEDECODER_H
@@ -19,11 +19,37 @@
 #define COMMUNICATE_WITH_VI   0
 #define USE_CANNED_DATA       1
 
-static int uiIterationCount; 
 static bool bLocalTrain = FALSE;
 unsigned int uiPatternVectorCount;
 
 void InputOutputTask(void *);
+
+/* first 32 bits of a pattern bitmap, for trace records */
+static unsigned int frameBits(const unsigned char * pucFrame)
+{
+  unsigned int uiBits = 0;
+
+  for (int i = 0; (i < MAXIMUM_BYTES) && (i < 4); i++)
+  {
+    uiBits |= (unsigned int)pucFrame[i] << (8 * i);
+  }
+
+  return uiBits;
+}
+
+/* a frame with any target unit set carries a correction */
+static bool labelled(const MachinePattern & oPattern, unsigned short usTargets)
+{
+  for (unsigned short i = 0; (i < usTargets) && (i < MAXIMUM_STATES); i++)
+  {
+    if (machineToDouble(oPattern.adTargets[i]) != 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
 		
 /* 
  * **************************************************************************
@@ -33,7 +59,22 @@ void InputOutputTask(void *);
  * **************************************************************************
  */
  
-OS_MBOX InputMbox, IterateMbox, OutputMbox;
+/* frames by value:  I/O task -> decode stage, with a wakeup */
+MachineFrameRing InputRing;
+MachineSignal    InputSignal;
+
+/* bounded queues between the decode, compute & encode stages */
+MachineChannel<MachinePattern, PIPELINE_DEPTH> DecodedChannel;
+MachineChannel<MachineResult,  PIPELINE_DEPTH> ResultChannel;
+
+/* labelled frames:  compute stage -> online learner, with a wakeup */
+MachineRing<MachinePattern, CORRECTION_DEPTH> CorrectionRing;
+MachineSignal                                 CorrectionSignal;
+
+/* canned vectors, folded & decoded during static initialization */
+static const MachineCannedSet CannedSet(&CannedVectors[0][0], MAXIMUM_ON_BITS,
+                                        INPUT_BITS);
+
 int HostPC, DeviceDriver;
  
 
@@ -41,19 +82,58 @@ extern "C" {void UserMain(void *pd); }
 
 MachineEngine::MachineEngine( )
 {
-  bStopRequested = 0;
+  machineStoreRelease(&bStopRequested, 0);
   bInitialized = 0;
+  bModelCurrent = 0;
+#if MACHINE_FIXED_NETWORK
+  bGuidanceCurrent = false;
+#endif
+  bOnline = false;
+  ulCorrectionsQueued = 0;
+  ulCorrectionsApplied = 0;
+  ulPublishWanted = 0;
+  ulAdviceCount = 0;
+  ulTrainingCount = 0;
   poMachineParameters = NULL;
   poVars = NULL;
+  PatternInputElement = NULL;
+  PatternTargetElement = NULL;
+  CorrectionInputElement = NULL;
+  CorrectionTargetElement = NULL;
   uiPatternVectorCount = 0;
 }
 
 MachineEngine::~MachineEngine( )
 {
   stop( );
+
+  if (PatternInputElement)
+  {
+    delete [] PatternInputElement;
+  }
+
+  if (PatternTargetElement)
+  {
+    delete [] PatternTargetElement;
+  }
+
+  if (CorrectionInputElement)
+  {
+    delete [] CorrectionInputElement;
+  }
+
+  if (CorrectionTargetElement)
+  {
+    delete [] CorrectionTargetElement;
+  }
+
   bInitialized = 0;
   poMachineParameters = NULL;
   poVars = NULL;
+  PatternInputElement = NULL;
+  PatternTargetElement = NULL;
+  CorrectionInputElement = NULL;
+  CorrectionTargetElement = NULL;
   uiPatternVectorCount = 0;
 }
 
@@ -92,69 +172,103 @@ void MachineEngine::start( )
   
   if (bInitialized)
   {
+    /* frames per epoch of the stream, which also sizes whole-epoch batches */
+    unsigned short usEpochLength = poMachineParameters->getEpochLength( );
+
+    poVars->usEpochLength = usEpochLength;
+
     /* clear this flag just in case user requests a start( ) after a stop( ) */
-    bStopRequested = 0;  
+    machineStoreRelease(&bStopRequested, 0);
 
     bLocalTrain = poMachineParameters->getMachineTraining( );
 
+    /* online learning:  inference runs on the published weights while */
+    /* the learner trains the network on the corrections in idle time  */
+    bOnline = !training( ) && poMachineParameters->getOnlineLearning( );
+
+    if (bOnline)
+    {
+      double dScale = poVars->oSchedule.getScale( ) * MACHINE_ONLINE_RATE_SCALE;
+
+      poVars->oOptimizer.setRateScale(dScale);
+
+      if (!compileModel( ) || !publishWeights( ))
+      {
+        /* warn that inference carries on without learning */
+        iprintf("Unable to publish weights within MachineEngine::start( )\n");
+        bOnline = false;
+      }
+    }
+
 #if ENTRY_DEBUG
     iprintf("entering infinite loop in MachineEngine::start( )\n");
 #endif
 
-    while ( !bStopRequested )
+    while ( !machineLoadAcquire(&bStopRequested) )
     {
-      unsigned char* pmsg;
-      BYTE err;
+      MachinePattern oPattern;
+      MachineResult  oResult;
 
-      /* pend on input pattern */
-      pmsg = (unsigned char*)OSMboxPend(&InputMbox, 0, &err);
-      
-#if 1
-//#if IO_DEBUG      
-      printf("\n\nData received from device driver: \n");
-      poVars->parseInputForDisplay((unsigned char*)pmsg);
-      poVars->parseOutputForDisplay((unsigned char*)pmsg);
-      printf("\n");
-#endif
-      
-      /* parse and store the input pattern*/
-      storePattern((unsigned char *)pmsg);
+      /* compute stage:  pend on the next decoded pattern */
+      DecodedChannel.receive(oPattern);
+
+      unsigned long ulStart = MachineRuntime::microseconds( );
+
+      /* store the input pattern for the network */
+      storePattern(oPattern, PatternInputElement, PatternTargetElement);
 
       if ( training( ) )
       { 
         /* training consists of iterate( ) and train( ) cycles */
         train( );
 
-        OSMboxPost(&OutputMbox, (void *)"ACK\0");
+        oResult.bAcknowledge = true;
+        oResult.ulDecision   = 0;
       }    
       else
       {
         /* iteration consists solely of iterate( ) cycles */
-        iterate( );
-        
-        /* pend until the iteration is completed */
-        pmsg = (unsigned char*)OSMboxPend(&IterateMbox, 0, &err);
+        oResult.bAcknowledge = false;
+        oResult.ulDecision   = iterate( );
 
-#if 0
-        /* send the data (i.e., output advice) to output port */
-        OSMboxPost(&OutputMbox, (void *)pmsg);
-#endif
+        /* a frame with target bits set is a correction for the learner; */
+        /* when the learner is CORRECTION_DEPTH behind it is dropped     */
+        if (bOnline && labelled(oPattern, poVars->ucOutputVectorLength) &&
+            CorrectionRing.push(oPattern))
+        {
+          ulCorrectionsQueued++;
+          CorrectionSignal.post( );
+        }
       }
 
+      oComputeLatency.record(MachineRuntime::microseconds( ) - ulStart);
+
+      /* the reply is encoded & written by the encode stage */
+      ResultChannel.send(oResult);
+
       /* increment cycle counter */      
       uiCycleCounter++;
       
       /* compare cycle counter with number of cycles per epoch */
-      if ((uiCycleCounter % NUMBER_CANNED) == 0)
+      if ((uiCycleCounter % usEpochLength) == 0)
       {
         /* epoch is complete - provide debug information */
 #if 1
 //#if IO_DEBUG
         /* print out epoch error after network internals */
-        printf("\n\nError this epoch: %f\n\n", poVars->EpochError);
+        if (!bOnline)
+        {
+          printf("\n\nError this epoch: %f\n\n", poVars->EpochError);
+        }
+        displayPipeline( );
 #endif
 
-        /* epoch is complete - check performance */
+        /* epoch is complete - check performance;  the network belongs */
+        /* to the learner, which keeps adapting until stop( )          */
+        if (bOnline)
+        {
+          continue;
+        }
 #if 0
         if ( training( ) )
 #endif
@@ -164,11 +278,46 @@ void MachineEngine::start( )
             stop();
           }
         }
+        if ( training( ) )
+        {
+          publishWeights( );
+
+          if (!poVars->endEpoch( ))
+          {
+            /* warn that the epoch error has stopped improving */
+            printf("Training stalled after %lu epochs\n", poVars->ulEpochs);
+            stop();
+          }
+        }
+
+        MACHINE_TRACE(MACHINE_TRACE_EPOCHS, MACHINE_TRACE_EPOCH_END, 0,
+                      uiCycleCounter / usEpochLength,
+                      (float)poVars->EpochError);
+
         /* zero out error total for the epoch */
         poVars->EpochError = 0;
       }      
 
     }  /* end while() */
+
+    if ( training( ) )
+    {
+      /* readers get the weights as training left them */
+      publishWeights( );
+    }
+
+    if (bOnline)
+    {
+      /* the network is the learner's until its queue is worked off */
+      while (machineLoadAcquire(&ulCorrectionsApplied) != ulCorrectionsQueued)
+      {
+        MachineRuntime::delay(1);
+      }
+
+      poVars->oOptimizer.setRateScale(poVars->oSchedule.getScale( ));
+      poVars->EpochError = 0;
+      bOnline = false;
+    }
   }  /* end if( ) */
   else
   {
@@ -181,7 +330,7 @@ void MachineEngine::stop( )
 #if ENTRY_DEBUG
   iprintf("MachineEngine::stop( ) entry point\n");
 #endif
-  bStopRequested = 1;  
+  machineStoreRelease(&bStopRequested, 1);
 }
 
 void MachineEngine::initialize( )
@@ -192,7 +341,8 @@ void MachineEngine::initialize( )
 
   if (!bInitialized)
   {
-    uiIterationCount = 0;
+    ulAdviceCount   = 0;
+    ulTrainingCount = 0;
     
     poVars = new MachineVariables( );
 
@@ -206,17 +356,64 @@ void MachineEngine::initialize( )
         {
           poVars->ucInputVectorLength  = 
                     poMachineParameters->getInputVectorLength( );
+          poVars->ucHiddenVectorLength = 
+                    poMachineParameters->getHiddenVectorLength( );
           poVars->ucOutputVectorLength = 
                     poMachineParameters->getOutputVectorLength( );
-          poVars->ucHiddenVectorLength = 
-                    ((poVars->ucInputVectorLength * HIDDEN_LENGTH_MULTIPLIER) / 
-                                                   HIDDEN_LENGTH_DIVISOR);
         }
+        poVars->iKernelType = poMachineParameters->getKernelType( );
+        poVars->iActivationType = poMachineParameters->getActivationType( );
+        poVars->dActivationErrorBound =
+                  poMachineParameters->getActivationErrorBound( );
+        poVars->ulRandomSeed      = poMachineParameters->getRandomSeed( );
+        poVars->iPerturbMode      = poMachineParameters->getPerturbationMode( );
+        poVars->ulPerturbInterval = poMachineParameters->getPerturbationInterval( );
+        poVars->dPerturbAmplitude = poMachineParameters->getPerturbationAmplitude( );
+        poVars->dPerturbDecay     = poMachineParameters->getPerturbationDecay( );
+        poVars->usBatchSize       = poMachineParameters->getBatchSize( );
+        poVars->usEpochLength     = poMachineParameters->getEpochLength( );
+        poVars->usRecurrentWindow = poMachineParameters->getRecurrentWindow( );
+        poVars->iOptimizerType    = poMachineParameters->getOptimizerType( );
+        poVars->oSchedule.configure(poMachineParameters->getScheduleMode( ),
+                                    poMachineParameters->getSchedulePeriod( ),
+                                    poMachineParameters->getScheduleFactor( ),
+                                    poMachineParameters->getScheduleMinimum( ));
+        poVars->oSchedule.setPlateau(poMachineParameters->getPlateauPatience( ),
+                                     poMachineParameters->getPlateauDelta( ),
+                                     poMachineParameters->getPlateauStall( ));
         poVars->initialize( );
 
+        /* pattern elements are sized to the network, not the bitmap */
+        PatternInputElement  = new MachineScalar[poVars->ucInputVectorLength + 1];
+        PatternTargetElement = new MachineScalar[poVars->ucOutputVectorLength + 1];
+        CorrectionInputElement  = new MachineScalar[poVars->ucInputVectorLength + 1];
+        CorrectionTargetElement = new MachineScalar[poVars->ucOutputVectorLength + 1];
+
+        for (int i = 0; i <= poVars->ucInputVectorLength; i++)
+        {
+          PatternInputElement[i]    = 0.0;
+          CorrectionInputElement[i] = 0.0;
+        }
+        for (int i = 0; i <= poVars->ucOutputVectorLength; i++)
+        {
+          PatternTargetElement[i]    = 0.0;
+          CorrectionTargetElement[i] = 0.0;
+        }
+
+        if ((poVars->ucInputVectorLength - 1 + poVars->ucOutputVectorLength) >
+                                                              MAXIMUM_STATES)
+        {
+          /* warn that the bitmap cannot carry every unit of the network */
+          iprintf("Network exceeds the %d-bit pattern bitmap, ", MAXIMUM_STATES);
+          iprintf("extra units will read as zero\n");
+        }
+
         initializeRTOS();
   
         bInitialized = 1;
+
+        /* readers may advise on the initial weights straight away */
+        publishWeights( );
       }
       else
       {
@@ -250,9 +447,7 @@ void MachineEngine::display( )
 #ifdef UCOS_STACK_CHECK  
     iprintf("\nThese are our tasks: \n\n");
     
-    OSDumpTCBStacks();
-    
-    OSDumpTasks();
+    MachineRuntime::dumpTasks( );
 #endif
     if (poVars)
     {
@@ -273,80 +468,433 @@ void MachineEngine::display( )
   }
 }
 
-void MachineEngine::iterate( )
+const MachineModel * MachineEngine::compileModel( )
+{
+  if (!bInitialized)
+  {
+    /* warn that the machine has not been configured */
+    iprintf("Uninitialized system within MachineEngine::compileModel( )\n");
+    return NULL;
+  }
+
+  if (!bModelCurrent)
+  {
+    if (!oModel.compile(*poVars) || !oContext.configure(oModel))
+    {
+      return NULL;
+    }
+    bModelCurrent = 1;
+
+#if MACHINE_FIXED_NETWORK
+    /* the fixed network takes feed-forward, exact activation models */
+    bGuidanceCurrent = MachineGuidanceNetwork::fits(oModel) &&
+                       oGuidanceNetwork.load(oModel);
+#endif
+  }
+
+  return &oModel;
+}
+
+bool MachineEngine::iterateBatch(const unsigned char * pucFrames,
+                                 unsigned short usFrameBytes,
+                                 unsigned short usCount,
+                                 unsigned char * pucOutputFrames)
+{
+#if ENTRY_DEBUG
+  iprintf("MachineEngine::iterateBatch( ) entry point\n");
+#endif
+  if (!compileModel( ))
+  {
+    /* warn that no model could be compiled from the network */
+    iprintf("Unable to compile model within MachineEngine::iterateBatch( )\n");
+    return false;
+  }
+
+  /* batch storage is kept between calls, grown only as needed */
+  if (!oBatch.matches(oModel) || (oBatch.getCapacity( ) < usCount))
+  {
+    if (!oBatch.configure(oModel, usCount))
+    {
+      return false;
+    }
+  }
+
+  if (!oBatch.loadFrames(pucFrames, usFrameBytes, usCount,
+                         poVars->ucInputVectorLength - 1) ||
+      !oModel.evaluateBatch(oBatch, usCount))
+  {
+    return false;
+  }
+
+  /* winning output i read as bit (INPUT_BITS + i) of the frame */
+  oModel.decideBatch(oBatch, usCount, INPUT_BITS, pucOutputFrames, usFrameBytes);
+  ulAdviceCount += usCount;
+
+  return true;
+}
+
+#if MACHINE_HOST_TRAINER
+double MachineEngine::trainParallel(const unsigned char * pucFrames,
+                                    unsigned short usFrameBytes,
+                                    unsigned short usCount,
+                                    unsigned short usThreads)
+{
+#if ENTRY_DEBUG
+  iprintf("MachineEngine::trainParallel( ) entry point\n");
+#endif
+  if (!bInitialized)
+  {
+    /* warn that the machine has not been configured */
+    iprintf("Uninitialized system within MachineEngine::trainParallel( )\n");
+    return 0;
+  }
+
+  /* the thread pool is kept between passes */
+  if (!oTrainer.getThreads( ) ||
+      ((oTrainer.getThreads( ) != usThreads) && usThreads &&
+       (usThreads <= MACHINE_TRAINER_MAX_THREADS)))
+  {
+    if (!oTrainer.configure(poVars, usThreads))
+    {
+      return 0;
+    }
+  }
+
+  double dError = oTrainer.trainEpoch(pucFrames, usFrameBytes, usCount);
+
+  /* the compiled model no longer matches the weights */
+  bModelCurrent = 0;
+  publishWeights( );
+
+  return dError;
+}
+#endif
+
+unsigned long MachineEngine::getCheckpointSize( )
+{
+  if (!bInitialized)
+  {
+    /* warn that the machine has not been configured */
+    iprintf("Uninitialized system within MachineEngine::getCheckpointSize( )\n");
+    return 0;
+  }
+
+  return MachineCheckpoint::getSize(*poVars);
+}
+
+unsigned long MachineEngine::saveCheckpoint(unsigned char * pucBuffer,
+                                            unsigned long ulCapacity)
+{
+  if (!bInitialized)
+  {
+    /* warn that the machine has not been configured */
+    iprintf("Uninitialized system within MachineEngine::saveCheckpoint( )\n");
+    return 0;
+  }
+
+  return MachineCheckpoint::save(*poVars, pucBuffer, ulCapacity);
+}
+
+bool MachineEngine::loadCheckpoint(const unsigned char * pucBuffer,
+                                   unsigned long ulBytes)
+{
+  if (!bInitialized)
+  {
+    /* warn that the machine has not been configured */
+    iprintf("Uninitialized system within MachineEngine::loadCheckpoint( )\n");
+    return false;
+  }
+
+  if (!MachineCheckpoint::load(*poVars, pucBuffer, ulBytes))
+  {
+    return false;
+  }
+
+  /* the compiled model no longer matches the weights */
+  bModelCurrent = 0;
+
+  return publishWeights( );
+}
+
+#if MACHINE_CHECKPOINT_FILES
+/* writes pcPath.tmp, then renames it over pcPath, so readers (and */
+/* processes mapping the file) see either the old file or the new  */
+static bool replaceFile(const char * pcPath, const unsigned char * pucBytes,
+                        unsigned long ulBytes)
+{
+  char acTemporary[256];
+  FILE * pFile;
+  bool bSaved;
+
+  if (snprintf(acTemporary, sizeof(acTemporary), "%s.tmp", pcPath) >=
+      (int)sizeof(acTemporary))
+  {
+    return false;
+  }
+
+  pFile = fopen(acTemporary, "wb");
+
+  if (!pFile)
+  {
+    return false;
+  }
+
+  bSaved = (fwrite(pucBytes, 1, ulBytes, pFile) == ulBytes);
+  bSaved = (fclose(pFile) == 0) && bSaved;
+  bSaved = bSaved && (rename(acTemporary, pcPath) == 0);
+
+  if (!bSaved)
+  {
+    remove(acTemporary);
+  }
+
+  return bSaved;
+}
+
+bool MachineEngine::saveCheckpointFile(const char * pcPath)
+{
+  unsigned long ulBytes = getCheckpointSize( );
+  unsigned char * pucBuffer;
+  bool bSaved = false;
+
+  if (!ulBytes)
+  {
+    return false;
+  }
+
+  pucBuffer = new unsigned char[ulBytes];
+
+  if (saveCheckpoint(pucBuffer, ulBytes) == ulBytes)
+  {
+    bSaved = replaceFile(pcPath, pucBuffer, ulBytes);
+  }
+
+  delete [] pucBuffer;
+
+  if (!bSaved)
+  {
+    /* warn that the checkpoint could not be written */
+    printf("Unable to write %s within MachineEngine::saveCheckpointFile( )\n",
+           pcPath);
+  }
+
+  return bSaved;
+}
+
+bool MachineEngine::loadCheckpointFile(const char * pcPath)
+{
+  unsigned long ulBytes = getCheckpointSize( );
+  unsigned char * pucBuffer;
+  bool bLoaded = false;
+  FILE * pFile;
+
+  if (!ulBytes)
+  {
+    return false;
+  }
+
+  pFile = fopen(pcPath, "rb");
+
+  if (!pFile)
+  {
+    /* no checkpoint yet is not an error */
+    return false;
+  }
+
+  /* one byte more than expected, so longer files are caught */
+  pucBuffer = new unsigned char[ulBytes + 1];
+
+  unsigned long ulRead = fread(pucBuffer, 1, ulBytes + 1, pFile);
+  fclose(pFile);
+
+  bLoaded = loadCheckpoint(pucBuffer, ulRead);
+
+  delete [] pucBuffer;
+
+  return bLoaded;
+}
+
+bool MachineEngine::saveModelFile(const char * pcPath)
+{
+  const MachineModel * poModel = compileModel( );
+  unsigned long ulBytes;
+  unsigned char * pucBuffer;
+  bool bSaved = false;
+
+  if (!poModel)
+  {
+    return false;
+  }
+
+  ulBytes   = poModel->getImageSize( );
+  pucBuffer = new unsigned char[ulBytes];
+
+  if (poModel->saveImage(pucBuffer, ulBytes) == ulBytes)
+  {
+    bSaved = replaceFile(pcPath, pucBuffer, ulBytes);
+  }
+
+  delete [] pucBuffer;
+
+  if (!bSaved)
+  {
+    /* warn that the model image could not be written */
+    printf("Unable to write %s within MachineEngine::saveModelFile( )\n",
+           pcPath);
+  }
+
+  return bSaved;
+}
+
+bool MachineEngine::mapModelFile(const char * pcPath)
+{
+  if (!bInitialized)
+  {
+    /* warn that the machine has not been configured */
+    iprintf("Uninitialized system within MachineEngine::mapModelFile( )\n");
+    return false;
+  }
+
+  /* the model may still point into the previous mapping */
+  oModel.release( );
+  bModelCurrent = 0;
+
+  if (!oModelMapping.map(pcPath))
+  {
+    return false;
+  }
+
+  if (!oModel.attach(oModelMapping.getBytes( ), oModelMapping.getSize( ),
+                     poVars->poKernels->iType))
+  {
+    /* warn that the image does not fit this engine */
+    printf("Unable to use %s within MachineEngine::mapModelFile( )\n", pcPath);
+    oModel.release( );
+    oModelMapping.unmap( );
+    return false;
+  }
+
+  if (!oModel.matches(*poVars) || !oContext.configure(oModel))
+  {
+    /* warn that the image was written for another network shape or */
+    /* activation, e.g. a stale image left by an earlier build       */
+    printf("Model image differs from the network within ");
+    printf("MachineEngine::mapModelFile( )\n");
+    oModel.release( );
+    oModelMapping.unmap( );
+    return false;
+  }
+
+  /* evaluated in place until training changes the weights;  the  */
+  /* fixed network would copy the shared pages into this process   */
+  bModelCurrent = 1;
+
+#if MACHINE_FIXED_NETWORK
+  bGuidanceCurrent = false;
+#endif
+
+  return true;
+}
+#endif
+
+unsigned long MachineEngine::iterate( )
 {
+  unsigned long ulDecision = 0;
+
 #if ENTRY_DEBUG
   iprintf("MachineEngine::iterate( ) entry point\n");
 #endif
   if (bInitialized)
   {
+    const MachineModel * poModel;
+#if MACHINE_FIXED_NETWORK
+    const MachineGuidanceNetwork * poNetwork;
+#endif
+
+    if (bOnline)
+    {
+      /* the weights last published by the learner, held until done */
+      const MachineWeightSet & oSet = oWeightSets.pin(COMPUTE_READER);
+
+      poModel = &oSet.oModel;
+#if MACHINE_FIXED_NETWORK
+      poNetwork = NULL;
+#endif
+    }
+    else
+    {
+      if (!compileModel( ))
+      {
+        /* warn that no model could be compiled from the network */
+        iprintf("Unable to compile model within MachineEngine::iterate( )\n");
+        return 0;
+      }
+
+      poModel = &oModel;
+#if MACHINE_FIXED_NETWORK
+      poNetwork = bGuidanceCurrent ? &oGuidanceNetwork : NULL;
+#endif
+    }
+
+    MachineScalar * pdInputs = oContext.getInputs( );
+
     /* set input unit activation based on test data */
-    for (int i = 1; i <= poVars->ucInputVectorLength; i++)
+    for (int i = 0; i < poModel->getInputLength( ); i++)
     {
-      poVars->oInputLayer[i].Activation = PatternInputElement[i-1];
+      pdInputs[i] = PatternInputElement[i];
 
 #if IO_DEBUG
-      printf("Input #%i: %f\n", i, poVars->oInputLayer[i].Activation);
+      printf("Input #%i: %f\n", i + 1, machineToDouble(pdInputs[i]));
 #endif    
     }
     
-    poVars->iterate( );
-    uiIterationCount++;
+    const MachineScalar * pdOutputs;
 
-    for (int i=0; i < poVars->ucOutputVectorLength; i++)
-    {
-      printf("Output (network) #%i: %f\n", i, 
-              poVars->oOutputLayer[i].Activation);
-    }
-    
-    /* cleanup data structures at end of iteration */
-    poVars->endOfIteration();
+#if MACHINE_FIXED_NETWORK
+    MachineScalar adOutputs[OUTPUT_BITS];
 
-    for (int i=0; i < poVars->ucOutputVectorLength; i++)
+    if (poNetwork)
     {
-      printf("Output (network) #%i: %f\n", i, 
-              poVars->oOutputLayer[i].Activation);
+      /* same outputs, from the compile-time sized network */
+      poNetwork->evaluate(pdInputs, adOutputs);
+      pdOutputs = adOutputs;
     }
-    
-#if 0    
-    OSMboxPost(&IterateMbox, (void *)"IMP\0");
-#else
-    unsigned long ulTempPattern = 0x00000000;
-    unsigned char temp_data[MAXIMUM_BYTES];
-    
-    for (int i=0; i < MAXIMUM_BYTES; i++)
+    else
+#endif
     {
-      temp_data[i] = 0x00;
+      poModel->evaluate(oContext);
+      pdOutputs = oContext.getOutputs( );
     }
-    
-    for (int i=0; i < poVars->ucOutputVectorLength; i++)
+    ulAdviceCount++;
+
+    for (int i=0; i < poModel->getOutputLength( ); i++)
     {
-      if (poVars->oOutputLayer[i].Activation == 1)
-      {
-        ulTempPattern = ulTempPattern | (1 << (INPUT_BITS + i));
-      }
+#if IO_DEBUG
+      printf("Output (network) #%i: %f\n", i, 
+              machineToDouble(pdOutputs[i]));
+#endif
+      MACHINE_TRACE(MACHINE_TRACE_UNITS, MACHINE_TRACE_OUTPUT, i, 0,
+                    (float)machineToDouble(pdOutputs[i]));
     }
     
-    for (int i=0; i < MAXIMUM_BYTES; i++)
+    /* winning velocity & steering outputs read as 1 */
+    ulDecision = poModel->decideOutputs(pdOutputs);
+
+    if (bOnline)
     {
-      temp_data[i] = 0xFF & ulTempPattern;
-      ulTempPattern = ulTempPattern >> 8;
+      oWeightSets.unpin(COMPUTE_READER);
     }
-    
-    /* notify the task scheduler that we are done with the data structures */
-    OSMboxPost(&IterateMbox, (void*)temp_data);
-    
-    /* send the data (i.e., output advice) to output port */
-    OSMboxPost(&OutputMbox, (void *)temp_data);
-#endif
 
+    MACHINE_TRACE(MACHINE_TRACE_FORWARD, MACHINE_TRACE_FORWARD_DONE, 0,
+                  (unsigned int)ulDecision, 0.0f);
+    
 #if 0
     unsigned long ulOutputPattern = 0x00000000;
 
     /* transform network output to binary format for device driver */
     for (int i=0; i < poVars->ucOutputVectorLength; i++)
     {
-      if (poVars->oOutputLayer[i].Activation > UNIT_ACTIVATION_THRESHOLD)
+      if (pdOutputs[i] > UNIT_ACTIVATION_THRESHOLD)
       {
         ulOutputPattern = ulOutputPattern | (unsigned long)(1 << (1*i));
       }  
@@ -356,10 +904,78 @@ void MachineEngine::iterate( )
 #endif
     
 #if IO_DEBUG
-    printf("\nIteration cycle #%ld\n", uiIterationCount);
+    printf("\nIteration cycle #%lu\n", ulAdviceCount);
     display();
 #endif
   }
+
+  /* the output advice is encoded for the device driver by encodeResult( ) */
+  return ulDecision;
+}
+
+bool MachineEngine::trainCanned(unsigned short usMaximumEpochs)
+{
+#if ENTRY_DEBUG
+  iprintf("MachineEngine::trainCanned( ) entry point\n");
+#endif
+
+  if (!bInitialized)
+  {
+    /* warn that the machine has not been configured */
+    iprintf("Uninitialized system within MachineEngine::trainCanned( )\n");
+    return false;
+  }
+
+  if ((poVars->ucInputVectorLength  != MachineCannedSet::INPUTS) ||
+      (poVars->ucOutputVectorLength != MachineCannedSet::TARGETS))
+  {
+    /* warn that the canned vectors do not fit the network */
+    iprintf("Network shape differs within MachineEngine::trainCanned( )\n");
+    return false;
+  }
+
+  /* whole-epoch batches span the canned set */
+  poVars->usEpochLength = MachineCannedSet::COUNT;
+
+  for (unsigned short e = 0; e < usMaximumEpochs; e++)
+  {
+    /* the same patterns, in the same order, as the canned I/O task */
+    for (unsigned short n = 0; n < NUMBER_CANNED; n++)
+    {
+      trainPattern(CannedSet.getInputs(n), CannedSet.getTargets(n));
+    }
+
+    printf("\n\nError this epoch: %f\n\n", poVars->EpochError);
+    bool bProgress = poVars->endEpoch( );
+
+    publishWeights( );
+
+    MACHINE_TRACE(MACHINE_TRACE_EPOCHS, MACHINE_TRACE_EPOCH_END, 0,
+                  (unsigned int)poVars->ulEpochs, (float)poVars->EpochError);
+
+    if (poVars->EpochError < EPOCH_ERROR_THRESHOLD)
+    {
+      poVars->EpochError = 0;
+      return true;
+    }
+
+    /* zero out error total for the epoch */
+    poVars->EpochError = 0;
+
+    if (!bProgress)
+    {
+      /* warn that the epoch error has stopped improving */
+      printf("Training stalled after %lu epochs\n", poVars->ulEpochs);
+      return false;
+    }
+  }
+
+  return false;
+}
+
+bool MachineEngine::stalled( )
+{
+  return bInitialized && poVars->oSchedule.isStalled( );
 }
 
 void MachineEngine::train( )
@@ -370,131 +986,219 @@ void MachineEngine::train( )
 
   if (bInitialized)
   {
-    /* set input unit activation based on test data */
-    for (int i = 1; i <= poVars->ucInputVectorLength; i++)
-    {
-      poVars->oInputLayer[i].Activation = PatternInputElement[i-1];
+    trainPattern(PatternInputElement, PatternTargetElement);
+  }
+}
+
+void MachineEngine::trainPattern(const MachineScalar * pdInputs,
+                                 const MachineScalar * pdTargets)
+{
+  /* set input unit activation based on test data */
+  for (int i = 1; i <= poVars->ucInputVectorLength; i++)
+  {
+    poVars->oInputUnits.Activation[i] = pdInputs[i-1];
 
 #if IO_DEBUG
-      printf("Input (network) #%i: %f\n", i, poVars->oInputLayer[i].Activation);
+    printf("Input (network) #%i: %f\n", i,
+           machineToDouble(poVars->oInputUnits.Activation[i]));
 #endif    
-    }
-    
-    poVars->iterate( );
-    uiIterationCount++;
+  }
+  
+  poVars->iterate( );
+  ulTrainingCount++;
 
-    /* set output unit error based on difference */
-    /* between target and actual output values   */      
-    
-    /* the only reason we are doing this here */
-    /* (and not in MachineVariables class)    */
-    /* is that this class is currently the    */
-    /* only place we store the train pattern  */
-    /* target outputs;  eventually, this      */
-    /* may best be relayed to the Machine     */
-    /* Variables class directly, and this     */
-    /* computation can be pushed to the       */
-    /* MachineVariables class as well.        */
-    for (int i = 0; i < poVars->ucOutputVectorLength; i++)
-    {
-      double localUnitError = PatternTargetElement[i] - 
-                              poVars->oOutputLayer[i].Activation;
+  /* set output unit error based on difference */
+  /* between target and actual output values   */      
+  
+  /* the only reason we are doing this here */
+  /* (and not in MachineVariables class)    */
+  /* is that this class is currently the    */
+  /* only place we store the train pattern  */
+  /* target outputs;  eventually, this      */
+  /* may best be relayed to the Machine     */
+  /* Variables class directly, and this     */
+  /* computation can be pushed to the       */
+  /* MachineVariables class as well.        */
+  for (int i = 0; i < poVars->ucOutputVectorLength; i++)
+  {
+    MachineScalar localUnitError = pdTargets[i] - 
+                                   poVars->oOutputUnits.Activation[i];
 
-//#if IO_DEBUG
-#if 1
-      printf("Output (network) #%i: %f\n", i, 
-              poVars->oOutputLayer[i].Activation);
+#if IO_DEBUG
+    printf("Output (network) #%i: %f\n", i, 
+            machineToDouble(poVars->oOutputUnits.Activation[i]));
 #endif                              
+    MACHINE_TRACE(MACHINE_TRACE_ERRORS, MACHINE_TRACE_ERROR, i, 0,
+                  (float)machineToDouble(localUnitError));
 
-      poVars->oOutputLayer[i].Error = localUnitError;
-      poVars->EpochError           += fabs(localUnitError);
-    }
+    poVars->oOutputUnits.Error[i] = localUnitError;
+    poVars->EpochError           += fabs(machineToDouble(localUnitError));
+  }
+
+  poVars->train( );
 
-    poVars->train( );
+  /* the compiled model no longer matches the weights */
+  bModelCurrent = 0;
+
+  /* readers move on to the new weights once the batch is applied;  */
+  /* outside online learning, only while one of them is waiting, and */
+  /* at the end of each epoch                                        */
+  if ((poVars->usBatchCount == 0) &&
+      (bOnline || machineLoadAcquire(&ulPublishWanted)))
+  {
+    machineStoreRelease(&ulPublishWanted, 0);
+    publishWeights( );
   }
 }
 
 
-void MachineEngine::storePattern(unsigned char* DataVector)
+void MachineEngine::decodePattern(const unsigned char* DataVector,
+                                  MachinePattern & oPattern)
 {
 /* AT THIS POINT, WE MUST TRANSFORM THE 
-                                     10-byte representation of TrainVector 
+                                     MAXIMUM_BYTES representation of the frame
 
    TO THE                                        
-                                     40-bit representation required by the 
-                                     PatternInputElement data structure 
+                                     one activation per input unit required 
+                                     by the PatternInputElement data structure 
    AND THE                                      
-                                     14-bit representation required by the 
-                                     PatternTargetElement data structure */
+                                     one activation per output unit required 
+                                     by the PatternTargetElement data structure */
 
-  unsigned int uiSourceIndex = 0;
-  unsigned int uiDestinationIndex = 0;
+  /* inputs are the low bits of the frame, targets follow directly; */
+  /* units beyond the bitmap read as zero                            */
+  unsigned short usInputs  = poVars->ucInputVectorLength - 1;
+  unsigned short usTargets = poVars->ucOutputVectorLength;
 
-  unsigned long ulPattern = 0x00000000;
-  
-  for (int i=0; i < MAXIMUM_BYTES; i++)
+  if (usInputs > MAXIMUM_STATES)
+  {
+    usInputs = MAXIMUM_STATES;
+  }
+  if (usTargets > MAXIMUM_STATES)
   {
-    ulPattern = (unsigned long)ulPattern | (DataVector[uiSourceIndex] << (8*i));
+    usTargets = MAXIMUM_STATES;
+  }
+
+  memcpy(oPattern.aucFrame, DataVector, MAXIMUM_BYTES);
+
+  MachineBitDecoder::decode(DataVector, MAXIMUM_BYTES, 0, usInputs,
+                            oPattern.adInputs);
+  MachineBitDecoder::decode(DataVector, MAXIMUM_BYTES,
+                            poVars->ucInputVectorLength - 1, usTargets,
+                            oPattern.adTargets);
 
 #if IO_DEBUG
-    printf("Input Element #%i:\n", i);
+  for (int i=0; i < usInputs; i++)
+  {
+    /* post the input (training) vector to the debug port */
+    printf("Input (canned)  #%i: %i\n", i,
+           (int)machineToDouble(oPattern.adInputs[i]));
+  }
+#endif                                       
+
+#if IO_DEBUG
+  for (int i=0; i < usTargets; i++)
+  {
     /* post the target (training) vector to the debug port */
-    printf("  SOURCE data: 0x%x\n", (unsigned int)DataVector[uiSourceIndex]);
+    printf("Output (canned)  #%i: 0x%x\n", i,
+           (unsigned int)machineToDouble(oPattern.adTargets[i]));
+  }
 #endif
 
-    uiSourceIndex++;
+  MACHINE_TRACE(MACHINE_TRACE_FRAMES, MACHINE_TRACE_FRAME_DECODED, 0,
+                frameBits(DataVector), 0.0f);
+}
+
+void MachineEngine::storePattern(const MachinePattern & oPattern,
+                                 MachineScalar * pdInputs,
+                                 MachineScalar * pdTargets)
+{
+  for (int i=0; i < (poVars->ucInputVectorLength - 1); i++)
+  {
+    pdInputs[i] = (i < MAXIMUM_STATES) ? oPattern.adInputs[i] : 0.0;
+  }
+
+  for (int i=0; i < poVars->ucOutputVectorLength; i++)
+  {
+    pdTargets[i] = (i < MAXIMUM_STATES) ? oPattern.adTargets[i] : 0.0;
   }
+}
 
+void MachineEngine::encodeResult(const MachineResult & oResult,
+                                 MachineFrame & oFrame)
+{
+  unsigned char * temp_data = oFrame.aucBytes;
 
-  for (int i=0; i < (poVars->ucInputVectorLength - 1); i++)
+  memset(temp_data, 0, MAXIMUM_BYTES);
+
+  if (oResult.bAcknowledge)
   {
-    unsigned long ulTempElement = 0x00000000;
-    ulTempElement = ulTempElement | 
-                     (unsigned long)(1 << (1 * uiDestinationIndex));
+    temp_data[0] = 'A';
+    temp_data[1] = 'C';
+    temp_data[2] = 'K';
+    return;
+  }
 
-    if (ulPattern & ulTempElement)
-    {
-      PatternInputElement[i] = 1;
-    }
-    else
-    {
-      PatternInputElement[i] = 0;
-    }
+  /* winning output i is bit (INPUT_BITS + i) of the frame */
+  MachineBitDecoder::encode(oResult.ulDecision, poVars->ucOutputVectorLength,
+                            INPUT_BITS, temp_data, MAXIMUM_BYTES);
+}
 
-#if IO_DEBUG
-    /* post the input (training) vector to the debug port */
-    printf("Input (canned)  #%i: 0x%x\n", i, PatternInputElement[i]);
-#endif                                       
 
-    uiDestinationIndex++;
+bool MachineEngine::training( )
+{
+  return bLocalTrain;
+}
+
+const MachineModel * MachineEngine::pinModel(unsigned short usReader)
+{
+  if ((usReader == COMPUTE_READER) || (usReader >= MACHINE_WEIGHT_READERS))
+  {
+    /* warn that the reader number is not one for pinModel( ) */
+    iprintf("Invalid reader %u within MachineEngine::pinModel( )\n", usReader);
+    return NULL;
   }
 
-  for (int i=0; i < poVars->ucOutputVectorLength; i++)
+  if (!oWeightSets.getVersion( ))
   {
-    unsigned long ulTempElement = 0x00000000;
-    ulTempElement = ulTempElement |  
-                     (unsigned long)(1 << (1 * uiDestinationIndex));
-    if (ulPattern & ulTempElement)
-    {
-      PatternTargetElement[i] = 1;
-    }
-    else
-    {
-      PatternTargetElement[i] = 0;
-    }
-#if 1
-//#if IO_DEBUG
-    /* post the target (training) vector to the debug port */
-    printf("Output (canned)  #%i: 0x%x\n", i, PatternTargetElement[i]);
-#endif
+    return NULL;
+  }
 
-    uiDestinationIndex++;
+  /* asks training for the weights of the next batch boundary */
+  machineStoreRelease(&ulPublishWanted, 1);
+
+  return &oWeightSets.pin(usReader).oModel;
+}
+
+void MachineEngine::releaseModel(unsigned short usReader)
+{
+  if ((usReader != COMPUTE_READER) && (usReader < MACHINE_WEIGHT_READERS))
+  {
+    oWeightSets.unpin(usReader);
   }
 }
 
-bool MachineEngine::training( )
+unsigned long MachineEngine::getModelVersion( )
 {
-  return bLocalTrain;
+  return oWeightSets.getVersion( );
+}
+
+bool MachineEngine::publishWeights( )
+{
+  /* the shadow is never pinned, so training does not wait on readers */
+  MachineWeightSet & oSet = oWeightSets.getShadow( );
+
+  if (!oSet.oModel.compile(*poVars))
+  {
+    /* warn that readers keep the weights published last */
+    iprintf("Unable to publish weights within ");
+    iprintf("MachineEngine::publishWeights( )\n");
+    return false;
+  }
+
+  oWeightSets.publish( );
+
+  return true;
 }
  
 void MachineEngine::initializeRTOS( )
@@ -503,26 +1207,166 @@ void MachineEngine::initializeRTOS( )
   iprintf("MachineEngine::initializeRTOS( ) entry point\n");
 #endif
 
-  SerialClose( 1 );
-  DeviceDriver = OpenSerial( 1, 115200, 2, 8, eParityNone );
+  iprintf("Runtime:  %s\n", MachineRuntime::getName( ));
+
+  DeviceDriver = MachineRuntime::openSerial( 1, 115200 );
   write( DeviceDriver, "Hello Device Driver\0", 20 );
 
-  /* Initialize Input, Iterate, & Train mailboxes */
-  OSMboxInit(&InputMbox,   NULL);
-  OSMboxInit(&IterateMbox, NULL);
-  OSMboxInit(&OutputMbox,  NULL);
+  /* Initialize the input frame ring & the pipeline queues */
+  InputRing.reset( );
+  InputSignal.init( );
+  DecodedChannel.reset( );
+  ResultChannel.reset( );
+  CorrectionRing.reset( );
+  CorrectionSignal.init( );
+
+  oDecodeLatency.reset( );
+  oComputeLatency.reset( );
+  oEncodeLatency.reset( );
+
+  if (!MachineRuntime::createTask( DecodeTask,
+                                   this,
+                                   DecodeTaskStack,
+                                   USER_TASK_STK_SIZE,
+                                   DECODE_PRIORITY ) ||
+      !MachineRuntime::createTask( EncodeTask,
+                                   this,
+                                   EncodeTaskStack,
+                                   USER_TASK_STK_SIZE,
+                                   ENCODE_PRIORITY ) ||
+      !MachineRuntime::createTask( LearnTask,
+                                   this,
+                                   LearnTaskStack,
+                                   USER_TASK_STK_SIZE,
+                                   LEARN_PRIORITY ))
+  {
+    /* warn of error creating task */
+    iprintf("Error initializing pipeline stage RTOS data structures\n");
+  }
 
-  if (OSTaskCreate (	InputOutputTask,
-  			NULL,
-			(void *) &InputOutputTaskStack[USER_TASK_STK_SIZE],
-			(void *) InputOutputTaskStack,
-			INPUT_OUTPUT_PRIORITY) != OS_NO_ERR )
+  if (!MachineRuntime::createTask( InputOutputTask,
+                                   NULL,
+                                   InputOutputTaskStack,
+                                   USER_TASK_STK_SIZE,
+                                   INPUT_OUTPUT_PRIORITY ))
   {
     /* warn of error creating task */
     iprintf("Error initializing InputOutputTask RTOS data structure\n");
   }
 }
 
+void MachineEngine::DecodeTask(void * pvEngine)
+{
+  ((MachineEngine *)pvEngine)->runDecodeStage( );
+}
+
+void MachineEngine::EncodeTask(void * pvEngine)
+{
+  ((MachineEngine *)pvEngine)->runEncodeStage( );
+}
+
+void MachineEngine::LearnTask(void * pvEngine)
+{
+  ((MachineEngine *)pvEngine)->runLearnStage( );
+}
+
+void MachineEngine::runDecodeStage( )
+{
+  while (1)
+  {
+    MachineFrame   oFrame;
+    MachinePattern oPattern;
+
+    /* pend on input pattern;  every frame already queued is */
+    /* worked through before the next wakeup is waited for   */
+    while ( !InputRing.pop(oFrame) )
+    {
+      InputSignal.pend( );
+    }
+
+    unsigned long ulStart = MachineRuntime::microseconds( );
+      
+#if IO_DEBUG      
+    printf("\n\nData received from device driver: \n");
+    poVars->parseInputForDisplay(oFrame.aucBytes);
+    poVars->parseOutputForDisplay(oFrame.aucBytes);
+    printf("\n");
+#endif
+    MACHINE_TRACE(MACHINE_TRACE_FRAMES, MACHINE_TRACE_FRAME_RECEIVED, 0,
+                  frameBits(oFrame.aucBytes), 0.0f);
+
+    /* unpack the bitmap into one MachineScalar activation per input */
+    /* & target unit                                                 */
+    decodePattern(oFrame.aucBytes, oPattern);
+
+    oDecodeLatency.record(MachineRuntime::microseconds( ) - ulStart);
+
+    /* waits here while the compute stage is PIPELINE_DEPTH behind */
+    DecodedChannel.send(oPattern);
+  }
+}
+
+void MachineEngine::runEncodeStage( )
+{
+  while (1)
+  {
+    MachineResult oResult;
+    MachineFrame  oReply;
+
+    ResultChannel.receive(oResult);
+
+    unsigned long ulStart = MachineRuntime::microseconds( );
+
+    /* send the reply (ACK or output advice) to the device driver */
+    encodeResult(oResult, oReply);
+    write( DeviceDriver, (char *)oReply.aucBytes, MAXIMUM_BYTES);
+
+    oEncodeLatency.record(MachineRuntime::microseconds( ) - ulStart);
+  }
+}
+
+void MachineEngine::runLearnStage( )
+{
+  while (1)
+  {
+    MachinePattern oPattern;
+
+    /* corrections only arrive while start( ) runs online */
+    while ( !CorrectionRing.pop(oPattern) )
+    {
+      CorrectionSignal.pend( );
+    }
+
+    /* one small step on the network;  the weights go live at the  */
+    /* batch boundary, and inference keeps the copy it started on  */
+    storePattern(oPattern, CorrectionInputElement, CorrectionTargetElement);
+    trainPattern(CorrectionInputElement, CorrectionTargetElement);
+
+    machineStoreRelease(&ulCorrectionsApplied, ulCorrectionsApplied + 1);
+  }
+}
+
+void MachineEngine::displayPipeline( )
+{
+  printf("Input frames:  %lu high water, %lu overruns\n",
+         InputRing.getHighWater( ), InputRing.getOverruns( ));
+  printf("Decoded:       %lu high water, %lu stalls\n",
+         DecodedChannel.getHighWater( ), DecodedChannel.getStalls( ));
+  printf("Results:       %lu high water, %lu stalls\n",
+         ResultChannel.getHighWater( ), ResultChannel.getStalls( ));
+
+  if (bOnline)
+  {
+    printf("Corrections:   %lu applied, %lu dropped, version %lu\n",
+           machineLoadAcquire(&ulCorrectionsApplied),
+           CorrectionRing.getOverruns( ), oWeightSets.getVersion( ));
+  }
+
+  oDecodeLatency.display("decode");
+  oComputeLatency.display("compute");
+  oEncodeLatency.display("encode");
+}
+
 /*
  *****************************************************************************
  *    
@@ -534,9 +1378,10 @@ void MachineEngine::initializeRTOS( )
 
 /*------------------------------------------------------------------------
 
-  Functions for Task Mailbox interactions with main task.
+  Functions for Task frame ring interactions with main task.
 
  ------------------------------------------------------------------------*/
+
 void InputOutputTask(void *pdata)
 {
 #if USE_CANNED_DATA
@@ -545,22 +1390,15 @@ void InputOutputTask(void *pdata)
 
   while (1)
   {
-    OSTimeDly(1); // Delay for one tick
+    MachineRuntime::delay(1); // Delay for one tick
 #if COMMUNICATE_WITH_VI
-    //Set up a file set so we can select on the serial ports...
-    fd_set read_fds;
-    FD_ZERO( &read_fds );
-    FD_SET( DeviceDriver, &read_fds );
-    if ( select( FD_SETSIZE,
-                 &read_fds,
-                 ( fd_set * ) 0,
-                 ( fd_set * ) 0,
-                 TICKS_PER_SECOND * 10 ) )
+    //Wait on the serial port...
+    if ( MachineRuntime::waitReadable( DeviceDriver, TICKS_PER_SECOND * 10 ) )
     {
-       if ( FD_ISSET( DeviceDriver, &read_fds ) )
        {
           char ack[2]     = {0xCC};
-          char buffer[MAXIMUM_BYTES];
+          MachineFrame oFrame;
+          char * buffer = (char *)oFrame.aucBytes;
           
           for (int i=0; i < MAXIMUM_BYTES; i++)
           {
@@ -589,8 +1427,12 @@ void InputOutputTask(void *pdata)
           printf("\n");
 #endif
           
-          /* post the input (i.e., training) vector for processing */
-          OSMboxPost(&InputMbox, (void *)buffer);
+          /* queue the input (i.e., training) vector for processing; */
+          /* a full ring drops it and counts an overrun               */
+          if ( InputRing.push(oFrame) )
+          {
+            InputSignal.post( );
+          }
        }
     }
     else
@@ -598,13 +1440,21 @@ void InputOutputTask(void *pdata)
       // we timed out... nothing to send
     }
 #elif USE_CANNED_DATA
-  unsigned long ulTempPattern = 0x00000000;
-  unsigned char buffer[MAXIMUM_BYTES];
+  /* the canned source waits for room, so no canned pattern is lost */
+  if ( InputRing.isFull( ) )
+  {
+    continue;
+  }
+
+  /* each canned vector was folded into its frame before start-up */
+  unsigned long ulTempPattern = CannedSet.getFrame(count);
+  MachineFrame oFrame;
+  unsigned char * buffer = oFrame.aucBytes;
 
 #if IO_DEBUG
   /* we want two canned training patterns per second - */
   /*   this rate is quick but readable.                */
-  OSTimeDly(TICKS_PER_SECOND); 
+  MachineRuntime::delay(TICKS_PER_SECOND); 
 #endif
   
   for (int i=0; i < MAXIMUM_BYTES; i++)
@@ -612,12 +1462,6 @@ void InputOutputTask(void *pdata)
     buffer[i] = 0x00;
   } 
 
-  for (int i=0; i < MAXIMUM_ON_BITS; i++)
-  {
-    /* each canned train vector includes just a single bit */
-    ulTempPattern = ulTempPattern | CannedVectors[count][i]; 
-  }
-
   for (int i=0; i < MAXIMUM_BYTES; i++)
   {
     /* each buffer element is one byte of the entire pattern */
@@ -647,16 +1491,9 @@ void InputOutputTask(void *pdata)
   printf("\n");
 #endif
     
-  /* post the input (i.e., training) vector for processing */
-  OSMboxPost(&InputMbox, (void *)buffer);
-
-  void* pmsg;
-  BYTE err;
-      
-  /* pend on input pattern */
-  pmsg = OSMboxPend(&OutputMbox, 0, &err);
-
-  write( DeviceDriver, (char *)pmsg, MAXIMUM_BYTES);
+  /* queue the input (i.e., training) vector for processing */
+  InputRing.push(oFrame);
+  InputSignal.post( );
 #endif
   }
 }
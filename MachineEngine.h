@@ -11,40 +11,65 @@
   #ifndef MACHINEENGINE_H
   #define MACHINEENGINE_H 1
 
-  /* RTOS/HW specific include files */
-  #include "predef.h"
-  #include "string.h"
-  #include <basictypes.h>
-  #include <constants.h>
-  #include <stdio.h>
-  #include <stdlib.h>
-  #include <ucos.h>
-  #include <serial.h>
-  #include <cfinter.h>
-  #include <startnet.h>
+  /* RTOS/HW (or POSIX host) services */
+  #include "MachineRuntime.h"
+  #include "MachineRing.h"
+  #include "MachineVersions.h"
+  #include "MachineLatency.h"
+  #include "MachineTrace.h"
+  #include "MachineDecoder.h"
   #include <math.h>
 
   #include "MachineVariables.h"
   #include "MachineParameters.h"
-  #include "BackpropagationNode.h"
+  #include "MachineWeights.h"
+  #include "MachineModel.h"
+  #include "MachineNetwork.h"
+  #include "MachineDataSet.h"
+  #include "MachineTrainer.h"
 
   /* Canned data meta-data */
   #define INPUT_BITS  24
   #define OUTPUT_BITS  7
 
+  /* the guidance network's fixed shape:  the application configures   */
+  /* INPUT_BITS + 1 inputs, and MachineParameters sizes the hidden     */
+  /* layer at 3/2 of the input layer                                   */
+  typedef MachineNetwork<INPUT_BITS + 1, ((INPUT_BITS + 1) * 3) / 2,
+                         OUTPUT_BITS> MachineGuidanceNetwork;
+
   /* MAXIMUM_ON_BITS defines the max # of bitmaps w/in canned train vectors */
   #define MAXIMUM_ON_BITS 10
   
-  /* MAXIMUM_STATES defines the max # of bits available w/in the bitmaps    */
-  /* note: this value is for parsing, and must equal MAXIMUM_BYTES * 8      */
-  #define MAXIMUM_STATES  32
-  
   /* MAXIMUM_BYTES defines the max # of bytes represented w/in the bitmaps  */
-  /* note: this value is for parsing, and must equal MAXIMUM_STATES / 8     */
-  #define MAXIMUM_BYTES    4
+  /* note: set at build time through MACHINE_FRAME_BYTES (MachineRing.h);   */
+  /* frames may be wider than an unsigned long, but the canned vectors     */
+  /* fill the low 32 bits                                                  */
+  #define MAXIMUM_BYTES   MACHINE_FRAME_BYTES
+
+  /* MAXIMUM_STATES defines the max # of bits available w/in the bitmaps    */
+  #define MAXIMUM_STATES  (MAXIMUM_BYTES * 8)
+
+  /* PIPELINE_DEPTH defines the patterns held between pipeline stages; */
+  /* it must be a power of two                                         */
+  #define PIPELINE_DEPTH  16
+
+  /* CORRECTION_DEPTH bounds the labelled frames waiting for the online */
+  /* learner;  it must be a power of two                                */
+  #define CORRECTION_DEPTH  16
+
+  /* online learning applies corrections at the optimizer's rate */
+  /* times MACHINE_ONLINE_RATE_SCALE                              */
+  #ifndef MACHINE_ONLINE_RATE_SCALE
+  #define MACHINE_ONLINE_RATE_SCALE  0.1
+  #endif
 
   /* NUMBER_CANNED defined the number of canned training vectors      */
   #define NUMBER_CANNED   84
+
+  /* canned vectors ready to train on:  frames, input & target vectors */
+  typedef MachineDataSet<NUMBER_CANNED, INPUT_BITS + 1,
+                         OUTPUT_BITS> MachineCannedSet;
   
   /* UNIT_ACTIVATION_THRESHOLD is an empirically derived number indicating */
   /* the unit activity necessary to be considered equivalent to binary one */
@@ -53,6 +78,9 @@
   /* EPOCH_ERROR_THRESHOLD is an empirically derived number indicating */
   /* acceptable performance of the network in the given environment    */
   #define EPOCH_ERROR_THRESHOLD 45
+
+  /* MAXIMUM_EPOCHS bounds trainCanned( ) when the threshold is not met */
+  #define MAXIMUM_EPOCHS  1000
   
   /* These hex patterns can be used for AND bitmasking */
   #define INPUT_ELEMENTS         0x00FFFFFF
@@ -1158,6 +1186,37 @@
             EMPTY_ELEMENT            }
                                        };
 
+class MachineVariables;
+
+/* decode -> compute:  one frame, expanded to a unit activation per bit */
+struct MachinePattern
+{
+  unsigned char aucFrame[MAXIMUM_BYTES];
+  MachineScalar adInputs[MAXIMUM_STATES];
+  MachineScalar adTargets[MAXIMUM_STATES];
+};
+
+/* compute -> encode:  an ACK after training, else the winning outputs */
+struct MachineResult
+{
+  bool          bAcknowledge;
+  unsigned long ulDecision;
+};
+
+/* MACHINE_WEIGHT_READERS counts the tasks that may advise on published */
+/* weights at once:  the compute stage (reader 0) & pinModel( ) callers  */
+#ifndef MACHINE_WEIGHT_READERS
+#define MACHINE_WEIGHT_READERS  2
+#endif
+
+/* one published version of the weights, advised on while training */
+/* carries on in the network;  no fixed network copy is kept, so a  */
+/* publish costs one compile                                        */
+struct MachineWeightSet
+{
+  MachineModel           oModel;
+};
+
 class MachineEngine
   {
   public:
@@ -1167,32 +1226,164 @@ class MachineEngine
         void display( );		
 		void start( );
 		void stop( );
+
+        /* read-only snapshot of the trained network, shareable by any */
+        /* number of tasks (each with its own MachineContext)          */
+        const MachineModel * compileModel( );
+
+        /* epochs over the canned vectors straight from memory, back to */
+        /* back & without the I/O pipeline, until an epoch's error falls */
+        /* below EPOCH_ERROR_THRESHOLD (true), training stalls or        */
+        /* usMaximumEpochs pass                                          */
+        bool trainCanned(unsigned short usMaximumEpochs);
+
+        /* the epoch error stopped improving (MachineParameters::       */
+        /* setPlateau( )), ending trainCanned( ) or start( ) early      */
+        bool stalled( );
+
+        /* the latest published weights, for a task that advises (with   */
+        /* a MachineContext of its own) while training goes on:  reader  */
+        /* usReader (1 .. MACHINE_WEIGHT_READERS - 1, one task each)     */
+        /* holds the model, unchanged, until releaseModel( );  training  */
+        /* publishes at the next batch boundary once asked, and at the   */
+        /* end of every epoch                                            */
+        const MachineModel * pinModel(unsigned short usReader);
+        void releaseModel(unsigned short usReader);
+
+        /* weights published so far */
+        unsigned long getModelVersion( );
+
+        /* scores usCount packed input frames (the storePattern( ) layout, */
+        /* frame n at byte n * usFrameBytes) on the compiled model, writing */
+        /* each decision as a frame of the same width with the winning      */
+        /* output i at bit (INPUT_BITS + i)                                 */
+        bool iterateBatch(const unsigned char * pucFrames,
+                          unsigned short usFrameBytes, unsigned short usCount,
+                          unsigned char * pucOutputFrames);
+
+#if MACHINE_HOST_TRAINER
+        /* one training pass over usCount frames (the storePattern( )   */
+        /* layout, targets included, frame n at byte n * usFrameBytes)  */
+        /* spread over usThreads threads;  returns the summed absolute  */
+        /* output error                                                 */
+        double trainParallel(const unsigned char * pucFrames,
+                             unsigned short usFrameBytes, unsigned short usCount,
+                             unsigned short usThreads);
+#endif
+
+        /* checkpoint of the trained network (MachineCheckpoint.h) in */
+        /* a caller's buffer:  bytes written, 0 when it does not fit  */
+        unsigned long getCheckpointSize( );
+        unsigned long saveCheckpoint(unsigned char * pucBuffer,
+                                     unsigned long ulCapacity);
+        bool loadCheckpoint(const unsigned char * pucBuffer,
+                            unsigned long ulBytes);
+
+#if MACHINE_CHECKPOINT_FILES
+        /* the same, through a file;  saves replace the file atomically */
+        bool saveCheckpointFile(const char * pcPath);
+        bool loadCheckpointFile(const char * pcPath);
+
+        /* compiled model as a model image (MachineModel::saveImage( )) */
+        bool saveModelFile(const char * pcPath);
+
+        /* maps a model image & evaluates straight from its pages, which */
+        /* every process mapping the file shares, until training changes */
+        /* the weights                                                    */
+        bool mapModelFile(const char * pcPath);
+#endif
   private:
 		void initialize( );
 		void initializeRTOS( );
-		void iterate( );
+		unsigned long iterate( );
 		void train( );
-		void storePattern(unsigned char *);
+		void trainPattern(const MachineScalar * pdInputs,
+		                  const MachineScalar * pdTargets);
+		void decodePattern(const unsigned char *, MachinePattern &);
+		void storePattern(const MachinePattern &, MachineScalar * pdInputs,
+		                  MachineScalar * pdTargets);
+		void encodeResult(const MachineResult &, MachineFrame &);
+		void displayPipeline( );
 		bool training( );
+		bool publishWeights( );
 		void parseInputForDisplay(unsigned char *);
 		void parseOutputForDisplay(unsigned char *);
 
         MachineVariables * poVars;
         MachineParameters * poMachineParameters;
+
+        /* inference runs on the compiled model, recompiled after training */
+        MachineModel   oModel;
+        MachineContext oContext;
+        MachineBatch   oBatch;
+        bool           bModelCurrent;
+
+#if MACHINE_FIXED_NETWORK
+        /* copy of the compiled model when it has the guidance shape;  */
+        /* the model stays authoritative, and an image attached to it  */
+        /* is never copied here, so it is evaluated in place           */
+        MachineGuidanceNetwork oGuidanceNetwork;
+        bool                   bGuidanceCurrent;
+#endif
+
+        /* model image the compiled model may be attached to */
+        MachineMapping oModelMapping;
+
+#if MACHINE_HOST_TRAINER
+        MachineTrainer oTrainer;
+#endif
         
-        bool bStopRequested;
+        /* the decode & encode stages run as tasks of their own, the */
+        /* compute stage on the task that called start( )            */
+        static void DecodeTask(void *);
+        static void EncodeTask(void *);
+        void runDecodeStage( );
+        void runEncodeStage( );
+
+        /* the online learner works through the queued corrections at */
+        /* the lowest priority, publishing the weights it trains       */
+        static void LearnTask(void *);
+        void runLearnStage( );
+
+        bool bOnline;
+
+        /* batch boundaries publish the trained weights */
+        MachineVersionStore<MachineWeightSet, MACHINE_WEIGHT_READERS> oWeightSets;
+        static const unsigned short COMPUTE_READER = 0;
+        volatile unsigned long ulPublishWanted;        /* pinModel( ) */
+        unsigned long ulCorrectionsQueued;              /* compute stage */
+        volatile unsigned long ulCorrectionsApplied;    /* learner       */
+        unsigned long ulAdviceCount;                    /* compute stage */
+        unsigned long ulTrainingCount;                  /* trainer       */
+
+        volatile unsigned long bStopRequested;          /* stop( )       */
 		bool bInitialized;
-		
-		static const int HIDDEN_LENGTH_MULTIPLIER = 3;
-		static const int HIDDEN_LENGTH_DIVISOR    = 2;
 
         /* I/O should be higher priority than main processing task  */
         static const int INPUT_OUTPUT_PRIORITY    = MAIN_PRIO - 1;  
 
+        /* later stages drain ahead of earlier ones on a single core */
+        static const int ENCODE_PRIORITY          = MAIN_PRIO - 2;
+        static const int DECODE_PRIORITY          = MAIN_PRIO + 1;
+        static const int LEARN_PRIORITY           = MAIN_PRIO + 2;
+
         DWORD InputOutputTaskStack[USER_TASK_STK_SIZE];
+        DWORD DecodeTaskStack[USER_TASK_STK_SIZE];
+        DWORD EncodeTaskStack[USER_TASK_STK_SIZE];
+        DWORD LearnTaskStack[USER_TASK_STK_SIZE];
+
+        /* time spent in each stage per pattern */
+        MachineLatencyHistogram oDecodeLatency;
+        MachineLatencyHistogram oComputeLatency;
+        MachineLatencyHistogram oEncodeLatency;
+
+        /* sized to the configured input & output layers */
+        MachineScalar * PatternInputElement;
+        MachineScalar * PatternTargetElement;
 
-        char PatternInputElement[MAXIMUM_STATES];
-        char PatternTargetElement[MAXIMUM_STATES];
+        /* the same, for the correction the learner is applying */
+        MachineScalar * CorrectionInputElement;
+        MachineScalar * CorrectionTargetElement;
   };
 
   #endif  // #ifndef MACHINEENGINE_H
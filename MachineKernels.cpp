@@ -0,0 +1,723 @@
+/***************************************************
+ *
+ *  MachineKernels.cpp
+ *
+ *  MachineKernels class -
+ *		net & activation kernels for the
+ *		forward pass of the MachineVariables
+ *		class:  a scalar reference kernel plus
+ *		SSE2 / AVX2 / AVX-512 (x86) and NEON
+ *		(AArch64) kernels, chosen at runtime.
+ *
+ **************************************************/
+#include <math.h>
+#include <stdlib.h>
+
+#include "MachineKernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_DOUBLE)
+#define MACHINE_KERNELS_X86   1
+#include <immintrin.h>
+#else
+#define MACHINE_KERNELS_X86   0
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON) && \
+    (MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_DOUBLE)
+#define MACHINE_KERNELS_NEON  1
+#include <arm_neon.h>
+#else
+#define MACHINE_KERNELS_NEON  0
+#endif
+
+/* exp( ) range reduction:  x = n * ln2 + r, with |r| <= ln2 / 2 */
+/* (ln2 is split in two so n * EXP_LN2_HI is exact)              */
+#define EXP_LOG2E    1.4426950408889634074
+#define EXP_LN2_HI   6.93145751953125e-1
+#define EXP_LN2_LO   1.42860682030941723212e-6
+
+/* beyond this |x| the sigmoid is saturated, and 2^n stays normal */
+#define EXP_LIMIT    708.0
+
+/* exp(r) by a degree 12 Taylor polynomial (coefficients 1/k!,  */
+/* highest order first);  truncation error on |r| <= ln2 / 2 is */
+/* below 2e-16 relative                                         */
+#define EXP_POLY_TERMS 13
+
+static const double adExpPoly[EXP_POLY_TERMS] =
+{
+  2.08767569878680989792e-9,   /* 1/12! */
+  2.50521083854417187751e-8,   /* 1/11! */
+  2.75573192239858906526e-7,   /* 1/10! */
+  2.75573192239858906526e-6,   /* 1/9!  */
+  2.48015873015873015873e-5,   /* 1/8!  */
+  1.98412698412698412698e-4,   /* 1/7!  */
+  1.38888888888888888889e-3,   /* 1/6!  */
+  8.33333333333333333333e-3,   /* 1/5!  */
+  4.16666666666666666667e-2,   /* 1/4!  */
+  1.66666666666666666667e-1,   /* 1/3!  */
+  5.0e-1,                      /* 1/2!  */
+  1.0,                         /* 1/1!  */
+  1.0                          /* 1/0!  */
+};
+
+/*------------------------------------------------------------------------
+
+  Scalar (reference) kernel
+
+ ------------------------------------------------------------------------*/
+static MachineScalar dotScalar(const MachineScalar * pdA,
+                               const MachineScalar * pdB,
+                               unsigned short usLength, MachineScalar dSum)
+{
+  for (unsigned short i = 0; i < usLength; i++)
+  {
+    dSum += pdA[i] * pdB[i];
+  }
+  return dSum;
+}
+
+static void dotRowsScalar(const MachineScalar * pdRows, unsigned short usRowStride,
+                          unsigned short usRows, const MachineScalar * pdVector,
+                          unsigned short usLength, MachineScalar * pdOut,
+                          unsigned short usOutStride)
+{
+  /* row by row, so each result matches dotScalar( ) bit for bit */
+  for (unsigned short r = 0; r < usRows; r++)
+  {
+    pdOut[(unsigned long)r * usOutStride] =
+          dotScalar(pdRows + (unsigned long)r * usRowStride, pdVector,
+                    usLength, MachineScalar(0));
+  }
+}
+
+static void sigmoidScalar(const MachineScalar * pdNet,
+                          MachineScalar * pdActivation,
+                          unsigned short usLength)
+{
+  for (unsigned short i = 0; i < usLength; i++)
+  {
+    pdActivation[i] = machineSigmoid(pdNet[i]);
+  }
+}
+
+#if MACHINE_KERNELS_X86
+/*------------------------------------------------------------------------
+
+  SSE2 kernel (two doubles per vector)
+
+ ------------------------------------------------------------------------*/
+__attribute__((target("sse2")))
+static double dotSSE2(const double * pdA, const double * pdB,
+                      unsigned short usLength, double dSum)
+{
+  __m128d vSum0 = _mm_setzero_pd( );
+  __m128d vSum1 = _mm_setzero_pd( );
+  double  adLanes[2];
+  unsigned short i = 0;
+
+  for (; i + 4 <= usLength; i += 4)
+  {
+    vSum0 = _mm_add_pd(vSum0, _mm_mul_pd(_mm_loadu_pd(pdA + i),
+                                         _mm_loadu_pd(pdB + i)));
+    vSum1 = _mm_add_pd(vSum1, _mm_mul_pd(_mm_loadu_pd(pdA + i + 2),
+                                         _mm_loadu_pd(pdB + i + 2)));
+  }
+
+  _mm_storeu_pd(adLanes, _mm_add_pd(vSum0, vSum1));
+
+  double dPartial = adLanes[0] + adLanes[1];
+
+  for (; i < usLength; i++)
+  {
+    dPartial += pdA[i] * pdB[i];
+  }
+  return dSum + dPartial;
+}
+
+__attribute__((target("sse2")))
+static void dotRowsSSE2(const double * pdRows, unsigned short usRowStride,
+                        unsigned short usRows, const double * pdVector,
+                        unsigned short usLength, double * pdOut,
+                        unsigned short usOutStride)
+{
+  for (unsigned short r = 0; r < usRows; r++)
+  {
+    pdOut[(unsigned long)r * usOutStride] =
+          dotSSE2(pdRows + (unsigned long)r * usRowStride, pdVector,
+                  usLength, 0.0);
+  }
+}
+
+__attribute__((target("sse2")))
+static __m128d expSSE2(__m128d vX)
+{
+  vX = _mm_min_pd(_mm_max_pd(vX, _mm_set1_pd(-EXP_LIMIT)),
+                  _mm_set1_pd(EXP_LIMIT));
+
+  /* n = round(x / ln2), r = x - n * ln2 */
+  __m128i viN = _mm_cvtpd_epi32(_mm_mul_pd(vX, _mm_set1_pd(EXP_LOG2E)));
+  __m128d vN  = _mm_cvtepi32_pd(viN);
+  __m128d vR  = _mm_sub_pd(_mm_sub_pd(vX, _mm_mul_pd(vN, _mm_set1_pd(EXP_LN2_HI))),
+                           _mm_mul_pd(vN, _mm_set1_pd(EXP_LN2_LO)));
+
+  __m128d vP  = _mm_set1_pd(adExpPoly[0]);
+
+  for (int k = 1; k < EXP_POLY_TERMS; k++)
+  {
+    vP = _mm_add_pd(_mm_mul_pd(vP, vR), _mm_set1_pd(adExpPoly[k]));
+  }
+
+  /* 2^n built directly in the exponent field */
+  viN = _mm_add_epi32(viN, _mm_set1_epi32(1023));
+  viN = _mm_slli_epi64(_mm_unpacklo_epi32(viN, _mm_setzero_si128( )), 52);
+
+  return _mm_mul_pd(vP, _mm_castsi128_pd(viN));
+}
+
+__attribute__((target("sse2")))
+static void sigmoidSSE2(const double * pdNet, double * pdActivation,
+                        unsigned short usLength)
+{
+  const __m128d vOne = _mm_set1_pd(1.0);
+  unsigned short i = 0;
+
+  for (; i + 2 <= usLength; i += 2)
+  {
+    __m128d vE = expSSE2(_mm_sub_pd(_mm_setzero_pd( ),
+                                    _mm_loadu_pd(pdNet + i)));
+
+    _mm_storeu_pd(pdActivation + i, _mm_div_pd(vOne, _mm_add_pd(vOne, vE)));
+  }
+
+  sigmoidScalar(pdNet + i, pdActivation + i, usLength - i);
+}
+
+/*------------------------------------------------------------------------
+
+  AVX2 + FMA kernel (four doubles per vector)
+
+ ------------------------------------------------------------------------*/
+__attribute__((target("avx2,fma")))
+static double dotAVX2(const double * pdA, const double * pdB,
+                      unsigned short usLength, double dSum)
+{
+  __m256d vSum0 = _mm256_setzero_pd( );
+  __m256d vSum1 = _mm256_setzero_pd( );
+  double  adLanes[4];
+  unsigned short i = 0;
+
+  for (; i + 8 <= usLength; i += 8)
+  {
+    vSum0 = _mm256_fmadd_pd(_mm256_loadu_pd(pdA + i),
+                            _mm256_loadu_pd(pdB + i), vSum0);
+    vSum1 = _mm256_fmadd_pd(_mm256_loadu_pd(pdA + i + 4),
+                            _mm256_loadu_pd(pdB + i + 4), vSum1);
+  }
+
+  for (; i + 4 <= usLength; i += 4)
+  {
+    vSum0 = _mm256_fmadd_pd(_mm256_loadu_pd(pdA + i),
+                            _mm256_loadu_pd(pdB + i), vSum0);
+  }
+
+  _mm256_storeu_pd(adLanes, _mm256_add_pd(vSum0, vSum1));
+
+  double dPartial = (adLanes[0] + adLanes[1]) + (adLanes[2] + adLanes[3]);
+
+  for (; i < usLength; i++)
+  {
+    dPartial += pdA[i] * pdB[i];
+  }
+  return dSum + dPartial;
+}
+
+__attribute__((target("avx2,fma")))
+static double sumAVX2(__m256d vSum)
+{
+  __m128d vHalf = _mm_add_pd(_mm256_castpd256_pd128(vSum),
+                             _mm256_extractf128_pd(vSum, 1));
+
+  return _mm_cvtsd_f64(_mm_add_sd(vHalf, _mm_unpackhi_pd(vHalf, vHalf)));
+}
+
+__attribute__((target("avx2,fma")))
+static void dotRowsAVX2(const double * pdRows, unsigned short usRowStride,
+                        unsigned short usRows, const double * pdVector,
+                        unsigned short usLength, double * pdOut,
+                        unsigned short usOutStride)
+{
+  unsigned short r = 0;
+
+  /* four rows at a time share every load of pdVector */
+  for (; r + 4 <= usRows; r += 4)
+  {
+    const double * pdRow0 = pdRows + (unsigned long)r * usRowStride;
+    const double * pdRow1 = pdRow0 + usRowStride;
+    const double * pdRow2 = pdRow1 + usRowStride;
+    const double * pdRow3 = pdRow2 + usRowStride;
+    __m256d vSum0 = _mm256_setzero_pd( );
+    __m256d vSum1 = _mm256_setzero_pd( );
+    __m256d vSum2 = _mm256_setzero_pd( );
+    __m256d vSum3 = _mm256_setzero_pd( );
+    unsigned short i = 0;
+
+    for (; i + 4 <= usLength; i += 4)
+    {
+      __m256d vV = _mm256_loadu_pd(pdVector + i);
+
+      vSum0 = _mm256_fmadd_pd(_mm256_loadu_pd(pdRow0 + i), vV, vSum0);
+      vSum1 = _mm256_fmadd_pd(_mm256_loadu_pd(pdRow1 + i), vV, vSum1);
+      vSum2 = _mm256_fmadd_pd(_mm256_loadu_pd(pdRow2 + i), vV, vSum2);
+      vSum3 = _mm256_fmadd_pd(_mm256_loadu_pd(pdRow3 + i), vV, vSum3);
+    }
+
+    double dSum0 = sumAVX2(vSum0), dSum1 = sumAVX2(vSum1);
+    double dSum2 = sumAVX2(vSum2), dSum3 = sumAVX2(vSum3);
+
+    for (; i < usLength; i++)
+    {
+      dSum0 += pdRow0[i] * pdVector[i];
+      dSum1 += pdRow1[i] * pdVector[i];
+      dSum2 += pdRow2[i] * pdVector[i];
+      dSum3 += pdRow3[i] * pdVector[i];
+    }
+
+    pdOut[(unsigned long)(r + 0) * usOutStride] = dSum0;
+    pdOut[(unsigned long)(r + 1) * usOutStride] = dSum1;
+    pdOut[(unsigned long)(r + 2) * usOutStride] = dSum2;
+    pdOut[(unsigned long)(r + 3) * usOutStride] = dSum3;
+  }
+
+  for (; r < usRows; r++)
+  {
+    pdOut[(unsigned long)r * usOutStride] =
+          dotAVX2(pdRows + (unsigned long)r * usRowStride, pdVector,
+                  usLength, 0.0);
+  }
+}
+
+__attribute__((target("avx2,fma")))
+static __m256d expAVX2(__m256d vX)
+{
+  vX = _mm256_min_pd(_mm256_max_pd(vX, _mm256_set1_pd(-EXP_LIMIT)),
+                     _mm256_set1_pd(EXP_LIMIT));
+
+  /* n = round(x / ln2), r = x - n * ln2 */
+  __m256d vN = _mm256_round_pd(_mm256_mul_pd(vX, _mm256_set1_pd(EXP_LOG2E)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m256d vR = _mm256_fnmadd_pd(vN, _mm256_set1_pd(EXP_LN2_HI), vX);
+  vR         = _mm256_fnmadd_pd(vN, _mm256_set1_pd(EXP_LN2_LO), vR);
+
+  __m256d vP = _mm256_set1_pd(adExpPoly[0]);
+
+  for (int k = 1; k < EXP_POLY_TERMS; k++)
+  {
+    vP = _mm256_fmadd_pd(vP, vR, _mm256_set1_pd(adExpPoly[k]));
+  }
+
+  /* 2^n built directly in the exponent field */
+  __m128i viN = _mm_add_epi32(_mm256_cvtpd_epi32(vN), _mm_set1_epi32(1023));
+  __m256i viE = _mm256_slli_epi64(_mm256_cvtepi32_epi64(viN), 52);
+
+  return _mm256_mul_pd(vP, _mm256_castsi256_pd(viE));
+}
+
+__attribute__((target("avx2,fma")))
+static void sigmoidAVX2(const double * pdNet, double * pdActivation,
+                        unsigned short usLength)
+{
+  const __m256d vOne = _mm256_set1_pd(1.0);
+  unsigned short i = 0;
+
+  for (; i + 4 <= usLength; i += 4)
+  {
+    __m256d vE = expAVX2(_mm256_sub_pd(_mm256_setzero_pd( ),
+                                       _mm256_loadu_pd(pdNet + i)));
+
+    _mm256_storeu_pd(pdActivation + i,
+                     _mm256_div_pd(vOne, _mm256_add_pd(vOne, vE)));
+  }
+
+  sigmoidScalar(pdNet + i, pdActivation + i, usLength - i);
+}
+
+/*------------------------------------------------------------------------
+
+  AVX-512 kernel (eight doubles per vector, masked tails)
+
+ ------------------------------------------------------------------------*/
+
+/* GCC 12 reports the _mm512_undefined_pd( ) inside the max, min,    */
+/* roundscale, scalef & extract intrinsics as uninitialized (GCC bug */
+/* 105593), a false positive in the compiler's own headers           */
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f")))
+static double dotAVX512(const double * pdA, const double * pdB,
+                        unsigned short usLength, double dSum)
+{
+  __m512d vSum = _mm512_setzero_pd( );
+  unsigned short i = 0;
+
+  for (; i + 8 <= usLength; i += 8)
+  {
+    vSum = _mm512_fmadd_pd(_mm512_loadu_pd(pdA + i),
+                           _mm512_loadu_pd(pdB + i), vSum);
+  }
+
+  if (i < usLength)
+  {
+    __mmask8 mTail = (__mmask8)((1 << (usLength - i)) - 1);
+
+    vSum = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mTail, pdA + i),
+                           _mm512_maskz_loadu_pd(mTail, pdB + i), vSum);
+  }
+
+  return dSum + _mm512_reduce_add_pd(vSum);
+}
+
+__attribute__((target("avx512f")))
+static void dotRowsAVX512(const double * pdRows, unsigned short usRowStride,
+                          unsigned short usRows, const double * pdVector,
+                          unsigned short usLength, double * pdOut,
+                          unsigned short usOutStride)
+{
+  unsigned short r = 0;
+
+  /* four rows at a time share every load of pdVector */
+  for (; r + 4 <= usRows; r += 4)
+  {
+    const double * pdRow0 = pdRows + (unsigned long)r * usRowStride;
+    const double * pdRow1 = pdRow0 + usRowStride;
+    const double * pdRow2 = pdRow1 + usRowStride;
+    const double * pdRow3 = pdRow2 + usRowStride;
+    __m512d vSum0 = _mm512_setzero_pd( );
+    __m512d vSum1 = _mm512_setzero_pd( );
+    __m512d vSum2 = _mm512_setzero_pd( );
+    __m512d vSum3 = _mm512_setzero_pd( );
+
+    for (unsigned short i = 0; i < usLength; i += 8)
+    {
+      __mmask8 mLanes = 0xFF;
+
+      if (usLength - i < 8)
+      {
+        mLanes = (__mmask8)((1 << (usLength - i)) - 1);
+      }
+
+      __m512d vV = _mm512_maskz_loadu_pd(mLanes, pdVector + i);
+
+      vSum0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mLanes, pdRow0 + i), vV, vSum0);
+      vSum1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mLanes, pdRow1 + i), vV, vSum1);
+      vSum2 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mLanes, pdRow2 + i), vV, vSum2);
+      vSum3 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mLanes, pdRow3 + i), vV, vSum3);
+    }
+
+    pdOut[(unsigned long)(r + 0) * usOutStride] = _mm512_reduce_add_pd(vSum0);
+    pdOut[(unsigned long)(r + 1) * usOutStride] = _mm512_reduce_add_pd(vSum1);
+    pdOut[(unsigned long)(r + 2) * usOutStride] = _mm512_reduce_add_pd(vSum2);
+    pdOut[(unsigned long)(r + 3) * usOutStride] = _mm512_reduce_add_pd(vSum3);
+  }
+
+  for (; r < usRows; r++)
+  {
+    pdOut[(unsigned long)r * usOutStride] =
+          dotAVX512(pdRows + (unsigned long)r * usRowStride, pdVector,
+                    usLength, 0.0);
+  }
+}
+
+__attribute__((target("avx512f")))
+static __m512d expAVX512(__m512d vX)
+{
+  vX = _mm512_min_pd(_mm512_max_pd(vX, _mm512_set1_pd(-EXP_LIMIT)),
+                     _mm512_set1_pd(EXP_LIMIT));
+
+  /* n = round(x / ln2), r = x - n * ln2 */
+  __m512d vN = _mm512_roundscale_pd(_mm512_mul_pd(vX, _mm512_set1_pd(EXP_LOG2E)),
+                                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m512d vR = _mm512_fnmadd_pd(vN, _mm512_set1_pd(EXP_LN2_HI), vX);
+  vR         = _mm512_fnmadd_pd(vN, _mm512_set1_pd(EXP_LN2_LO), vR);
+
+  __m512d vP = _mm512_set1_pd(adExpPoly[0]);
+
+  for (int k = 1; k < EXP_POLY_TERMS; k++)
+  {
+    vP = _mm512_fmadd_pd(vP, vR, _mm512_set1_pd(adExpPoly[k]));
+  }
+
+  /* p * 2^n */
+  return _mm512_scalef_pd(vP, vN);
+}
+
+__attribute__((target("avx512f")))
+static void sigmoidAVX512(const double * pdNet, double * pdActivation,
+                          unsigned short usLength)
+{
+  const __m512d vOne = _mm512_set1_pd(1.0);
+  unsigned short i = 0;
+
+  for (; i < usLength; i += 8)
+  {
+    __mmask8 mLanes = 0xFF;
+
+    if (usLength - i < 8)
+    {
+      mLanes = (__mmask8)((1 << (usLength - i)) - 1);
+    }
+
+    __m512d vE = expAVX512(_mm512_sub_pd(_mm512_setzero_pd( ),
+                           _mm512_maskz_loadu_pd(mLanes, pdNet + i)));
+
+    _mm512_mask_storeu_pd(pdActivation + i, mLanes,
+                          _mm512_div_pd(vOne, _mm512_add_pd(vOne, vE)));
+  }
+}
+
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif  /* MACHINE_KERNELS_X86 */
+
+#if MACHINE_KERNELS_NEON
+/*------------------------------------------------------------------------
+
+  NEON kernel (two doubles per vector, AArch64 only)
+
+ ------------------------------------------------------------------------*/
+static double dotNEON(const double * pdA, const double * pdB,
+                      unsigned short usLength, double dSum)
+{
+  float64x2_t vSum0 = vdupq_n_f64(0.0);
+  float64x2_t vSum1 = vdupq_n_f64(0.0);
+  unsigned short i = 0;
+
+  for (; i + 4 <= usLength; i += 4)
+  {
+    vSum0 = vfmaq_f64(vSum0, vld1q_f64(pdA + i),     vld1q_f64(pdB + i));
+    vSum1 = vfmaq_f64(vSum1, vld1q_f64(pdA + i + 2), vld1q_f64(pdB + i + 2));
+  }
+
+  double dPartial = vaddvq_f64(vaddq_f64(vSum0, vSum1));
+
+  for (; i < usLength; i++)
+  {
+    dPartial += pdA[i] * pdB[i];
+  }
+  return dSum + dPartial;
+}
+
+static void dotRowsNEON(const double * pdRows, unsigned short usRowStride,
+                        unsigned short usRows, const double * pdVector,
+                        unsigned short usLength, double * pdOut,
+                        unsigned short usOutStride)
+{
+  for (unsigned short r = 0; r < usRows; r++)
+  {
+    pdOut[(unsigned long)r * usOutStride] =
+          dotNEON(pdRows + (unsigned long)r * usRowStride, pdVector,
+                  usLength, 0.0);
+  }
+}
+
+static float64x2_t expNEON(float64x2_t vX)
+{
+  vX = vminq_f64(vmaxq_f64(vX, vdupq_n_f64(-EXP_LIMIT)),
+                 vdupq_n_f64(EXP_LIMIT));
+
+  /* n = round(x / ln2), r = x - n * ln2 */
+  float64x2_t vN = vrndnq_f64(vmulq_n_f64(vX, EXP_LOG2E));
+  float64x2_t vR = vfmsq_f64(vX, vN, vdupq_n_f64(EXP_LN2_HI));
+  vR             = vfmsq_f64(vR, vN, vdupq_n_f64(EXP_LN2_LO));
+
+  float64x2_t vP = vdupq_n_f64(adExpPoly[0]);
+
+  for (int k = 1; k < EXP_POLY_TERMS; k++)
+  {
+    vP = vfmaq_f64(vdupq_n_f64(adExpPoly[k]), vP, vR);
+  }
+
+  /* 2^n built directly in the exponent field */
+  int64x2_t viE = vshlq_n_s64(vaddq_s64(vcvtq_s64_f64(vN),
+                                        vdupq_n_s64(1023)), 52);
+
+  return vmulq_f64(vP, vreinterpretq_f64_s64(viE));
+}
+
+static void sigmoidNEON(const double * pdNet, double * pdActivation,
+                        unsigned short usLength)
+{
+  const float64x2_t vOne = vdupq_n_f64(1.0);
+  unsigned short i = 0;
+
+  for (; i + 2 <= usLength; i += 2)
+  {
+    float64x2_t vE = expNEON(vnegq_f64(vld1q_f64(pdNet + i)));
+
+    vst1q_f64(pdActivation + i, vdivq_f64(vOne, vaddq_f64(vOne, vE)));
+  }
+
+  sigmoidScalar(pdNet + i, pdActivation + i, usLength - i);
+}
+#endif  /* MACHINE_KERNELS_NEON */
+
+/*------------------------------------------------------------------------
+
+  Kernel tables & runtime selection
+
+ ------------------------------------------------------------------------*/
+static const MachineKernels oScalarKernels =
+  { MACHINE_KERNEL_SCALAR, "scalar",  dotScalar, dotRowsScalar, sigmoidScalar };
+
+#if MACHINE_KERNELS_X86
+static const MachineKernels oSSE2Kernels =
+  { MACHINE_KERNEL_SSE2,   "SSE2",    dotSSE2,   dotRowsSSE2,   sigmoidSSE2   };
+static const MachineKernels oAVX2Kernels =
+  { MACHINE_KERNEL_AVX2,   "AVX2",    dotAVX2,   dotRowsAVX2,   sigmoidAVX2   };
+static const MachineKernels oAVX512Kernels =
+  { MACHINE_KERNEL_AVX512, "AVX-512", dotAVX512, dotRowsAVX512, sigmoidAVX512 };
+#endif
+
+#if MACHINE_KERNELS_NEON
+static const MachineKernels oNEONKernels =
+  { MACHINE_KERNEL_NEON,   "NEON",    dotNEON,   dotRowsNEON,   sigmoidNEON   };
+#endif
+
+static const MachineKernels * kernelsFor(int iType)
+{
+#if MACHINE_KERNELS_X86
+  __builtin_cpu_init( );
+
+  if ((iType == MACHINE_KERNEL_AVX512) && __builtin_cpu_supports("avx512f"))
+  {
+    return &oAVX512Kernels;
+  }
+
+  if ((iType == MACHINE_KERNEL_AVX2) && __builtin_cpu_supports("avx2") &&
+                                       __builtin_cpu_supports("fma"))
+  {
+    return &oAVX2Kernels;
+  }
+
+  if ((iType == MACHINE_KERNEL_SSE2) && __builtin_cpu_supports("sse2"))
+  {
+    return &oSSE2Kernels;
+  }
+#endif
+
+#if MACHINE_KERNELS_NEON
+  if (iType == MACHINE_KERNEL_NEON)
+  {
+    return &oNEONKernels;
+  }
+#endif
+
+  if (iType == MACHINE_KERNEL_SCALAR)
+  {
+    return &oScalarKernels;
+  }
+
+  /* not built for this target, or not supported by this CPU */
+  return NULL;
+}
+
+const MachineKernels * MachineKernels::select(int iRequestedType)
+{
+  const MachineKernels * poKernels = NULL;
+
+  if (iRequestedType != MACHINE_KERNEL_AUTO)
+  {
+    poKernels = kernelsFor(iRequestedType);
+  }
+
+  if (!poKernels)
+  {
+    /* widest kernel available, falling back to the scalar kernel */
+    static const int aiPreference[] = { MACHINE_KERNEL_AVX512,
+                                        MACHINE_KERNEL_AVX2,
+                                        MACHINE_KERNEL_NEON,
+                                        MACHINE_KERNEL_SSE2,
+                                        MACHINE_KERNEL_SCALAR };
+
+    for (unsigned int i = 0; !poKernels &&
+                 i < sizeof(aiPreference) / sizeof(aiPreference[0]); i++)
+    {
+      poKernels = kernelsFor(aiPreference[i]);
+    }
+  }
+
+  return poKernels;
+}
+
+double MachineKernels::measureDeviation( ) const
+{
+  /* compares this kernel with the scalar kernel on pseudo-random */
+  /* data (private generator, so rand( ) is left undisturbed)     */
+  MachineScalar adA[67], adB[67], adNet[67], adVector[67], adScalar[67];
+  double dWorst = 0;
+  unsigned long ulState = 0x2545F491;
+
+  for (unsigned short usLength = 1; usLength <= 67; usLength += 11)
+  {
+    double dMagnitude = 0;
+
+    for (unsigned short i = 0; i < usLength; i++)
+    {
+      ulState = (ulState * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+      adA[i]   = (double)ulState / 0x7FFFFFFF;
+      ulState = (ulState * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+      adB[i]   = 20.0 * ((double)ulState / 0x7FFFFFFF) - 10.0;
+      adNet[i] = MachineScalar(4.0) * adB[i] * adA[i];
+
+      dMagnitude += fabs(machineToDouble(adA[i] * adB[i]));
+    }
+
+    double dDeviation = fabs(machineToDouble(dot(adA, adB, usLength, 0.5)) -
+                             machineToDouble(dotScalar(adA, adB, usLength, 0.5))) /
+                        (dMagnitude + 0.5);
+
+    if (dDeviation > dWorst)
+    {
+      dWorst = dDeviation;
+    }
+
+    /* five rows of adB against adA:  one block of four plus one */
+    MachineScalar adRows[5], adRowsScalar[5];
+
+    dotRows(adB, 0, 5, adA, usLength, adRows, 1);
+    dotRowsScalar(adB, 0, 5, adA, usLength, adRowsScalar, 1);
+
+    for (unsigned short r = 0; r < 5; r++)
+    {
+      dDeviation = fabs(machineToDouble(adRows[r]) -
+                        machineToDouble(adRowsScalar[r])) / (dMagnitude + 0.5);
+
+      if (dDeviation > dWorst)
+      {
+        dWorst = dDeviation;
+      }
+    }
+
+    sigmoid(adNet, adVector, usLength);
+    sigmoidScalar(adNet, adScalar, usLength);
+
+    for (unsigned short i = 0; i < usLength; i++)
+    {
+      double dDifference = fabs(machineToDouble(adVector[i]) -
+                                machineToDouble(adScalar[i]));
+
+      if (dDifference > dWorst)
+      {
+        dWorst = dDifference;
+      }
+    }
+  }
+
+  return dWorst;
+}
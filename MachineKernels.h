@@ -0,0 +1,64 @@
+/***************************************************
+ *
+ * 	MachineKernels.h
+ *
+ *	forward pass kernels:  net (dot product)
+ *	and activation (sigmoid), with vector
+ *	implementations selected at runtime
+ *
+ **************************************************/
+
+  #ifndef MACHINEKERNELS_H
+  #define MACHINEKERNELS_H 1
+
+  #include "MachineScalar.h"
+
+  /* kernel types, see MachineParameters::setKernelType( )   */
+  /* AUTO picks the widest kernel the running CPU supports   */
+  #define MACHINE_KERNEL_AUTO      0
+  #define MACHINE_KERNEL_SCALAR    1
+  #define MACHINE_KERNEL_SSE2      2
+  #define MACHINE_KERNEL_AVX2      3
+  #define MACHINE_KERNEL_AVX512    4
+  #define MACHINE_KERNEL_NEON      5
+
+  /* MACHINE_KERNEL_TOLERANCE bounds how far a vector kernel may stray */
+  /* from the scalar kernel:  absolute for activations, relative to    */
+  /* the sum of absolute products for nets.  The scalar kernel is the  */
+  /* reference and reproduces the original arithmetic bit for bit.     */
+  /* The vector kernels are built for MACHINE_NUMERIC_DOUBLE only;     */
+  /* float & fixed point networks always run the scalar kernel.        */
+  #define MACHINE_KERNEL_TOLERANCE 1.0e-12
+
+  class MachineKernels
+  {
+  public:
+        static const MachineKernels * select(int iRequestedType);
+        double measureDeviation( ) const;
+
+        int          iType;
+        const char * pcName;
+
+        /* returns dSum plus the dot product of pdA & pdB */
+        MachineScalar (*dot)(const MachineScalar * pdA, const MachineScalar * pdB,
+                             unsigned short usLength, MachineScalar dSum);
+
+        /* pdOut[r * usOutStride] = dot product of row r of pdRows (rows  */
+        /* usRowStride apart) & pdVector, for r < usRows;  used by the    */
+        /* batched forward pass so each weight row is loaded once for    */
+        /* several patterns                                               */
+        void          (*dotRows)(const MachineScalar * pdRows,
+                                 unsigned short usRowStride,
+                                 unsigned short usRows,
+                                 const MachineScalar * pdVector,
+                                 unsigned short usLength,
+                                 MachineScalar * pdOut,
+                                 unsigned short usOutStride);
+
+        /* pdActivation[i] = 1 / (1 + exp(-pdNet[i])) */
+        void          (*sigmoid)(const MachineScalar * pdNet,
+                                 MachineScalar * pdActivation,
+                                 unsigned short usLength);
+  };
+
+  #endif  // #ifndef MACHINEKERNELS_H
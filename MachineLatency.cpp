@@ -0,0 +1,94 @@
+/***************************************************
+ *
+ *  MachineLatency.cpp
+ *
+ *  MachineLatencyHistogram class - per-stage
+ *		latency distribution for the engine's
+ *		decode, compute & encode pipeline.
+ *
+ **************************************************/
+#include "MachineLatency.h"
+
+MachineLatencyHistogram::MachineLatencyHistogram( )
+{
+  reset( );
+}
+
+void MachineLatencyHistogram::reset( )
+{
+  for (int b = 0; b < MACHINE_LATENCY_BUCKETS; b++)
+  {
+    machineStoreRelease(&aulBuckets[b], 0);
+  }
+
+  machineStoreRelease(&ulCount,   0);
+  machineStoreRelease(&ulTotal,   0);
+  machineStoreRelease(&ulMaximum, 0);
+}
+
+void MachineLatencyHistogram::record(unsigned long ulMicroseconds)
+{
+  int b = 0;
+
+  /* bucket = bit length of the sample */
+  while ((b < MACHINE_LATENCY_BUCKETS - 1) && (ulMicroseconds >> b))
+  {
+    b++;
+  }
+
+  /* only this task writes, so its own plain reads are current */
+  machineStoreRelease(&aulBuckets[b], aulBuckets[b] + 1);
+  machineStoreRelease(&ulTotal, ulTotal + ulMicroseconds);
+
+  if (ulMicroseconds > ulMaximum)
+  {
+    machineStoreRelease(&ulMaximum, ulMicroseconds);
+  }
+
+  machineStoreRelease(&ulCount, ulCount + 1);
+}
+
+unsigned long MachineLatencyHistogram::getCount( ) const
+{
+  return machineLoadAcquire(&ulCount);
+}
+
+unsigned long MachineLatencyHistogram::getMaximum( ) const
+{
+  return machineLoadAcquire(&ulMaximum);
+}
+
+unsigned long MachineLatencyHistogram::getPercentile(unsigned short usPercent) const
+{
+  unsigned long ulWanted = (getCount( ) * usPercent + 99) / 100;
+  unsigned long ulSeen   = 0;
+
+  for (int b = 0; b < MACHINE_LATENCY_BUCKETS - 1; b++)
+  {
+    ulSeen += machineLoadAcquire(&aulBuckets[b]);
+
+    if (ulSeen >= ulWanted)
+    {
+      return (1UL << b) - 1;
+    }
+  }
+
+  return getMaximum( );
+}
+
+void MachineLatencyHistogram::display(const char * pcName) const
+{
+  /* the count is published last, so the total covers it */
+  unsigned long ulLocalCount = getCount( );
+  unsigned long ulLocalTotal = machineLoadAcquire(&ulTotal);
+
+  if (!ulLocalCount)
+  {
+    iprintf("%-8s no samples\n", pcName);
+    return;
+  }
+
+  iprintf("%-8s %lu samples, mean %lu us, p50 <= %lu us, p99 <= %lu us, max %lu us\n",
+          pcName, ulLocalCount, ulLocalTotal / ulLocalCount,
+          getPercentile(50), getPercentile(99), getMaximum( ));
+}
@@ -0,0 +1,48 @@
+/***************************************************
+ *
+ * 	MachineLatency.h
+ *
+ *	latency histograms with power-of-two
+ *	microsecond buckets, one per pipeline
+ *	stage, written by that stage's task only
+ *	& read by any task through the acquire /
+ *	release helpers of MachineRuntime.h
+ *
+ **************************************************/
+
+  #ifndef MACHINELATENCY_H
+  #define MACHINELATENCY_H 1
+
+  #include "MachineRuntime.h"
+
+  /* bucket b holds samples of at most 2^b - 1 microseconds;  */
+  /* the last bucket also holds everything longer             */
+  #define MACHINE_LATENCY_BUCKETS  24
+
+  class MachineLatencyHistogram
+  {
+  public:
+		MachineLatencyHistogram( );
+        void reset( );
+
+        /* one sample, in microseconds;  the owning stage's task only */
+        void record(unsigned long ulMicroseconds);
+
+        unsigned long getCount( ) const;
+        unsigned long getMaximum( ) const;
+
+        /* upper bound of the bucket holding the given percentile */
+        unsigned long getPercentile(unsigned short usPercent) const;
+
+        /* one summary line;  read from another task, the figures are */
+        /* a snapshot that may be a sample or so out of step           */
+        void display(const char * pcName) const;
+
+  private:
+        volatile unsigned long aulBuckets[MACHINE_LATENCY_BUCKETS];
+        volatile unsigned long ulCount;
+        volatile unsigned long ulTotal;
+        volatile unsigned long ulMaximum;
+  };
+
+  #endif  // #ifndef MACHINELATENCY_H
@@ -0,0 +1,967 @@
+/***************************************************
+ *
+ *  MachineModel.cpp
+ *
+ *  MachineModel, MachineContext & MachineBatch
+ *  classes -
+ *		compiled, read-only copy of the network
+ *		trained by the MachineVariables class,
+ *		evaluated against per-caller scratch
+ *		unit state, one pattern or a batch of
+ *		patterns at a time.
+ *
+ **************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "MachineModel.h"
+#include "MachineVariables.h"
+#include "MachineDecoder.h"
+#include "MachineCheckpoint.h"
+
+/* Output State bitmap specification
+Output 0: OUTPUT_VELOCITY_BACK
+Output 1: OUTPUT_VELOCITY_STOP
+Output 2: OUTPUT_VELOCITY_FWD1
+Output 3: OUTPUT_VELOCITY_FWD2
+Output 4: OUTPUT_STEER_LEFT
+Output 5: OUTPUT_STEER_STRAIGHT
+Output 6: OUTPUT_STEER_RIGHT
+*/
+#define VELOCITY_FIRST_OUTPUT  0
+#define STEER_FIRST_OUTPUT     4
+#define STEER_LAST_OUTPUT      7
+
+/* model images are only valid on hosts with the writer's byte order, */
+/* scalar type & alignment, all of which the header records            */
+#define IMAGE_BYTE_ORDER       0x01020304UL
+#define IMAGE_FIELD_BYTES      40
+
+/* the header fields, as read from or written to the little-endian */
+/* layout in MachineModel.h                                        */
+struct MachineImageHeader
+{
+  unsigned char  aucMagic[4];        /* "MSMI" */
+  unsigned short usVersion;
+  unsigned short usHeaderBytes;
+  unsigned char  ucScalarBytes;
+  unsigned char  ucNumericMode;
+  unsigned char  ucActivation;
+  unsigned char  ucRecurrent;
+  unsigned short usAlignment;
+  unsigned short usInputLength;      /* including the bias */
+  unsigned short usHiddenLength;     /* including the bias */
+  unsigned short usOutputLength;
+  unsigned char  aucByteOrder[4];    /* IMAGE_BYTE_ORDER as stored  */
+  unsigned long  ulDataBytes;        /* weight planes after the header */
+  unsigned long  ulCrc;              /* CRC-32 of the weight planes    */
+  double         dErrorBound;        /* table activation error bound   */
+};
+
+/* the header must fit ahead of the first (aligned) weight plane */
+typedef char MachineImageHeaderFits
+  [(IMAGE_FIELD_BYTES <= MACHINE_IMAGE_HEADER_BYTES) ? 1 : -1];
+
+/* this host's byte order, as IMAGE_BYTE_ORDER lies in its memory */
+static void hostByteOrder(unsigned char * pucOrder)
+{
+  unsigned int uiOrder = IMAGE_BYTE_ORDER;
+
+  memcpy(pucOrder, &uiOrder, 4);
+}
+
+static void putHeader(unsigned char * pucOut, const MachineImageHeader & oHeader)
+{
+  memcpy(pucOut, oHeader.aucMagic, 4);
+  pucOut += 4;
+  MachineCheckpoint::putBytes(pucOut, oHeader.usVersion, 2);
+  MachineCheckpoint::putBytes(pucOut, oHeader.usHeaderBytes, 2);
+  MachineCheckpoint::putBytes(pucOut, oHeader.ucScalarBytes, 1);
+  MachineCheckpoint::putBytes(pucOut, oHeader.ucNumericMode, 1);
+  MachineCheckpoint::putBytes(pucOut, oHeader.ucActivation, 1);
+  MachineCheckpoint::putBytes(pucOut, oHeader.ucRecurrent, 1);
+  MachineCheckpoint::putBytes(pucOut, oHeader.usAlignment, 2);
+  MachineCheckpoint::putBytes(pucOut, oHeader.usInputLength, 2);
+  MachineCheckpoint::putBytes(pucOut, oHeader.usHiddenLength, 2);
+  MachineCheckpoint::putBytes(pucOut, oHeader.usOutputLength, 2);
+  memcpy(pucOut, oHeader.aucByteOrder, 4);
+  pucOut += 4;
+  MachineCheckpoint::putBytes(pucOut, oHeader.ulDataBytes, 4);
+  MachineCheckpoint::putBytes(pucOut, oHeader.ulCrc, 4);
+  MachineCheckpoint::putDouble(pucOut, oHeader.dErrorBound);
+}
+
+static void getHeader(const unsigned char * pucIn, MachineImageHeader & oHeader)
+{
+  memcpy(oHeader.aucMagic, pucIn, 4);
+  pucIn += 4;
+  oHeader.usVersion      = (unsigned short)MachineCheckpoint::getBytes(pucIn, 2);
+  oHeader.usHeaderBytes  = (unsigned short)MachineCheckpoint::getBytes(pucIn, 2);
+  oHeader.ucScalarBytes  = (unsigned char)MachineCheckpoint::getBytes(pucIn, 1);
+  oHeader.ucNumericMode  = (unsigned char)MachineCheckpoint::getBytes(pucIn, 1);
+  oHeader.ucActivation   = (unsigned char)MachineCheckpoint::getBytes(pucIn, 1);
+  oHeader.ucRecurrent    = (unsigned char)MachineCheckpoint::getBytes(pucIn, 1);
+  oHeader.usAlignment    = (unsigned short)MachineCheckpoint::getBytes(pucIn, 2);
+  oHeader.usInputLength  = (unsigned short)MachineCheckpoint::getBytes(pucIn, 2);
+  oHeader.usHiddenLength = (unsigned short)MachineCheckpoint::getBytes(pucIn, 2);
+  oHeader.usOutputLength = (unsigned short)MachineCheckpoint::getBytes(pucIn, 2);
+  memcpy(oHeader.aucByteOrder, pucIn, 4);
+  pucIn += 4;
+  oHeader.ulDataBytes    = (unsigned long)MachineCheckpoint::getBytes(pucIn, 4);
+  oHeader.ulCrc          = (unsigned long)MachineCheckpoint::getBytes(pucIn, 4);
+  oHeader.dErrorBound    = MachineCheckpoint::getDouble(pucIn);
+}
+
+/* bytes of one weights-only plane of usRows rows of usColumns */
+static unsigned long planeBytes(unsigned short usRows, unsigned short usColumns)
+{
+  return (unsigned long)usRows * MachineArena::alignedLength(usColumns) *
+         sizeof(MachineScalar);
+}
+
+static unsigned long winners(const MachineScalar * pdOutputs,
+                             unsigned short usFirst, unsigned short usLast)
+{
+  MachineScalar outcome = 0;
+  unsigned long ulWinners = 0;
+
+  for (unsigned short i = usFirst; i < usLast; i++)
+  {
+    if (pdOutputs[i] > outcome)
+    {
+      outcome = pdOutputs[i];
+    }
+  }
+
+  for (unsigned short i = usFirst; i < usLast; i++)
+  {
+    if (pdOutputs[i] == outcome)
+    {
+      ulWinners = ulWinners | (1UL << i);
+    }
+  }
+
+  return ulWinners;
+}
+
+static void activateUnits(const MachineKernels * poKernels,
+                          const MachineActivation & oActivation,
+                          const MachineScalar * pdNet,
+                          MachineScalar * pdActivation, unsigned short usLength)
+{
+  /* the exact activation runs on the (possibly vector) kernel */
+  if (oActivation.getType( ) == MACHINE_ACTIVATION_EXACT)
+  {
+    poKernels->sigmoid(pdNet, pdActivation, usLength);
+  }
+  else
+  {
+    oActivation.activate(pdNet, pdActivation, usLength);
+  }
+}
+
+MachineModel::MachineModel( )
+{
+  usInputLength  = 0;
+  usHiddenLength = 0;
+  usOutputLength = 0;
+  bRecurrent     = false;
+  bCompiled      = false;
+  bAttached      = false;
+  poKernels      = NULL;
+}
+
+MachineModel::~MachineModel( )
+{
+  release( );
+}
+
+bool MachineModel::compile(const MachineVariables & oVars)
+{
+  bool bRecurrentVars = (oVars.oContextToHidden.usRows != 0);
+
+  if (!oVars.poKernels || !oVars.oInputToHidden.Wts)
+  {
+    /* warn that the network has not been initialized */
+    printf("Uninitialized network within MachineModel::compile( )\n");
+    return false;
+  }
+
+  if (!bCompiled || bAttached ||
+      (usInputLength  != oVars.oInputUnits.usLength)  ||
+      (usHiddenLength != oVars.oHiddenUnits.usLength) ||
+      (usOutputLength != oVars.oOutputUnits.usLength) ||
+      (bRecurrent     != bRecurrentVars))
+  {
+    release( );
+
+    usInputLength  = oVars.oInputUnits.usLength;
+    usHiddenLength = oVars.oHiddenUnits.usLength;
+    usOutputLength = oVars.oOutputUnits.usLength;
+    bRecurrent     = bRecurrentVars;
+
+    oInputToHidden.configure(usHiddenLength, usInputLength, false);
+    oHiddenToOutput.configure(usOutputLength, usHiddenLength, false);
+    oArena.reserve(oInputToHidden.getBytes( ));
+    oArena.reserve(oHiddenToOutput.getBytes( ));
+
+    if (bRecurrent)
+    {
+      oContextToHidden.configure(usHiddenLength, usHiddenLength, false);
+      oArena.reserve(oContextToHidden.getBytes( ));
+    }
+
+    if (!oArena.allocate( ))
+    {
+      /* warn that the model storage could not be allocated */
+      printf("Unable to allocate model storage within ");
+      printf("MachineModel::compile( )\n");
+      release( );
+      return false;
+    }
+
+    oInputToHidden.bind(&oArena);
+    oHiddenToOutput.bind(&oArena);
+
+    if (bRecurrent)
+    {
+      oContextToHidden.bind(&oArena);
+    }
+
+    oActivation.configure(oVars.oActivation.getType( ),
+                          oVars.oActivation.getErrorBound( ));
+  }
+
+  poKernels = oVars.poKernels;
+
+  /* same dimensions, same padding:  each plane copies as one block */
+  memcpy((void *)oInputToHidden.Wts, oVars.oInputToHidden.Wts,
+         oInputToHidden.getBytes( ));
+
+  /* input columns left idle by the sparse path take their momentum in */
+  /* the copy, so a model compiled mid-training leaves training as is  */
+  oVars.settledCopy((MachineScalar *)oInputToHidden.Wts);
+  memcpy((void *)oHiddenToOutput.Wts, oVars.oHiddenToOutput.Wts,
+         oHiddenToOutput.getBytes( ));
+
+  if (bRecurrent)
+  {
+    memcpy((void *)oContextToHidden.Wts, oVars.oContextToHidden.Wts,
+           oContextToHidden.getBytes( ));
+  }
+
+  bCompiled = true;
+
+  return true;
+}
+
+void MachineModel::release( )
+{
+  /* DEALLOCATION of the model arena */
+  oInputToHidden.release( );
+  oHiddenToOutput.release( );
+  oContextToHidden.release( );
+  oArena.release( );
+  oActivation.release( );
+
+  usInputLength  = 0;
+  usHiddenLength = 0;
+  usOutputLength = 0;
+  bRecurrent     = false;
+  bCompiled      = false;
+  bAttached      = false;
+}
+
+bool MachineModel::isCompiled( ) const
+{
+  return bCompiled;
+}
+
+unsigned long MachineModel::getImageSize( ) const
+{
+  if (!bCompiled)
+  {
+    return 0;
+  }
+
+  return MACHINE_IMAGE_HEADER_BYTES +
+         planeBytes(usHiddenLength, usInputLength) +
+         planeBytes(usOutputLength, usHiddenLength) +
+         (bRecurrent ? planeBytes(usHiddenLength, usHiddenLength) : 0);
+}
+
+unsigned long MachineModel::saveImage(unsigned char * pucBuffer,
+                                      unsigned long ulCapacity) const
+{
+  unsigned long ulBytes = getImageSize( );
+  const MachineWeightMatrix * apoMatrices[3] =
+    { &oInputToHidden, &oHiddenToOutput, &oContextToHidden };
+  MachineImageHeader oHeader;
+  unsigned char * pucOut = pucBuffer + MACHINE_IMAGE_HEADER_BYTES;
+
+  if (!bCompiled)
+  {
+    /* warn that there is no model to save */
+    printf("Uncompiled model within MachineModel::saveImage( )\n");
+    return 0;
+  }
+
+  if (ulCapacity < ulBytes)
+  {
+    /* warn that the buffer cannot hold the image */
+    printf("Model image needs %lu bytes within MachineModel::saveImage( )\n",
+           ulBytes);
+    return 0;
+  }
+
+  /* rows are copied without their padding, which is saved as zeros */
+  /* so that equal weights always give equal images                 */
+  memset(pucBuffer, 0, ulBytes);
+
+  for (int m = 0; m < (bRecurrent ? 3 : 2); m++)
+  {
+    const MachineWeightMatrix & oMatrix = *apoMatrices[m];
+
+    for (unsigned short j = 0; j < oMatrix.usRows; j++)
+    {
+      memcpy(pucOut + (unsigned long)j * oMatrix.usStride * sizeof(MachineScalar),
+             oMatrix.rowWts(j), oMatrix.usColumns * sizeof(MachineScalar));
+    }
+
+    pucOut += planeBytes(oMatrix.usRows, oMatrix.usColumns);
+  }
+
+  memcpy(oHeader.aucMagic, "MSMI", 4);
+  oHeader.usVersion      = MACHINE_IMAGE_VERSION;
+  oHeader.usHeaderBytes  = MACHINE_IMAGE_HEADER_BYTES;
+  oHeader.ucScalarBytes  = sizeof(MachineScalar);
+  oHeader.ucNumericMode  = MACHINE_NUMERIC_MODE;
+  oHeader.ucActivation   = (unsigned char)oActivation.getType( );
+  oHeader.ucRecurrent    = bRecurrent;
+  oHeader.usAlignment    = MACHINE_ALIGNMENT_BYTES;
+  oHeader.usInputLength  = usInputLength;
+  oHeader.usHiddenLength = usHiddenLength;
+  oHeader.usOutputLength = usOutputLength;
+  hostByteOrder(oHeader.aucByteOrder);
+  oHeader.ulDataBytes    = ulBytes - MACHINE_IMAGE_HEADER_BYTES;
+  oHeader.ulCrc          = MachineCheckpoint::crc32(pucBuffer +
+                                                    MACHINE_IMAGE_HEADER_BYTES,
+                                                    oHeader.ulDataBytes);
+  oHeader.dErrorBound    = oActivation.getErrorBound( );
+  putHeader(pucBuffer, oHeader);
+
+  return ulBytes;
+}
+
+bool MachineModel::attach(const unsigned char * pucImage, unsigned long ulBytes,
+                          int iKernelType, bool bVerify)
+{
+  MachineImageHeader oHeader;
+  unsigned char aucByteOrder[4];
+  unsigned long ulDataBytes;
+  const MachineScalar * pdPlane;
+
+  if (!pucImage || (ulBytes < MACHINE_IMAGE_HEADER_BYTES))
+  {
+    /* warn that there is no image to attach */
+    printf("Missing model image within MachineModel::attach( )\n");
+    return false;
+  }
+
+  getHeader(pucImage, oHeader);
+  hostByteOrder(aucByteOrder);
+
+  if (memcmp(oHeader.aucMagic, "MSMI", 4) ||
+      (oHeader.usVersion     != MACHINE_IMAGE_VERSION) ||
+      (oHeader.usHeaderBytes != MACHINE_IMAGE_HEADER_BYTES) ||
+      (oHeader.ucScalarBytes != sizeof(MachineScalar)) ||
+      (oHeader.ucNumericMode != MACHINE_NUMERIC_MODE) ||
+      (oHeader.usAlignment   != MACHINE_ALIGNMENT_BYTES) ||
+      memcmp(oHeader.aucByteOrder, aucByteOrder, 4))
+  {
+    /* warn that the image was written by another build or host */
+    printf("Incompatible model image within MachineModel::attach( )\n");
+    return false;
+  }
+
+  if ((unsigned long)pucImage & (MACHINE_ALIGNMENT_BYTES - 1))
+  {
+    /* warn that the weight rows would be misaligned */
+    printf("Misaligned model image within MachineModel::attach( )\n");
+    return false;
+  }
+
+  ulDataBytes = planeBytes(oHeader.usHiddenLength, oHeader.usInputLength) +
+                planeBytes(oHeader.usOutputLength, oHeader.usHiddenLength) +
+                (oHeader.ucRecurrent ?
+                 planeBytes(oHeader.usHiddenLength, oHeader.usHiddenLength) : 0);
+
+  if (!oHeader.usInputLength || !oHeader.usHiddenLength ||
+      !oHeader.usOutputLength || (oHeader.ulDataBytes != ulDataBytes) ||
+      (ulBytes - MACHINE_IMAGE_HEADER_BYTES < ulDataBytes))
+  {
+    /* warn that the image is truncated or its sizes are inconsistent */
+    printf("Truncated model image within MachineModel::attach( )\n");
+    return false;
+  }
+
+  if (bVerify &&
+      (MachineCheckpoint::crc32(pucImage + MACHINE_IMAGE_HEADER_BYTES,
+                                ulDataBytes) != oHeader.ulCrc))
+  {
+    /* warn that the image is corrupt */
+    printf("Model image CRC mismatch within MachineModel::attach( )\n");
+    return false;
+  }
+
+  release( );
+
+  usInputLength  = oHeader.usInputLength;
+  usHiddenLength = oHeader.usHiddenLength;
+  usOutputLength = oHeader.usOutputLength;
+  bRecurrent     = (oHeader.ucRecurrent != 0);
+
+  if (!oActivation.configure(oHeader.ucActivation, oHeader.dErrorBound))
+  {
+    release( );
+    return false;
+  }
+
+  /* no arena:  the matrices point into the image */
+  pdPlane = (const MachineScalar *)(pucImage + MACHINE_IMAGE_HEADER_BYTES);
+
+  oInputToHidden.configure(usHiddenLength, usInputLength, false);
+  oInputToHidden.attach(pdPlane);
+  pdPlane += planeBytes(usHiddenLength, usInputLength) / sizeof(MachineScalar);
+
+  oHiddenToOutput.configure(usOutputLength, usHiddenLength, false);
+  oHiddenToOutput.attach(pdPlane);
+  pdPlane += planeBytes(usOutputLength, usHiddenLength) / sizeof(MachineScalar);
+
+  if (bRecurrent)
+  {
+    oContextToHidden.configure(usHiddenLength, usHiddenLength, false);
+    oContextToHidden.attach(pdPlane);
+  }
+
+  poKernels = MachineKernels::select(iKernelType);
+  bAttached = true;
+  bCompiled = true;
+
+  return true;
+}
+
+bool MachineModel::isAttached( ) const
+{
+  return bAttached;
+}
+
+bool MachineModel::isRecurrent( ) const
+{
+  return bRecurrent;
+}
+
+bool MachineModel::matches(const MachineVariables & oVars) const
+{
+  /* the error bound sizes the table, so only it depends on the bound */
+  return bCompiled &&
+         (usInputLength  == oVars.oInputUnits.usLength)  &&
+         (usHiddenLength == oVars.oHiddenUnits.usLength) &&
+         (usOutputLength == oVars.oOutputUnits.usLength) &&
+         (bRecurrent     == (oVars.oContextToHidden.usRows != 0)) &&
+         (oActivation.getType( ) == oVars.oActivation.getType( )) &&
+         ((oActivation.getType( ) != MACHINE_ACTIVATION_TABLE) ||
+          (oActivation.getErrorBound( ) == oVars.oActivation.getErrorBound( )));
+}
+
+unsigned short MachineModel::getInputLength( ) const
+{
+  return bCompiled ? usInputLength - 1 : 0;
+}
+
+unsigned short MachineModel::getOutputLength( ) const
+{
+  return usOutputLength;
+}
+
+void MachineModel::evaluate(MachineContext & oContext) const
+{
+  propagate(poKernels, oActivation,
+            oContext.oInputUnits, oContext.oHiddenUnits,
+            bRecurrent ? &oContext.oContextUnits : NULL,
+            oContext.oOutputUnits,
+            oInputToHidden, oHiddenToOutput,
+            bRecurrent ? &oContextToHidden : NULL);
+}
+
+unsigned long MachineModel::decide(const MachineContext & oContext) const
+{
+  return decideOutputs(oContext.oOutputUnits.Activation);
+}
+
+unsigned long MachineModel::decideOutputs(const MachineScalar * pdOutputs) const
+{
+  unsigned short usSteerLast = (usOutputLength < STEER_LAST_OUTPUT) ?
+                                usOutputLength : STEER_LAST_OUTPUT;
+  unsigned short usVelocityLast = (usSteerLast < STEER_FIRST_OUTPUT) ?
+                                   usSteerLast : STEER_FIRST_OUTPUT;
+
+  return winners(pdOutputs, VELOCITY_FIRST_OUTPUT, usVelocityLast) |
+         winners(pdOutputs, usVelocityLast, usSteerLast);
+}
+
+bool MachineModel::evaluateBatch(MachineBatch & oBatch,
+                                 unsigned short usCount) const
+{
+  unsigned short usHidden = usHiddenLength - 1;
+
+  if (!bCompiled || !oBatch.matches(*this))
+  {
+    /* warn that the batch was configured for another model */
+    printf("Mismatched batch within MachineModel::evaluateBatch( )\n");
+    return false;
+  }
+
+  if (usCount > oBatch.usCapacity)
+  {
+    /* warn that the batch cannot hold usCount patterns */
+    printf("Batch capacity exceeded within MachineModel::evaluateBatch( )\n");
+    return false;
+  }
+
+  /* the batch is a matrix product:  (patterns x inputs) times the   */
+  /* transposed weights;  a tile of pattern rows is held in cache    */
+  /* while each weight row is dotted against the whole tile, four    */
+  /* patterns to each load of the weights in the vector kernels      */
+  for (unsigned long ulFirst = 0; ulFirst < usCount;
+       ulFirst += MACHINE_BATCH_PATTERN_TILE)
+  {
+    unsigned short usTile = (unsigned short)
+          ((usCount - ulFirst < MACHINE_BATCH_PATTERN_TILE) ?
+            usCount - ulFirst : MACHINE_BATCH_PATTERN_TILE);
+
+    const MachineScalar * pdInputs = oBatch.Inputs +
+                                     ulFirst * oBatch.usInputStride;
+    MachineScalar * pdHiddenNet = oBatch.HiddenNet +
+                                  ulFirst * oBatch.usHiddenStride;
+    MachineScalar * pdHiddenActivation = oBatch.HiddenActivation +
+                                         ulFirst * oBatch.usHiddenStride;
+    MachineScalar * pdOutputNet = oBatch.OutputNet +
+                                  ulFirst * oBatch.usOutputStride;
+    MachineScalar * pdOutputs = oBatch.Outputs +
+                                ulFirst * oBatch.usOutputStride;
+
+    /* hidden unit nets, column i of the tile from weight row i; */
+    /* the context layer is cleared, so it contributes nothing   */
+    for (unsigned short i = 1; i <= usHidden; i++)
+    {
+      poKernels->dotRows(pdInputs, oBatch.usInputStride, usTile,
+                         oInputToHidden.rowWts(i), usInputLength,
+                         pdHiddenNet + i, oBatch.usHiddenStride);
+    }
+
+    /* hidden unit activation (the bias unit at index 0 is left at 1.0) */
+    for (unsigned short p = 0; p < usTile; p++)
+    {
+      unsigned long ulRow = (unsigned long)p * oBatch.usHiddenStride;
+
+      activateUnits(poKernels, oActivation, pdHiddenNet + ulRow + 1,
+                    pdHiddenActivation + ulRow + 1, usHidden);
+    }
+
+    /* output unit nets & activation */
+    for (unsigned short i = 0; i < usOutputLength; i++)
+    {
+      poKernels->dotRows(pdHiddenActivation, oBatch.usHiddenStride, usTile,
+                         oHiddenToOutput.rowWts(i), usHiddenLength,
+                         pdOutputNet + i, oBatch.usOutputStride);
+    }
+
+    for (unsigned short p = 0; p < usTile; p++)
+    {
+      unsigned long ulRow = (unsigned long)p * oBatch.usOutputStride;
+
+      activateUnits(poKernels, oActivation, pdOutputNet + ulRow,
+                    pdOutputs + ulRow, usOutputLength);
+    }
+  }
+
+  return true;
+}
+
+void MachineModel::decideBatch(const MachineBatch & oBatch,
+                               unsigned short usCount,
+                               unsigned short usFirstBit,
+                               unsigned char * pucFrames,
+                               unsigned short usFrameBytes) const
+{
+  for (unsigned short p = 0; p < usCount; p++)
+  {
+    unsigned char * pucFrame = pucFrames + (unsigned long)p * usFrameBytes;
+
+    memset(pucFrame, 0, usFrameBytes);
+    MachineBitDecoder::encode(decideOutputs(oBatch.getOutputs(p)), usOutputLength,
+                              usFirstBit, pucFrame, usFrameBytes);
+  }
+}
+
+void MachineModel::propagate(const MachineKernels * poKernels,
+                             const MachineActivation & oActivation,
+                             MachineUnitVector & oInputUnits,
+                             MachineUnitVector & oHiddenUnits,
+                             MachineUnitVector * poContextUnits,
+                             MachineUnitVector & oOutputUnits,
+                             const MachineWeightMatrix & oInputToHidden,
+                             const MachineWeightMatrix & oHiddenToOutput,
+                             const MachineWeightMatrix * poContextToHidden)
+{
+  unsigned short usHidden = oHiddenUnits.usLength - 1;
+  unsigned short ausActive[MACHINE_SPARSE_MAX_ACTIVE];
+  unsigned short usActive = findActive(oInputUnits, ausActive);
+
+  if (poContextUnits)
+  {
+    /* cumulative sum of recurrent unit activations multiplied by weights */
+    /* starts each hidden unit net:  one matrix-vector product, so each   */
+    /* context weight row is loaded once per step                         */
+    poKernels->dotRows(poContextToHidden->rowWts(1),
+                       poContextToHidden->usStride, usHidden,
+                       poContextUnits->Activation, poContextUnits->usLength,
+                       &oHiddenUnits.Net[1], 1);
+  }
+
+  /* set hidden unit activation based on input & recurrent layer activations */
+  for (unsigned short i = 1; i <= usHidden; i++)
+  {
+    MachineScalar dStart = poContextUnits ? oHiddenUnits.Net[i] : MachineScalar(0);
+
+    /* cumulative sum of input (in this case formal input) unit activations */
+    /* multiplied by weights adds to the hidden unit net;  zero inputs add  */
+    /* nothing, so a sparse input layer sums its active weights only        */
+    if (usActive)
+    {
+      const MachineScalar * pdWts = oInputToHidden.rowWts(i);
+      MachineScalar dNet = dStart;
+
+      for (unsigned short a = 0; a < usActive; a++)
+      {
+        dNet += oInputUnits.Activation[ausActive[a]] * pdWts[ausActive[a]];
+      }
+
+      oHiddenUnits.Net[i] = dNet;
+    }
+    else
+    {
+      oHiddenUnits.Net[i] = poKernels->dot(oInputUnits.Activation,
+                                           oInputToHidden.rowWts(i),
+                                           oInputUnits.usLength,
+                                           dStart);
+    }
+  }
+
+  /* hidden unit activation (the bias unit at index 0 is left at 1.0) */
+  activateUnits(poKernels, oActivation,
+                &oHiddenUnits.Net[1], &oHiddenUnits.Activation[1], usHidden);
+
+  if (poContextUnits)
+  {
+    /* set context layer activation at time (t + 1) to be hidden layer */
+    /* activation at time (t)                                          */
+    for (unsigned short i = 1; i <= usHidden; i++)
+    {
+      poContextUnits->Activation[i] = oHiddenUnits.Activation[i];
+    }
+  }
+
+  /* set output unit activation based on hidden activations & weight vectors */
+  for (unsigned short i = 0; i < oOutputUnits.usLength; i++)
+  {
+    /* cumulative addition of hidden unit activations */
+    /* multiplied by weights creates output unit net  */
+    oOutputUnits.Net[i] = poKernels->dot(oHiddenUnits.Activation,
+                                         oHiddenToOutput.rowWts(i),
+                                         oHiddenUnits.usLength,
+                                         MachineScalar(0));
+  }
+
+  activateUnits(poKernels, oActivation,
+                oOutputUnits.Net, oOutputUnits.Activation, oOutputUnits.usLength);
+}
+
+unsigned short MachineModel::findActive(const MachineUnitVector & oUnits,
+                                        unsigned short * pusActive)
+{
+#if MACHINE_SPARSE_INPUTS
+  unsigned short usLimit = oUnits.usLength / MACHINE_SPARSE_DENSITY;
+  unsigned short usActive = 0;
+
+  if (usLimit > MACHINE_SPARSE_MAX_ACTIVE)
+  {
+    usLimit = MACHINE_SPARSE_MAX_ACTIVE;
+  }
+
+  for (unsigned short i = 0; i < oUnits.usLength; i++)
+  {
+    if (oUnits.Activation[i] != MachineScalar(0))
+    {
+      if (usActive == usLimit)
+      {
+        return 0;
+      }
+      pusActive[usActive++] = i;
+    }
+  }
+
+  return usActive;
+#else
+  return 0;
+#endif
+}
+
+MachineContext::MachineContext( )
+{
+  bRecurrent = false;
+}
+
+MachineContext::~MachineContext( )
+{
+  release( );
+}
+
+bool MachineContext::configure(const MachineModel & oModel)
+{
+  release( );
+
+  if (!oModel.bCompiled)
+  {
+    /* warn that the model has not been compiled */
+    printf("Uncompiled model within MachineContext::configure( )\n");
+    return false;
+  }
+
+  bRecurrent = oModel.bRecurrent;
+
+  oInputUnits.configure(oModel.usInputLength);
+  oHiddenUnits.configure(oModel.usHiddenLength);
+  oOutputUnits.configure(oModel.usOutputLength);
+  oArena.reserve(oInputUnits.getBytes( ));
+  oArena.reserve(oHiddenUnits.getBytes( ));
+  oArena.reserve(oOutputUnits.getBytes( ));
+
+  if (bRecurrent)
+  {
+    oContextUnits.configure(oModel.usHiddenLength);
+    oArena.reserve(oContextUnits.getBytes( ));
+  }
+
+  if (!oArena.allocate( ))
+  {
+    /* warn that the context storage could not be allocated */
+    printf("Unable to allocate context storage within ");
+    printf("MachineContext::configure( )\n");
+    release( );
+    return false;
+  }
+
+  oInputUnits.bind(&oArena);
+  oHiddenUnits.bind(&oArena);
+  oOutputUnits.bind(&oArena);
+
+  if (bRecurrent)
+  {
+    oContextUnits.bind(&oArena);
+  }
+
+  /* Bias Nodes of Input & Hidden Layers */
+  oInputUnits.Activation[0]  = 1.0;
+  oHiddenUnits.Activation[0] = 1.0;
+
+  return true;
+}
+
+void MachineContext::release( )
+{
+  /* DEALLOCATION of the context arena */
+  oInputUnits.release( );
+  oHiddenUnits.release( );
+  oContextUnits.release( );
+  oOutputUnits.release( );
+  oArena.release( );
+
+  bRecurrent = false;
+}
+
+void MachineContext::reset( )
+{
+  if (bRecurrent)
+  {
+    for (unsigned short i = 0; i < oContextUnits.usLength; i++)
+    {
+      oContextUnits.Activation[i] = 0.0;
+    }
+  }
+}
+
+MachineScalar * MachineContext::getInputs( )
+{
+  return oInputUnits.Activation + 1;
+}
+
+const MachineScalar * MachineContext::getOutputs( ) const
+{
+  return oOutputUnits.Activation;
+}
+
+MachineBatch::MachineBatch( )
+{
+  usCapacity       = 0;
+  usInputLength    = 0;
+  usHiddenLength   = 0;
+  usOutputLength   = 0;
+  usInputStride    = 0;
+  usHiddenStride   = 0;
+  usOutputStride   = 0;
+  Inputs           = NULL;
+  HiddenNet        = NULL;
+  HiddenActivation = NULL;
+  OutputNet        = NULL;
+  Outputs          = NULL;
+}
+
+MachineBatch::~MachineBatch( )
+{
+  release( );
+}
+
+bool MachineBatch::configure(const MachineModel & oModel,
+                             unsigned short usLocalCapacity)
+{
+  release( );
+
+  if (!oModel.bCompiled || (usLocalCapacity == 0))
+  {
+    /* warn that the model has not been compiled or the batch is empty */
+    printf("Uncompiled model or empty batch within MachineBatch::configure( )\n");
+    return false;
+  }
+
+  usCapacity     = usLocalCapacity;
+  usInputLength  = oModel.usInputLength;
+  usHiddenLength = oModel.usHiddenLength;
+  usOutputLength = oModel.usOutputLength;
+  usInputStride  = MachineArena::alignedLength(usInputLength);
+  usHiddenStride = MachineArena::alignedLength(usHiddenLength);
+  usOutputStride = MachineArena::alignedLength(usOutputLength);
+
+  unsigned long ulInputBytes  = (unsigned long)usCapacity * usInputStride *
+                                sizeof(MachineScalar);
+  unsigned long ulHiddenBytes = (unsigned long)usCapacity * usHiddenStride *
+                                sizeof(MachineScalar);
+  unsigned long ulOutputBytes = (unsigned long)usCapacity * usOutputStride *
+                                sizeof(MachineScalar);
+
+  oArena.reserve(ulInputBytes);
+  oArena.reserve(2 * ulHiddenBytes);
+  oArena.reserve(2 * ulOutputBytes);
+
+  if (!oArena.allocate( ))
+  {
+    /* warn that the batch storage could not be allocated */
+    printf("Unable to allocate batch storage within ");
+    printf("MachineBatch::configure( )\n");
+    release( );
+    return false;
+  }
+
+  Inputs           = oArena.carve(ulInputBytes);
+  HiddenNet        = oArena.carve(ulHiddenBytes);
+  HiddenActivation = oArena.carve(ulHiddenBytes);
+  OutputNet        = oArena.carve(ulOutputBytes);
+  Outputs          = oArena.carve(ulOutputBytes);
+
+  /* Bias Nodes of Input & Hidden Layers, one per pattern */
+  for (unsigned short p = 0; p < usCapacity; p++)
+  {
+    Inputs[(unsigned long)p * usInputStride]            = 1.0;
+    HiddenActivation[(unsigned long)p * usHiddenStride] = 1.0;
+  }
+
+  return true;
+}
+
+void MachineBatch::release( )
+{
+  /* DEALLOCATION of the batch arena */
+  oArena.release( );
+
+  usCapacity       = 0;
+  usInputLength    = 0;
+  usHiddenLength   = 0;
+  usOutputLength   = 0;
+  usInputStride    = 0;
+  usHiddenStride   = 0;
+  usOutputStride   = 0;
+  Inputs           = NULL;
+  HiddenNet        = NULL;
+  HiddenActivation = NULL;
+  OutputNet        = NULL;
+  Outputs          = NULL;
+}
+
+unsigned short MachineBatch::getCapacity( ) const
+{
+  return usCapacity;
+}
+
+bool MachineBatch::matches(const MachineModel & oModel) const
+{
+  return (usCapacity != 0) &&
+         (usInputLength  == oModel.usInputLength)  &&
+         (usHiddenLength == oModel.usHiddenLength) &&
+         (usOutputLength == oModel.usOutputLength);
+}
+
+MachineScalar * MachineBatch::getInputs(unsigned short usPattern)
+{
+  return Inputs + (unsigned long)usPattern * usInputStride + 1;
+}
+
+const MachineScalar * MachineBatch::getOutputs(unsigned short usPattern) const
+{
+  return Outputs + (unsigned long)usPattern * usOutputStride;
+}
+
+bool MachineBatch::loadFrames(const unsigned char * pucFrames,
+                              unsigned short usFrameBytes,
+                              unsigned short usCount,
+                              unsigned short usFrameInputs)
+{
+  if (usCount > usCapacity)
+  {
+    /* warn that the batch cannot hold usCount patterns */
+    printf("Batch capacity exceeded within MachineBatch::loadFrames( )\n");
+    return false;
+  }
+
+  for (unsigned short p = 0; p < usCount; p++)
+  {
+    MachineScalar * pdInputs = getInputs(p);
+    unsigned short usDecoded = usInputLength - 1;
+
+    /* units past the frame's inputs read as zero, not as targets */
+    if (usDecoded > usFrameInputs)
+    {
+      usDecoded = usFrameInputs;
+    }
+
+    MachineBitDecoder::decode(pucFrames + (unsigned long)p * usFrameBytes,
+                              usFrameBytes, 0, usDecoded, pdInputs);
+
+    for (unsigned short i = usDecoded; i < usInputLength - 1; i++)
+    {
+      pdInputs[i] = 0;
+    }
+  }
+
+  return true;
+}
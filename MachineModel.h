@@ -0,0 +1,223 @@
+/***************************************************
+ *
+ * 	MachineModel.h
+ *
+ *	read-only inference:
+ *		MachineModel   - compiled (immutable)
+ *		                 copy of trained weights
+ *		MachineContext - per-caller scratch units
+ *		MachineBatch   - per-caller scratch units
+ *		                 for many patterns at once
+ *
+ **************************************************/
+
+  #ifndef MACHINEMODEL_H
+  #define MACHINEMODEL_H 1
+
+  #include "MachineWeights.h"
+  #include "MachineKernels.h"
+  #include "MachineActivation.h"
+
+  class MachineVariables;
+  class MachineContext;
+  class MachineBatch;
+
+  /* patterns evaluated together by evaluateBatch( ):  their input rows */
+  /* stay cache resident while every weight row streams past them once  */
+  #define MACHINE_BATCH_PATTERN_TILE  64
+
+  /* sparse input path:  while at most 1 / MACHINE_SPARSE_DENSITY of the */
+  /* input units (bias included, never more than MACHINE_SPARSE_MAX_     */
+  /* ACTIVE) are non-zero, hidden nets sum only the active weights       */
+  #ifndef MACHINE_SPARSE_INPUTS
+  #define MACHINE_SPARSE_INPUTS       1
+  #endif
+  #define MACHINE_SPARSE_DENSITY      4
+  #define MACHINE_SPARSE_MAX_ACTIVE   32
+
+  /* model image:  a header of MACHINE_IMAGE_HEADER_BYTES, then the  */
+  /* weight planes exactly as a compiled model holds them (host byte */
+  /* order, rows padded to the alignment), so an image loaded or     */
+  /* mapped on an aligned address is evaluated in place.  The header */
+  /* itself is little-endian with fixed-width fields, so any host    */
+  /* can read it & tell whether the planes suit it:                  */
+  /*   "MSMI", u16 version, u16 header bytes                         */
+  /*   u8 scalar bytes, u8 numeric mode, u8 activation, u8 recurrent */
+  /*   u16 alignment, u16 input, hidden & output lengths             */
+  /*   4 bytes of 0x01020304 in the writer's byte order              */
+  /*   u32 weight plane bytes, u32 CRC-32 of the weight planes       */
+  /*   f64 table activation error bound                              */
+  #define MACHINE_IMAGE_VERSION       2
+  #define MACHINE_IMAGE_HEADER_BYTES  MACHINE_ALIGNMENT_BYTES
+
+  /* a compiled model is only read by evaluate( ) & decide( ), so any  */
+  /* number of tasks may evaluate it at once, each with its own        */
+  /* MachineContext;  compile( ) must not run while others evaluate    */
+  class MachineModel
+  {
+  public:
+		MachineModel( );
+		~MachineModel( );
+        bool compile(const MachineVariables & oVars);
+        void release( );
+        bool isCompiled( ) const;
+
+        /* bytes saveImage( ) writes;  0 until compiled */
+        unsigned long getImageSize( ) const;
+        unsigned long saveImage(unsigned char * pucBuffer,
+                                unsigned long ulCapacity) const;
+
+        /* evaluates straight from a model image, without copying it;   */
+        /* pucImage must be MACHINE_ALIGNMENT_BYTES aligned and outlive */
+        /* the model's next attach( ), compile( ) or release( ).  With  */
+        /* bVerify the weights are checked against the image CRC        */
+        bool attach(const unsigned char * pucImage, unsigned long ulBytes,
+                    int iKernelType = MACHINE_KERNEL_AUTO,
+                    bool bVerify = true);
+        bool isAttached( ) const;
+
+        /* same layer sizes, recurrence & activation as oVars, so the */
+        /* model stands in for that network's own compiled weights   */
+        bool matches(const MachineVariables & oVars) const;
+
+        /* carries an Elman context layer, so each caller's context */
+        /* holds state from one evaluate( ) to the next             */
+        bool isRecurrent( ) const;
+
+        unsigned short getInputLength( ) const;    /* excluding the bias */
+        unsigned short getOutputLength( ) const;
+
+        /* forward pass of oContext's inputs into its outputs */
+        void evaluate(MachineContext & oContext) const;
+
+        /* bitmap of the winning velocity (outputs 0-3) & steering   */
+        /* (outputs 4-6) units, bit i for output i                   */
+        unsigned long decide(const MachineContext & oContext) const;
+
+        /* the same, for usOutputLength outputs evaluated elsewhere */
+        /* (e.g. by a MachineNetwork)                               */
+        unsigned long decideOutputs(const MachineScalar * pdOutputs) const;
+
+        /* forward pass of the first usCount patterns of oBatch;  each  */
+        /* pattern starts from a cleared recurrent (context) layer      */
+        bool evaluateBatch(MachineBatch & oBatch, unsigned short usCount) const;
+
+        /* decide( ) for each of the first usCount patterns of oBatch, */
+        /* written as usFrameBytes frames (frame n at byte             */
+        /* n * usFrameBytes) with winning output i at bit usFirstBit + i */
+        void decideBatch(const MachineBatch & oBatch, unsigned short usCount,
+                         unsigned short usFirstBit, unsigned char * pucFrames,
+                         unsigned short usFrameBytes) const;
+
+        /* forward pass shared with MachineVariables::iterate( ) */
+        static void propagate(const MachineKernels * poKernels,
+                              const MachineActivation & oActivation,
+                              MachineUnitVector & oInputUnits,
+                              MachineUnitVector & oHiddenUnits,
+                              MachineUnitVector * poContextUnits,
+                              MachineUnitVector & oOutputUnits,
+                              const MachineWeightMatrix & oInputToHidden,
+                              const MachineWeightMatrix & oHiddenToOutput,
+                              const MachineWeightMatrix * poContextToHidden);
+
+        /* indices of the non-zero activations of oUnits, in order, into */
+        /* pusActive (MACHINE_SPARSE_MAX_ACTIVE entries);  0 when the    */
+        /* layer is too dense for the sparse path                        */
+        static unsigned short findActive(const MachineUnitVector & oUnits,
+                                         unsigned short * pusActive);
+
+  private:
+        unsigned short         usInputLength;    /* including the bias */
+        unsigned short         usHiddenLength;   /* including the bias */
+        unsigned short         usOutputLength;
+        bool                   bRecurrent;
+        bool                   bCompiled;
+        bool                   bAttached;        /* weights in an image */
+
+        const MachineKernels * poKernels;
+        MachineActivation      oActivation;
+
+        /* weights only, no training planes */
+        MachineArena           oArena;
+        MachineWeightMatrix    oInputToHidden;
+        MachineWeightMatrix    oHiddenToOutput;
+        MachineWeightMatrix    oContextToHidden;
+
+  friend class MachineContext;
+  friend class MachineBatch;
+  template<unsigned short, unsigned short, unsigned short, class>
+  friend class MachineNetwork;
+  };
+
+  class MachineContext
+  {
+  public:
+		MachineContext( );
+		~MachineContext( );
+        bool configure(const MachineModel & oModel);
+        void release( );
+
+        /* clears the recurrent (context) layer between sequences */
+        void reset( );
+
+        /* input i (0 based) of the network, bias excluded */
+        MachineScalar * getInputs( );
+        const MachineScalar * getOutputs( ) const;
+
+  private:
+        MachineArena      oArena;
+        MachineUnitVector oInputUnits;
+        MachineUnitVector oHiddenUnits;
+        MachineUnitVector oContextUnits;
+        MachineUnitVector oOutputUnits;
+        bool              bRecurrent;
+
+  friend class MachineModel;
+  };
+
+  /* pattern-major planes:  row n holds pattern n, padded to the */
+  /* alignment, with column 0 of the input & hidden rows the bias */
+  class MachineBatch
+  {
+  public:
+		MachineBatch( );
+		~MachineBatch( );
+        bool configure(const MachineModel & oModel, unsigned short usLocalCapacity);
+        void release( );
+
+        unsigned short getCapacity( ) const;
+
+        /* configured for oModel's dimensions */
+        bool matches(const MachineModel & oModel) const;
+
+        /* input i (0 based) of pattern usPattern, bias excluded */
+        MachineScalar * getInputs(unsigned short usPattern);
+        const MachineScalar * getOutputs(unsigned short usPattern) const;
+
+        /* input i of pattern n is bit i of the usFrameBytes frame at  */
+        /* pucFrames + n * usFrameBytes, for the first usFrameInputs    */
+        /* inputs (the storePattern( ) layout);  any further inputs are */
+        /* cleared                                                       */
+        bool loadFrames(const unsigned char * pucFrames, unsigned short usFrameBytes,
+                        unsigned short usCount, unsigned short usFrameInputs);
+
+  private:
+        unsigned short  usCapacity;
+        unsigned short  usInputLength;    /* including the bias */
+        unsigned short  usHiddenLength;   /* including the bias */
+        unsigned short  usOutputLength;
+        unsigned short  usInputStride;
+        unsigned short  usHiddenStride;
+        unsigned short  usOutputStride;
+
+        MachineArena    oArena;
+        MachineScalar * Inputs;
+        MachineScalar * HiddenNet;
+        MachineScalar * HiddenActivation;
+        MachineScalar * OutputNet;
+        MachineScalar * Outputs;
+
+  friend class MachineModel;
+  };
+
+  #endif  // #ifndef MACHINEMODEL_H
@@ -0,0 +1,230 @@
+/***************************************************
+ *
+ * 	MachineNetwork.h
+ *
+ *	feed-forward network with its layer sizes
+ *	fixed at compile time:  every loop bound is
+ *	a constant & every plane an exactly sized
+ *	array, so the compiler can unroll and
+ *	vectorize the forward pass
+ *
+ **************************************************/
+
+  #ifndef MACHINENETWORK_H
+  #define MACHINENETWORK_H 1
+
+  #include <stdio.h>
+
+  #include "MachineModel.h"
+
+  /* MACHINE_FIXED_NETWORK lets the engine advise on MachineGuidanceNetwork */
+  /* whenever the compiled model has its shape;  0 keeps every forward pass */
+  /* on the runtime sized MachineModel                                      */
+  #ifndef MACHINE_FIXED_NETWORK
+  #define MACHINE_FIXED_NETWORK  1
+  #endif
+
+  /* sigmoid of a layer:  on the model's kernel for MachineScalar */
+  /* networks, unit by unit for any other scalar type              */
+  inline void machineNetworkActivate(const MachineKernels * poKernels,
+                                     const MachineScalar * pdNet,
+                                     MachineScalar * pdActivation,
+                                     unsigned short usLength)
+  {
+    poKernels->sigmoid(pdNet, pdActivation, usLength);
+  }
+
+  template<class Scalar>
+  inline void machineNetworkActivate(const MachineKernels *,
+                                     const Scalar * pdNet,
+                                     Scalar * pdActivation,
+                                     unsigned short usLength)
+  {
+    for (unsigned short i = 0; i < usLength; i++)
+    {
+      pdActivation[i] = machineSigmoid(pdNet[i]);
+    }
+  }
+
+  /* In, Hidden & Out count units without the bias units;  weights are   */
+  /* held transposed (one row per source unit, row 0 the bias), so each  */
+  /* source unit is added into every destination net in one pass.  Each  */
+  /* net still sums its sources in MachineModel's order, and the model's */
+  /* kernel activates each layer, so on the scalar kernel the outputs    */
+  /* match MachineModel::evaluate( ) bit for bit                         */
+  template<unsigned short In, unsigned short Hidden, unsigned short Out,
+           class Scalar = MachineScalar>
+  class MachineNetwork
+  {
+  public:
+        enum { INPUTS = In, HIDDEN = Hidden, OUTPUTS = Out };
+
+        /* rows padded to whole vectors, so the loops over them need */
+        /* no remainder & vectorize even under the cheapest cost model */
+        enum { HIDDEN_STRIDE = (Hidden + 7) & ~7, OUTPUT_STRIDE = (Out + 7) & ~7 };
+
+		MachineNetwork( );
+
+        /* copies the weights of a compiled feed-forward model with   */
+        /* exactly these layer sizes & exact activation;  false, with */
+        /* the network unchanged, for any other model                 */
+        bool load(const MachineModel & oModel);
+        bool isLoaded( ) const;
+
+        /* the same test load( ) applies, without its warnings, for */
+        /* callers that fall back to the model on their own;  a     */
+        /* model attached to an image never fits, as copying it     */
+        /* would undo its in-place, shared evaluation               */
+        static bool fits(const MachineModel & oModel);
+
+        /* pdInputs[INPUTS] (bias excluded) into pdOutputs[OUTPUTS] */
+        void evaluate(const Scalar * pdInputs, Scalar * pdOutputs) const;
+
+  private:
+        Scalar aadInputToHidden[In + 1][HIDDEN_STRIDE];
+        Scalar aadHiddenToOutput[Hidden + 1][OUTPUT_STRIDE];
+        bool   bLoaded;
+
+        /* the model's kernel, whose sigmoid activates both layers */
+        const MachineKernels * poKernels;
+  };
+
+  template<unsigned short In, unsigned short Hidden, unsigned short Out,
+           class Scalar>
+  MachineNetwork<In, Hidden, Out, Scalar>::MachineNetwork( )
+  {
+    bLoaded   = false;
+    poKernels = NULL;
+
+    /* padding weights stay zero */
+    for (unsigned short i = 0; i <= In; i++)
+    {
+      for (unsigned short j = 0; j < HIDDEN_STRIDE; j++)
+      {
+        aadInputToHidden[i][j] = Scalar(0);
+      }
+    }
+
+    for (unsigned short j = 0; j <= Hidden; j++)
+    {
+      for (unsigned short k = 0; k < OUTPUT_STRIDE; k++)
+      {
+        aadHiddenToOutput[j][k] = Scalar(0);
+      }
+    }
+  }
+
+  template<unsigned short In, unsigned short Hidden, unsigned short Out,
+           class Scalar>
+  bool MachineNetwork<In, Hidden, Out, Scalar>::load(const MachineModel & oModel)
+  {
+    if (!oModel.bCompiled || oModel.bRecurrent ||
+        (oModel.usInputLength  != In + 1) ||
+        (oModel.usHiddenLength != Hidden + 1) ||
+        (oModel.usOutputLength != Out))
+    {
+      /* warn that the model does not have this network's shape */
+      printf("Model shape differs within MachineNetwork::load( )\n");
+      return false;
+    }
+
+    if (oModel.oActivation.getType( ) != MACHINE_ACTIVATION_EXACT)
+    {
+      /* warn that only the exact activation is compiled in */
+      printf("Inexact activation within MachineNetwork::load( )\n");
+      return false;
+    }
+
+    /* hidden unit j is row j + 1 of the model (row 0 is its bias unit) */
+    for (unsigned short j = 0; j < Hidden; j++)
+    {
+      const MachineScalar * pdWts = oModel.oInputToHidden.rowWts(j + 1);
+
+      for (unsigned short i = 0; i <= In; i++)
+      {
+        aadInputToHidden[i][j] = Scalar(machineToDouble(pdWts[i]));
+      }
+    }
+
+    for (unsigned short k = 0; k < Out; k++)
+    {
+      const MachineScalar * pdWts = oModel.oHiddenToOutput.rowWts(k);
+
+      for (unsigned short j = 0; j <= Hidden; j++)
+      {
+        aadHiddenToOutput[j][k] = Scalar(machineToDouble(pdWts[j]));
+      }
+    }
+
+    poKernels = oModel.poKernels;
+    bLoaded   = true;
+
+    return true;
+  }
+
+  template<unsigned short In, unsigned short Hidden, unsigned short Out,
+           class Scalar>
+  bool MachineNetwork<In, Hidden, Out, Scalar>::fits(const MachineModel & oModel)
+  {
+    return oModel.bCompiled && !oModel.bAttached && !oModel.bRecurrent &&
+           (oModel.usInputLength  == In + 1) &&
+           (oModel.usHiddenLength == Hidden + 1) &&
+           (oModel.usOutputLength == Out) &&
+           (oModel.oActivation.getType( ) == MACHINE_ACTIVATION_EXACT);
+  }
+
+  template<unsigned short In, unsigned short Hidden, unsigned short Out,
+           class Scalar>
+  bool MachineNetwork<In, Hidden, Out, Scalar>::isLoaded( ) const
+  {
+    return bLoaded;
+  }
+
+  template<unsigned short In, unsigned short Hidden, unsigned short Out,
+           class Scalar>
+  void MachineNetwork<In, Hidden, Out, Scalar>::evaluate(const Scalar * pdInputs,
+                                                         Scalar * pdOutputs) const
+  {
+    Scalar adNet[HIDDEN_STRIDE];
+    Scalar adHidden[Hidden];
+    Scalar adOutputNet[OUTPUT_STRIDE];
+
+    /* bias unit (activation 1.0) first, then each non-zero input;  */
+    /* zero inputs add nothing, as on MachineModel's sparse path    */
+    for (unsigned short j = 0; j < HIDDEN_STRIDE; j++)
+    {
+      adNet[j] = Scalar(0) + aadInputToHidden[0][j];
+    }
+
+    for (unsigned short i = 0; i < In; i++)
+    {
+      Scalar dInput = pdInputs[i];
+
+      if (dInput != Scalar(0))
+      {
+        for (unsigned short j = 0; j < HIDDEN_STRIDE; j++)
+        {
+          adNet[j] += dInput * aadInputToHidden[i + 1][j];
+        }
+      }
+    }
+
+    machineNetworkActivate(poKernels, adNet, adHidden, Hidden);
+
+    for (unsigned short k = 0; k < OUTPUT_STRIDE; k++)
+    {
+      adOutputNet[k] = Scalar(0) + aadHiddenToOutput[0][k];
+    }
+
+    for (unsigned short j = 0; j < Hidden; j++)
+    {
+      for (unsigned short k = 0; k < OUTPUT_STRIDE; k++)
+      {
+        adOutputNet[k] += adHidden[j] * aadHiddenToOutput[j + 1][k];
+      }
+    }
+
+    machineNetworkActivate(poKernels, adOutputNet, pdOutputs, Out);
+  }
+
+  #endif  // #ifndef MACHINENETWORK_H
@@ -0,0 +1,302 @@
+/***************************************************
+ *
+ *  MachineOptimizer.cpp
+ *
+ *  MachineOptimizerState & MachineOptimizer
+ *  classes - per-weight optimizer state and
+ *		the update rules that turn weight error
+ *		derivatives into weight steps, used by
+ *		the MachineVariables class.
+ *
+ **************************************************/
+#include <stdio.h>
+#include <math.h>
+#include "MachineOptimizer.h"
+
+/* momentum SGD & Nesterov */
+const double MachineOptimizer::LearningRate = 0.33;
+const double MachineOptimizer::Momentum     = 0.85;
+
+/* iRPROP- step sizes, independent of the derivative's size */
+const double MachineOptimizer::RpropInitialStep = 0.1;
+const double MachineOptimizer::RpropMinimumStep = 1.0e-6;
+const double MachineOptimizer::RpropMaximumStep = 1.0;
+const double MachineOptimizer::RpropIncrease    = 1.2;
+const double MachineOptimizer::RpropDecrease    = 0.5;
+
+/* Adam, applied to the mean derivative over the batch */
+const double MachineOptimizer::AdamRate  = 0.05;
+const double MachineOptimizer::AdamBeta1 = 0.9;
+const double MachineOptimizer::AdamBeta2 = 0.999;
+
+MachineOptimizerState::MachineOptimizerState( )
+{
+  usRows    = 0;
+  usColumns = 0;
+  usStride  = 0;
+  usPlanes  = 0;
+
+  for (int p = 0; p < MACHINE_OPTIMIZER_PLANES; p++)
+  {
+    apdPlanes[p] = NULL;
+  }
+}
+
+MachineOptimizerState::~MachineOptimizerState( )
+{
+  release( );
+}
+
+void MachineOptimizerState::configure(const MachineWeightMatrix & oMatrix,
+                                      unsigned short usLocalPlanes)
+{
+  usRows    = oMatrix.usRows;
+  usColumns = oMatrix.usColumns;
+  usStride  = oMatrix.usStride;
+  usPlanes  = usLocalPlanes;
+}
+
+unsigned long MachineOptimizerState::getBytes( )
+{
+  return (unsigned long)usPlanes * usRows * usStride * sizeof(MachineScalar);
+}
+
+void MachineOptimizerState::bind(MachineArena * poArena)
+{
+  unsigned long ulPlane = (unsigned long)usRows * usStride;
+
+  if (!usPlanes)
+  {
+    return;
+  }
+
+  apdPlanes[0] = poArena->carve(getBytes( ));
+
+  for (unsigned short p = 1; apdPlanes[0] && (p < usPlanes); p++)
+  {
+    apdPlanes[p] = apdPlanes[p - 1] + ulPlane;
+  }
+}
+
+void MachineOptimizerState::release( )
+{
+  /* storage belongs to the arena */
+  usRows    = 0;
+  usColumns = 0;
+  usStride  = 0;
+  usPlanes  = 0;
+
+  for (int p = 0; p < MACHINE_OPTIMIZER_PLANES; p++)
+  {
+    apdPlanes[p] = NULL;
+  }
+}
+
+MachineOptimizer::MachineOptimizer( )
+{
+  iType             = MACHINE_OPTIMIZER_MOMENTUM;
+  dRateScale        = 1;
+  dRate             = LearningRate;
+  dStepLimit        = RpropMaximumStep;
+  dFirstCorrection  = 1;
+  dSecondCorrection = 1;
+}
+
+MachineOptimizer::~MachineOptimizer( )
+{
+}
+
+void MachineOptimizer::configure(int iLocalType)
+{
+  switch (iLocalType)
+  {
+    case MACHINE_OPTIMIZER_MOMENTUM:
+    case MACHINE_OPTIMIZER_NESTEROV:
+    case MACHINE_OPTIMIZER_RPROP:
+    case MACHINE_OPTIMIZER_ADAM:
+      iType = iLocalType;
+      break;
+
+    default:
+      /* warn that the optimizer is unknown, keep momentum SGD */
+      printf("Unknown optimizer %d within MachineOptimizer::configure( )\n",
+             iLocalType);
+      iType = MACHINE_OPTIMIZER_MOMENTUM;
+      break;
+  }
+}
+
+int MachineOptimizer::getType( ) const
+{
+  return iType;
+}
+
+const char * MachineOptimizer::getName( ) const
+{
+  switch (iType)
+  {
+    case MACHINE_OPTIMIZER_NESTEROV:  return "Nesterov momentum";
+    case MACHINE_OPTIMIZER_RPROP:     return "iRPROP-";
+    case MACHINE_OPTIMIZER_ADAM:      return "Adam";
+    default:                          return "momentum SGD";
+  }
+}
+
+unsigned short MachineOptimizer::getPlanes( ) const
+{
+  switch (iType)
+  {
+    case MACHINE_OPTIMIZER_NESTEROV:  return 1;
+    case MACHINE_OPTIMIZER_RPROP:     return 2;
+    case MACHINE_OPTIMIZER_ADAM:      return 2;
+    default:                          return 0;
+  }
+}
+
+bool MachineOptimizer::isLazy( ) const
+{
+  return iType == MACHINE_OPTIMIZER_MOMENTUM;
+}
+
+void MachineOptimizer::setRateScale(double dLocalRateScale)
+{
+  dRateScale = dLocalRateScale;
+}
+
+double MachineOptimizer::getRateScale( ) const
+{
+  return dRateScale;
+}
+
+void MachineOptimizer::beginUpdate(unsigned short usSamples,
+                                   unsigned long ulUpdate)
+{
+  /* the rates apply to the mean derivative over the batch, so the */
+  /* step size does not grow with the batch size                   */
+  if (iType == MACHINE_OPTIMIZER_ADAM)
+  {
+    dRate             = 1.0 / usSamples;
+    dStepLimit        = AdamRate * dRateScale;
+    dFirstCorrection  = 1 / (1 - pow(AdamBeta1, (double)ulUpdate));
+    dSecondCorrection = 1 / (1 - pow(AdamBeta2, (double)ulUpdate));
+  }
+  else
+  {
+    dRate      = LearningRate * dRateScale / usSamples;
+    dStepLimit = RpropMaximumStep * dRateScale;
+  }
+}
+
+void MachineOptimizer::computeSteps(MachineWeightMatrix & oMatrix,
+                                    MachineOptimizerState & oState,
+                                    unsigned short usRow,
+                                    const unsigned short * pusColumns,
+                                    unsigned short usFirst,
+                                    unsigned short usCount) const
+{
+  MachineScalar * pdWED      = oMatrix.rowWED(usRow);
+  MachineScalar * pdDeltaWts = oMatrix.rowDeltaWts(usRow);
+
+  switch (iType)
+  {
+    case MACHINE_OPTIMIZER_MOMENTUM:
+    {
+      /* rate & momentum in the numeric type of the network */
+      const MachineScalar localLearningRate = dRate;
+      const MachineScalar localMomentum     = Momentum;
+
+      for (unsigned short c = 0; c < usCount; c++)
+      {
+        unsigned short i = pusColumns ? pusColumns[c] : usFirst + c;
+
+        pdDeltaWts[i] = localLearningRate * pdWED[i] +
+                        localMomentum    * pdDeltaWts[i];
+      }
+      break;
+    }
+
+    case MACHINE_OPTIMIZER_NESTEROV:
+    {
+      /* the velocity takes the momentum step, and the weight moves */
+      /* on from where that step lands:  m * v' + lr * g            */
+      const MachineScalar localLearningRate = dRate;
+      const MachineScalar localMomentum     = Momentum;
+      MachineScalar * pdVelocity = oState.rowPlane(0, usRow);
+
+      for (unsigned short c = 0; c < usCount; c++)
+      {
+        unsigned short i = pusColumns ? pusColumns[c] : usFirst + c;
+        MachineScalar dGradientStep = localLearningRate * pdWED[i];
+
+        pdVelocity[i] = dGradientStep + localMomentum * pdVelocity[i];
+        pdDeltaWts[i] = dGradientStep + localMomentum * pdVelocity[i];
+      }
+      break;
+    }
+
+    case MACHINE_OPTIMIZER_RPROP:
+    {
+      /* only the sign of the derivative counts;  a sign change */
+      /* shrinks the step & skips the weight for one update     */
+      MachineScalar * pdStep = oState.rowPlane(0, usRow);
+      MachineScalar * pdSign = oState.rowPlane(1, usRow);
+
+      for (unsigned short c = 0; c < usCount; c++)
+      {
+        unsigned short i = pusColumns ? pusColumns[c] : usFirst + c;
+        double dWED  = machineToDouble(pdWED[i]);
+        double dSign = (dWED > 0) ? 1.0 : ((dWED < 0) ? -1.0 : 0.0);
+        double dStep = machineToDouble(pdStep[i]);
+        double dLast = machineToDouble(pdSign[i]);
+
+        /* step sizes never reach zero, so zero marks a fresh weight */
+        if (dStep == 0)
+        {
+          dStep = RpropInitialStep;
+        }
+
+        if (dSign * dLast > 0)
+        {
+          dStep = dStep * RpropIncrease;
+        }
+        else if (dSign * dLast < 0)
+        {
+          dStep = dStep * RpropDecrease;
+          dStep = (dStep < RpropMinimumStep) ? RpropMinimumStep : dStep;
+          dSign = 0;
+        }
+
+        /* the maximum may have been lowered since the step grew */
+        dStep = (dStep > dStepLimit) ? dStepLimit : dStep;
+
+        pdStep[i]     = dStep;
+        pdSign[i]     = dSign;
+        pdDeltaWts[i] = dSign * dStep;
+      }
+      break;
+    }
+
+    case MACHINE_OPTIMIZER_ADAM:
+    {
+      /* moments of the mean derivative, corrected for their zero start */
+      MachineScalar * pdFirst  = oState.rowPlane(0, usRow);
+      MachineScalar * pdSecond = oState.rowPlane(1, usRow);
+
+      for (unsigned short c = 0; c < usCount; c++)
+      {
+        unsigned short i = pusColumns ? pusColumns[c] : usFirst + c;
+        double dGradient = machineToDouble(pdWED[i]) * dRate;
+        double dFirst    = AdamBeta1 * machineToDouble(pdFirst[i]) +
+                           (1 - AdamBeta1) * dGradient;
+        double dSecond   = AdamBeta2 * machineToDouble(pdSecond[i]) +
+                           (1 - AdamBeta2) * dGradient * dGradient;
+
+        pdFirst[i]    = dFirst;
+        pdSecond[i]   = dSecond;
+        pdDeltaWts[i] = dStepLimit * dFirst * dFirstCorrection /
+                        (sqrt(dSecond * dSecondCorrection) + MACHINE_ADAM_EPSILON);
+      }
+      break;
+    }
+  }
+}
@@ -0,0 +1,131 @@
+/***************************************************
+ *
+ * 	MachineOptimizer.h
+ *
+ *	weight update rules:  momentum SGD (the
+ *	original rule), Nesterov momentum, iRPROP-
+ *	and Adam, each keeping its per-weight
+ *	state in planes laid out like the matrix
+ *
+ **************************************************/
+
+  #ifndef MACHINEOPTIMIZER_H
+  #define MACHINEOPTIMIZER_H 1
+
+  #include "MachineWeights.h"
+
+  /* optimizer types, see MachineParameters::setOptimizerType( ) */
+  #define MACHINE_OPTIMIZER_MOMENTUM  0
+  #define MACHINE_OPTIMIZER_NESTEROV  1
+  #define MACHINE_OPTIMIZER_RPROP     2
+  #define MACHINE_OPTIMIZER_ADAM      3
+
+  /* most state planes any optimizer keeps per weight */
+  #define MACHINE_OPTIMIZER_PLANES    2
+
+  /* Adam's denominator guard;  Q4.27 rounds second moments below its */
+  /* resolution to zero, so fixed point networks need a larger guard  */
+  #ifndef MACHINE_ADAM_EPSILON
+  #if MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_FIXED
+  #define MACHINE_ADAM_EPSILON  1.0e-4
+  #else
+  #define MACHINE_ADAM_EPSILON  1.0e-8
+  #endif
+  #endif
+
+  /* optimizer state of one weight matrix:  row-major planes with the */
+  /* matrix's stride, carved from the network arena after the matrix  */
+  class MachineOptimizerState
+  {
+  public:
+		MachineOptimizerState( );
+		~MachineOptimizerState( );
+        void configure(const MachineWeightMatrix & oMatrix,
+                       unsigned short usLocalPlanes);
+        unsigned long getBytes( );
+        void bind(MachineArena * poArena);
+        void release( );
+
+        MachineScalar * rowPlane(unsigned short usPlane, unsigned short usRow)
+        {
+          return apdPlanes[usPlane] + (unsigned long)usRow * usStride;
+        }
+
+  protected:
+        unsigned short usRows;
+        unsigned short usColumns;
+        unsigned short usStride;
+        unsigned short usPlanes;
+
+        MachineScalar * apdPlanes[MACHINE_OPTIMIZER_PLANES];
+
+  friend class MachineCheckpoint;
+  };
+
+  /* turns the weight error derivatives (WED, summed over a batch, in */
+  /* the descent direction) into the steps every weight takes;  the   */
+  /* step lands in DeltaWts and the caller adds & clamps it           */
+  class MachineOptimizer
+  {
+  public:
+		MachineOptimizer( );
+		~MachineOptimizer( );
+        void configure(int iLocalType);
+
+        int          getType( ) const;
+        const char * getName( ) const;
+
+        /* state planes per weight:  Nesterov keeps its velocity, */
+        /* iRPROP- step sizes & last derivatives, Adam both moments */
+        unsigned short getPlanes( ) const;
+
+        /* only momentum SGD lets a column sit out updates without a */
+        /* derivative & catch up in closed form (see settleColumns)   */
+        bool isLazy( ) const;
+
+        /* once per weight update, before any computeSteps( ):  the */
+        /* batch size & the count of updates including this one     */
+        void beginUpdate(unsigned short usSamples, unsigned long ulUpdate);
+
+        /* factor on the rate from the next update on (MachineSchedule); */
+        /* iRPROP- adapts its own steps & scales only their maximum      */
+        void   setRateScale(double dLocalRateScale);
+        double getRateScale( ) const;
+
+        /* steps for one row:  the usCount columns listed, or usCount */
+        /* columns from usFirst when pusColumns is NULL               */
+        void computeSteps(MachineWeightMatrix & oMatrix,
+                          MachineOptimizerState & oState,
+                          unsigned short usRow,
+                          const unsigned short * pusColumns,
+                          unsigned short usFirst,
+                          unsigned short usCount) const;
+
+        /* momentum SGD & Nesterov */
+        static const double LearningRate;
+        static const double Momentum;
+
+        /* iRPROP- step sizes, independent of the derivative's size */
+        static const double RpropInitialStep;
+        static const double RpropMinimumStep;
+        static const double RpropMaximumStep;
+        static const double RpropIncrease;
+        static const double RpropDecrease;
+
+        /* Adam, applied to the mean derivative over the batch */
+        static const double AdamRate;
+        static const double AdamBeta1;
+        static const double AdamBeta2;
+
+  private:
+        int    iType;
+        double dRateScale;
+
+        /* per update factors set by beginUpdate( ) */
+        double dRate;
+        double dStepLimit;           /* iRPROP- maximum step, Adam rate */
+        double dFirstCorrection;     /* Adam bias corrections */
+        double dSecondCorrection;
+  };
+
+  #endif  // #ifndef MACHINEOPTIMIZER_H
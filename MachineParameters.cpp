@@ -11,18 +11,45 @@
  *
  **************************************************/
 #include "MachineParameters.h"
+#include "MachineKernels.h"
+#include "MachineActivation.h"
+#include "MachineRandom.h"
+#include "MachineOptimizer.h"
+#include "MachineSchedule.h"
 
 MachineParameters::MachineParameters( )
 {
   bTrain = 0;
+  bOnline = 0;
   ucInputVectorLength = 0;
+  ucHiddenVectorLength = 0;
   ucOutputVectorLength = 0;
+  iKernelType = MACHINE_KERNEL_AUTO;
+  iActivationType = MACHINE_ACTIVATION_DEFAULT;
+  dActivationErrorBound = MACHINE_ACTIVATION_ERROR_BOUND;
+  ulRandomSeed = 0;
+  iPerturbMode = MACHINE_PERTURB_DEFAULT_MODE;
+  ulPerturbInterval = MACHINE_PERTURB_DEFAULT_INTERVAL;
+  dPerturbAmplitude = MACHINE_PERTURB_DEFAULT_AMPLITUDE;
+  dPerturbDecay = MACHINE_PERTURB_DEFAULT_DECAY;
+  usBatchSize = MACHINE_BATCH_ONLINE;
+  usEpochLength = MACHINE_EPOCH_DEFAULT_LENGTH;
+  usRecurrentWindow = MACHINE_RECURRENT_OFF;
+  iOptimizerType = MACHINE_OPTIMIZER_MOMENTUM;
+  iScheduleMode = MACHINE_SCHEDULE_DEFAULT_MODE;
+  usSchedulePeriod = MACHINE_SCHEDULE_DEFAULT_PERIOD;
+  dScheduleFactor = MACHINE_SCHEDULE_DEFAULT_FACTOR;
+  dScheduleMinimum = MACHINE_SCHEDULE_DEFAULT_MINIMUM;
+  usPlateauPatience = MACHINE_PLATEAU_DEFAULT_PATIENCE;
+  dPlateauDelta = MACHINE_PLATEAU_DEFAULT_DELTA;
+  usPlateauStall = MACHINE_PLATEAU_DEFAULT_STALL;
 }
 
 MachineParameters::~MachineParameters( )
 {
   bTrain = 0;
   ucInputVectorLength = 0;
+  ucHiddenVectorLength = 0;
   ucOutputVectorLength = 0;
 }
 
@@ -36,6 +63,23 @@ void MachineParameters::setInputVectorLength(unsigned short ucLocalInputVectorLe
   ucInputVectorLength = ucLocalInputVectorLength;
 }
 
+unsigned short MachineParameters::getHiddenVectorLength( )
+{
+  if (ucHiddenVectorLength)
+  {
+    return ucHiddenVectorLength;
+  }
+
+  /* default hidden layer is sized relative to the input layer */
+  return (unsigned short)((ucInputVectorLength * HIDDEN_LENGTH_MULTIPLIER) /
+                                                 HIDDEN_LENGTH_DIVISOR);
+}
+
+void MachineParameters::setHiddenVectorLength(unsigned short ucLocalHiddenVectorLength)
+{
+  ucHiddenVectorLength = ucLocalHiddenVectorLength;
+}
+
 unsigned short MachineParameters::getOutputVectorLength( )
 {
   return ucOutputVectorLength;
@@ -55,3 +99,179 @@ void MachineParameters::setMachineTraining( bool bLocalTrain )
 {
   bTrain = bLocalTrain;
 }
+
+bool MachineParameters::getOnlineLearning( )
+{
+  return bOnline;
+}
+
+void MachineParameters::setOnlineLearning( bool bLocalOnline )
+{
+  bOnline = bLocalOnline;
+}
+
+int MachineParameters::getKernelType( )
+{
+  return iKernelType;
+}
+
+void MachineParameters::setKernelType( int iLocalKernelType )
+{
+  iKernelType = iLocalKernelType;
+}
+
+int MachineParameters::getActivationType( )
+{
+  return iActivationType;
+}
+
+void MachineParameters::setActivationType( int iLocalActivationType )
+{
+  iActivationType = iLocalActivationType;
+}
+
+double MachineParameters::getActivationErrorBound( )
+{
+  return dActivationErrorBound;
+}
+
+void MachineParameters::setActivationErrorBound( double dLocalErrorBound )
+{
+  dActivationErrorBound = dLocalErrorBound;
+}
+
+unsigned long MachineParameters::getRandomSeed( )
+{
+  return ulRandomSeed;
+}
+
+void MachineParameters::setRandomSeed( unsigned long ulLocalRandomSeed )
+{
+  ulRandomSeed = ulLocalRandomSeed;
+}
+
+int MachineParameters::getPerturbationMode( )
+{
+  return iPerturbMode;
+}
+
+unsigned long MachineParameters::getPerturbationInterval( )
+{
+  return ulPerturbInterval;
+}
+
+double MachineParameters::getPerturbationAmplitude( )
+{
+  return dPerturbAmplitude;
+}
+
+double MachineParameters::getPerturbationDecay( )
+{
+  return dPerturbDecay;
+}
+
+void MachineParameters::setPerturbation( int iLocalMode,
+                                         unsigned long ulLocalInterval,
+                                         double dLocalAmplitude,
+                                         double dLocalDecay )
+{
+  iPerturbMode      = iLocalMode;
+  ulPerturbInterval = ulLocalInterval;
+  dPerturbAmplitude = dLocalAmplitude;
+  dPerturbDecay     = dLocalDecay;
+}
+
+unsigned short MachineParameters::getBatchSize( )
+{
+  return usBatchSize;
+}
+
+void MachineParameters::setBatchSize( unsigned short usLocalBatchSize )
+{
+  usBatchSize = usLocalBatchSize;
+}
+
+unsigned short MachineParameters::getEpochLength( )
+{
+  return usEpochLength;
+}
+
+void MachineParameters::setEpochLength( unsigned short usLocalEpochLength )
+{
+  usEpochLength = usLocalEpochLength ? usLocalEpochLength : 1;
+}
+
+unsigned short MachineParameters::getRecurrentWindow( )
+{
+  return usRecurrentWindow;
+}
+
+void MachineParameters::setRecurrentWindow( unsigned short usLocalWindow )
+{
+  usRecurrentWindow = usLocalWindow;
+}
+
+int MachineParameters::getOptimizerType( )
+{
+  return iOptimizerType;
+}
+
+void MachineParameters::setOptimizerType( int iLocalOptimizerType )
+{
+  iOptimizerType = iLocalOptimizerType;
+}
+
+int MachineParameters::getScheduleMode( )
+{
+  return iScheduleMode;
+}
+
+unsigned short MachineParameters::getSchedulePeriod( )
+{
+  return usSchedulePeriod;
+}
+
+double MachineParameters::getScheduleFactor( )
+{
+  return dScheduleFactor;
+}
+
+double MachineParameters::getScheduleMinimum( )
+{
+  return dScheduleMinimum;
+}
+
+void MachineParameters::setSchedule( int iLocalMode,
+                                     unsigned short usLocalPeriod,
+                                     double dLocalFactor,
+                                     double dLocalMinimum )
+{
+  iScheduleMode    = iLocalMode;
+  usSchedulePeriod = usLocalPeriod;
+  dScheduleFactor  = dLocalFactor;
+  dScheduleMinimum = dLocalMinimum;
+}
+
+unsigned short MachineParameters::getPlateauPatience( )
+{
+  return usPlateauPatience;
+}
+
+double MachineParameters::getPlateauDelta( )
+{
+  return dPlateauDelta;
+}
+
+unsigned short MachineParameters::getPlateauStall( )
+{
+  return usPlateauStall;
+}
+
+void MachineParameters::setPlateau( unsigned short usLocalPatience,
+                                    double dLocalDelta,
+                                    unsigned short usLocalStall )
+{
+  usPlateauPatience = usLocalPatience;
+  dPlateauDelta     = dLocalDelta;
+  usPlateauStall    = usLocalStall;
+}
@@ -7,6 +7,21 @@
   #ifndef MACHINEPARAMETERS_H
   #define MACHINEPARAMETERS_H 1
 
+  /* training batch sizes, see setBatchSize( ):  weights are updated */
+  /* after every sample (ONLINE) or once per epoch of the data being  */
+  /* trained on (EPOCH);  any size in between gives mini-batches      */
+  #define MACHINE_BATCH_ONLINE  1
+  #define MACHINE_BATCH_EPOCH   0
+
+  /* frames per epoch of the stream start( ) trains on, see           */
+  /* setEpochLength( );  the canned I/O task replays 84 vectors       */
+  #define MACHINE_EPOCH_DEFAULT_LENGTH  84
+
+  /* recurrence, see setRecurrentWindow( ):  a window of 0 leaves the */
+  /* network feed-forward;  N adds the Elman context layer, trained   */
+  /* by backpropagation through the last N steps                      */
+  #define MACHINE_RECURRENT_OFF  0
+
   class MachineParameters
   {
   public:
@@ -15,17 +30,74 @@
 		~MachineParameters( );
 
 		unsigned short getInputVectorLength();
+		unsigned short getHiddenVectorLength();
 		unsigned short getOutputVectorLength();
 		void setInputVectorLength(unsigned short);
+		void setHiddenVectorLength(unsigned short);
 		void setOutputVectorLength(unsigned short);
         bool getMachineTraining( );
         void setMachineTraining( bool );
+        bool getOnlineLearning( );
+        void setOnlineLearning( bool );
+        int  getKernelType( );
+        void setKernelType( int );
+        int  getActivationType( );
+        void setActivationType( int );
+        double getActivationErrorBound( );
+        void setActivationErrorBound( double );
+        unsigned long getRandomSeed( );
+        void setRandomSeed( unsigned long );
+        int  getPerturbationMode( );
+        unsigned long getPerturbationInterval( );
+        double getPerturbationAmplitude( );
+        double getPerturbationDecay( );
+        void setPerturbation( int, unsigned long, double, double );
+        unsigned short getBatchSize( );
+        void setBatchSize( unsigned short );
+        unsigned short getEpochLength( );
+        void setEpochLength( unsigned short );
+        unsigned short getRecurrentWindow( );
+        void setRecurrentWindow( unsigned short );
+        int  getOptimizerType( );
+        void setOptimizerType( int );
+        int  getScheduleMode( );
+        unsigned short getSchedulePeriod( );
+        double getScheduleFactor( );
+        double getScheduleMinimum( );
+        void setSchedule( int, unsigned short, double, double );
+        unsigned short getPlateauPatience( );
+        double getPlateauDelta( );
+        unsigned short getPlateauStall( );
+        void setPlateau( unsigned short, double, unsigned short );
   private:
 		unsigned short ucInputVectorLength;
+		unsigned short ucHiddenVectorLength;  /* 0 selects the default ratio */
 		unsigned short ucOutputVectorLength;
         bool bTrain;
+        bool bOnline;       /* inference also learns from labelled frames */
+        int  iKernelType;   /* MACHINE_KERNEL_* from MachineKernels.h */
+        int  iActivationType;        /* MACHINE_ACTIVATION_* */
+        double dActivationErrorBound; /* lookup table accuracy budget */
+        unsigned long ulRandomSeed;   /* 0 seeds from rand( ) */
+        int  iPerturbMode;            /* MACHINE_PERTURB_* */
+        unsigned long ulPerturbInterval;
+        double dPerturbAmplitude;
+        double dPerturbDecay;
+        unsigned short usBatchSize;   /* samples per weight update */
+        unsigned short usEpochLength; /* streamed frames per epoch */
+        unsigned short usRecurrentWindow;  /* BPTT steps, 0 feed-forward */
+        int  iOptimizerType;          /* MACHINE_OPTIMIZER_* */
+        int  iScheduleMode;           /* MACHINE_SCHEDULE_* */
+        unsigned short usSchedulePeriod;
+        double dScheduleFactor;
+        double dScheduleMinimum;
+        unsigned short usPlateauPatience;
+        double dPlateauDelta;
+        unsigned short usPlateauStall;
+
+		static const int HIDDEN_LENGTH_MULTIPLIER = 3;
+		static const int HIDDEN_LENGTH_DIVISOR    = 2;
   };
 
   #endif  // #ifndef MACHINEPARAMETERS_H
 
-
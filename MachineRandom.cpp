@@ -0,0 +1,182 @@
+/***************************************************
+ *
+ *  MachineRandom.cpp
+ *
+ *  MachineRandom class -
+ *		per-network xoshiro128+ generator used
+ *		by the MachineVariables class for
+ *		initial weights & scheduled weight
+ *		perturbation, independent of rand( ).
+ *
+ **************************************************/
+#include "MachineRandom.h"
+
+static unsigned int rotateLeft(unsigned int uiValue, int iBits)
+{
+  return (uiValue << iBits) | (uiValue >> (32 - iBits));
+}
+
+/* splitmix32 finalizer, expands the seed into well mixed state words */
+static unsigned int mixSeed(unsigned int * puiSeed)
+{
+  unsigned int z = (*puiSeed += 0x9E3779B9U);
+
+  z = (z ^ (z >> 16)) * 0x85EBCA6BU;
+  z = (z ^ (z >> 13)) * 0xC2B2AE35U;
+  return z ^ (z >> 16);
+}
+
+MachineRandom::MachineRandom( )
+{
+  seed(0);
+}
+
+void MachineRandom::seed(unsigned long ulSeed)
+{
+  unsigned int uiSeed = (unsigned int)ulSeed;
+
+  for (int k = 0; k < 4; k++)
+  {
+    for (int l = 0; l < MACHINE_RANDOM_LANES; l++)
+    {
+      auiState[k][l] = mixSeed(&uiSeed);
+    }
+  }
+
+  /* xoshiro state must not be all zero;  mixSeed( ) cannot */
+  /* produce four consecutive zeros, so every lane is valid  */
+  uiNextOutput = MACHINE_RANDOM_LANES;
+}
+
+void MachineRandom::getState(unsigned long * pulWords) const
+{
+  int w = 0;
+
+  for (int k = 0; k < 4; k++)
+  {
+    for (int l = 0; l < MACHINE_RANDOM_LANES; l++)
+    {
+      pulWords[w++] = auiState[k][l];
+    }
+  }
+
+  for (int l = 0; l < MACHINE_RANDOM_LANES; l++)
+  {
+    pulWords[w++] = auiOutput[l];
+  }
+
+  pulWords[w] = uiNextOutput;
+}
+
+bool MachineRandom::setState(const unsigned long * pulWords)
+{
+  int w = 0;
+
+  /* an all-zero lane would stay zero forever */
+  for (int l = 0; l < MACHINE_RANDOM_LANES; l++)
+  {
+    if (!(pulWords[l] | pulWords[MACHINE_RANDOM_LANES + l] |
+          pulWords[2 * MACHINE_RANDOM_LANES + l] |
+          pulWords[3 * MACHINE_RANDOM_LANES + l]))
+    {
+      return false;
+    }
+  }
+
+  if (pulWords[MACHINE_RANDOM_STATE_WORDS - 1] > MACHINE_RANDOM_LANES)
+  {
+    return false;
+  }
+
+  for (int k = 0; k < 4; k++)
+  {
+    for (int l = 0; l < MACHINE_RANDOM_LANES; l++)
+    {
+      auiState[k][l] = (unsigned int)pulWords[w++];
+    }
+  }
+
+  for (int l = 0; l < MACHINE_RANDOM_LANES; l++)
+  {
+    auiOutput[l] = (unsigned int)pulWords[w++];
+  }
+
+  uiNextOutput = (unsigned int)pulWords[w];
+
+  return true;
+}
+
+void MachineRandom::step( )
+{
+  /* one xoshiro128+ step of every lane;  the lane loops have no */
+  /* cross-lane dependency, so they compile to vector code       */
+  for (int l = 0; l < MACHINE_RANDOM_LANES; l++)
+  {
+    auiOutput[l] = auiState[0][l] + auiState[3][l];
+  }
+
+  for (int l = 0; l < MACHINE_RANDOM_LANES; l++)
+  {
+    unsigned int uiShifted = auiState[1][l] << 9;
+
+    auiState[2][l] ^= auiState[0][l];
+    auiState[3][l] ^= auiState[1][l];
+    auiState[1][l] ^= auiState[2][l];
+    auiState[0][l] ^= auiState[3][l];
+    auiState[2][l] ^= uiShifted;
+    auiState[3][l]  = rotateLeft(auiState[3][l], 11);
+  }
+
+  uiNextOutput = 0;
+}
+
+double MachineRandom::uniform( )
+{
+  unsigned int uiHigh, uiLow;
+
+  /* xoshiro128+ low bits are weak, so only the upper bits are used */
+  if (uiNextOutput >= MACHINE_RANDOM_LANES)
+  {
+    step( );
+  }
+  uiHigh = auiOutput[uiNextOutput++] >> 5;
+
+  if (uiNextOutput >= MACHINE_RANDOM_LANES)
+  {
+    step( );
+  }
+  uiLow = auiOutput[uiNextOutput++] >> 6;
+
+  return (uiHigh * 67108864.0 + uiLow) * (1.0 / 9007199254740992.0);
+}
+
+void MachineRandom::addNoise(MachineScalar * pdValues, unsigned short usLength,
+                             double dAmplitude)
+{
+  /* signed 32 bit output scaled to [-dAmplitude, dAmplitude) */
+  double dScale = dAmplitude / 2147483648.0;
+  unsigned short i = 0;
+
+  for (; i + MACHINE_RANDOM_LANES <= usLength; i += MACHINE_RANDOM_LANES)
+  {
+    step( );
+
+    for (int l = 0; l < MACHINE_RANDOM_LANES; l++)
+    {
+      pdValues[i + l] += dScale * (double)(int)auiOutput[l];
+    }
+  }
+
+  if (i < usLength)
+  {
+    step( );
+
+    for (int l = 0; i < usLength; l++, i++)
+    {
+      pdValues[i] += dScale * (double)(int)auiOutput[l];
+    }
+  }
+
+  /* the block has been used up */
+  uiNextOutput = MACHINE_RANDOM_LANES;
+}
@@ -0,0 +1,66 @@
+/***************************************************
+ *
+ * 	MachineRandom.h
+ *
+ *	seedable per-network pseudo-random
+ *	generator (four interleaved xoshiro128+
+ *	lanes, so bulk noise vectorizes) and the
+ *	weight perturbation schedule
+ *
+ **************************************************/
+
+  #ifndef MACHINERANDOM_H
+  #define MACHINERANDOM_H 1
+
+  #include "MachineScalar.h"
+
+  /* independent generator lanes stepped together */
+  #define MACHINE_RANDOM_LANES  4
+
+  /* weight perturbation schedules, see MachineParameters::setPerturbation( ) */
+  /*   OFF      - weights are never perturbed                                */
+  /*   INTERVAL - every N training steps, constant amplitude                 */
+  /*   ANNEALED - every N training steps, amplitude scaled by the decay      */
+  /*              after each perturbation                                    */
+  #define MACHINE_PERTURB_OFF       0
+  #define MACHINE_PERTURB_INTERVAL  1
+  #define MACHINE_PERTURB_ANNEALED  2
+
+  /* defaults:  once per pass over the canned set, at the amplitude */
+  /* the per-sample perturbation used to reach, halving each pass  */
+  #define MACHINE_PERTURB_DEFAULT_MODE       MACHINE_PERTURB_ANNEALED
+  #define MACHINE_PERTURB_DEFAULT_INTERVAL   84
+  #define MACHINE_PERTURB_DEFAULT_AMPLITUDE  0.02
+  #define MACHINE_PERTURB_DEFAULT_DECAY      0.5
+
+  /* 32 bit words of generator state, see getState( ) */
+  #define MACHINE_RANDOM_STATE_WORDS  (5 * MACHINE_RANDOM_LANES + 1)
+
+  class MachineRandom
+  {
+  public:
+		MachineRandom( );
+        void seed(unsigned long ulSeed);
+
+        /* the whole generator state, for checkpoints;  a restored */
+        /* generator continues the saved sequence exactly           */
+        void getState(unsigned long * pulWords) const;
+        bool setState(const unsigned long * pulWords);
+
+        /* uniform on [0, 1) with 53 bits of resolution */
+        double uniform( );
+
+        /* pdValues[i] += uniform noise on [-dAmplitude, dAmplitude) */
+        void addNoise(MachineScalar * pdValues, unsigned short usLength,
+                      double dAmplitude);
+
+  private:
+        void step( );
+
+        /* 32 bit state words & outputs, lane-major */
+        unsigned int auiState[4][MACHINE_RANDOM_LANES];
+        unsigned int auiOutput[MACHINE_RANDOM_LANES];
+        unsigned int uiNextOutput;
+  };
+
+  #endif  // #ifndef MACHINERANDOM_H
@@ -0,0 +1,202 @@
+/***************************************************
+ *
+ * 	MachineRing.h
+ *
+ *	lock-free single-producer / single-
+ *	consumer rings of fixed-size items,
+ *	copied in & out by value, between the
+ *	I/O task and the engine's stages
+ *
+ **************************************************/
+
+  #ifndef MACHINERING_H
+  #define MACHINERING_H 1
+
+  #include "MachineRuntime.h"
+  #include "MachineWeights.h"   /* MACHINE_ALIGNMENT_BYTES */
+
+  /* bytes per frame, the width of the serial pattern bitmap;  frames */
+  /* wider than an unsigned long are carried & decoded byte by byte    */
+  #ifndef MACHINE_FRAME_BYTES
+  #define MACHINE_FRAME_BYTES  4
+  #endif
+
+  /* frames held by the input ring;  must be a power of two */
+  #define MACHINE_RING_FRAMES  64
+
+  struct MachineFrame
+  {
+        unsigned char aucBytes[MACHINE_FRAME_BYTES];
+  };
+
+  /* exactly one task may push( ) and exactly one other task may pop( ); */
+  /* the producer & consumer indices sit on cache lines of their own so  */
+  /* the two tasks do not contend for a line on every item;  Capacity    */
+  /* must be a power of two                                              */
+  template <class Item, unsigned long Capacity>
+  class MachineRing
+  {
+  public:
+		MachineRing( )
+		{
+		  reset( );
+		}
+
+        /* only while neither task is using the ring */
+        void reset( )
+        {
+          ulHead       = 0;
+          ulCachedTail = 0;
+          ulHighWater  = 0;
+          ulOverruns   = 0;
+          ulTail       = 0;
+          ulCachedHead = 0;
+        }
+
+        /* producer:  copies the item in;  false (and one more overrun) */
+        /* when the ring is full, in which case the item is dropped     */
+        bool push(const Item & oItem)
+        {
+          unsigned long ulLocalHead = ulHead;
+
+          /* the consumer's index is re-read only when the ring looks full */
+          if (ulLocalHead - ulCachedTail >= Capacity)
+          {
+            ulCachedTail = machineLoadAcquire(&ulTail);
+
+            if (ulLocalHead - ulCachedTail >= Capacity)
+            {
+              machineStoreRelease(&ulOverruns, ulOverruns + 1);
+              return false;
+            }
+          }
+
+          aoItems[ulLocalHead & (Capacity - 1)] = oItem;
+          machineStoreRelease(&ulHead, ulLocalHead + 1);
+
+          /* a stale cached index overstates the count, so a new high-water */
+          /* mark is confirmed against the consumer's index before it sticks */
+          if (ulLocalHead + 1 - ulCachedTail > ulHighWater)
+          {
+            ulCachedTail = machineLoadAcquire(&ulTail);
+
+            if (ulLocalHead + 1 - ulCachedTail > ulHighWater)
+            {
+              machineStoreRelease(&ulHighWater, ulLocalHead + 1 - ulCachedTail);
+            }
+          }
+
+          return true;
+        }
+
+        bool isFull( ) const
+        {
+          return ulHead - machineLoadAcquire(&ulTail) >= Capacity;
+        }
+
+        /* consumer:  copies the oldest item out;  false when empty */
+        bool pop(Item & oItem)
+        {
+          unsigned long ulLocalTail = ulTail;
+
+          /* the producer's index is re-read only when the ring looks empty */
+          if (ulLocalTail == ulCachedHead)
+          {
+            ulCachedHead = machineLoadAcquire(&ulHead);
+
+            if (ulLocalTail == ulCachedHead)
+            {
+              return false;
+            }
+          }
+
+          oItem = aoItems[ulLocalTail & (Capacity - 1)];
+          machineStoreRelease(&ulTail, ulLocalTail + 1);
+
+          return true;
+        }
+
+        /* items waiting, most items ever waiting, failed push( )es */
+        unsigned long getCount( ) const
+        {
+          unsigned long ulLocalTail = machineLoadAcquire(&ulTail);
+
+          return machineLoadAcquire(&ulHead) - ulLocalTail;
+        }
+        unsigned long getHighWater( ) const
+        {
+          return machineLoadAcquire(&ulHighWater);
+        }
+        unsigned long getOverruns( ) const
+        {
+          return machineLoadAcquire(&ulOverruns);
+        }
+
+  private:
+        /* written by the producer only */
+        volatile unsigned long ulHead;
+        unsigned long          ulCachedTail;
+        volatile unsigned long ulHighWater;
+        volatile unsigned long ulOverruns;
+        unsigned char          aucProducerPad[MACHINE_ALIGNMENT_BYTES];
+
+        /* written by the consumer only */
+        volatile unsigned long ulTail;
+        unsigned long          ulCachedHead;
+        unsigned char          aucConsumerPad[MACHINE_ALIGNMENT_BYTES];
+
+        Item                   aoItems[Capacity];
+  };
+
+  typedef MachineRing<MachineFrame, MACHINE_RING_FRAMES> MachineFrameRing;
+
+  /* bounded ring between two pipeline stages:  send( ) blocks while */
+  /* the ring is full & receive( ) while it is empty, so each stage  */
+  /* runs at its own pace and only waits on the other at the ends;   */
+  /* getStalls( ) counts the sends that had to wait for room         */
+  template <class Item, unsigned long Capacity>
+  class MachineChannel
+  {
+  public:
+        /* only while neither task is using the channel */
+        void reset( )
+        {
+          oRing.reset( );
+          oData.init( );
+          oSpace.init( );
+        }
+
+        void send(const Item & oItem)
+        {
+          while (!oRing.push(oItem))
+          {
+            oSpace.pend( );
+          }
+          oData.post( );
+        }
+
+        void receive(Item & oItem)
+        {
+          while (!oRing.pop(oItem))
+          {
+            oData.pend( );
+          }
+          oSpace.post( );
+        }
+
+        unsigned long getHighWater( ) const
+        {
+          return oRing.getHighWater( );
+        }
+        unsigned long getStalls( ) const
+        {
+          return oRing.getOverruns( );
+        }
+
+  private:
+        MachineRing<Item, Capacity> oRing;
+        MachineSignal               oData;
+        MachineSignal               oSpace;
+  };
+
+  #endif  // #ifndef MACHINERING_H
@@ -0,0 +1,492 @@
+/***************************************************
+ *
+ *  MachineRuntime.cpp
+ *
+ *  MachineMailbox & MachineRuntime classes -
+ *		the operating system services used by
+ *		the MachineEngine class, on uC/OS
+ *		(NetBurner) or on POSIX hosts.
+ *
+ **************************************************/
+#include "MachineRuntime.h"
+
+#if MACHINE_RUNTIME == MACHINE_RUNTIME_POSIX
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#endif
+
+#if MACHINE_RUNTIME == MACHINE_RUNTIME_RTOS
+
+/*
+ * **************************************************************************
+ *
+ *     uC/OS backend
+ *
+ * **************************************************************************
+ */
+
+MachineMailbox::MachineMailbox( )
+{
+}
+
+MachineMailbox::~MachineMailbox( )
+{
+}
+
+void MachineMailbox::init( )
+{
+  OSMboxInit(&oMbox, NULL);
+}
+
+bool MachineMailbox::post(void * pvLocalMessage)
+{
+  return OSMboxPost(&oMbox, pvLocalMessage) == OS_NO_ERR;
+}
+
+void * MachineMailbox::pend( )
+{
+  BYTE err;
+
+  return OSMboxPend(&oMbox, 0, &err);
+}
+
+MachineSignal::MachineSignal( )
+{
+}
+
+MachineSignal::~MachineSignal( )
+{
+}
+
+void MachineSignal::init( )
+{
+  OSSemInit(&oSem, 0);
+}
+
+void MachineSignal::post( )
+{
+  OSSemPost(&oSem);
+}
+
+void MachineSignal::pend( )
+{
+  OSSemPend(&oSem, 0);
+}
+
+const char * MachineRuntime::getName( )
+{
+  return "uC/OS";
+}
+
+bool MachineRuntime::createTask(void (*pfTask)(void *), void * pvArgument,
+                                DWORD * pdwStack, unsigned long ulStackWords,
+                                int iPriority)
+{
+  return OSTaskCreate(pfTask,
+                      pvArgument,
+                      (void *) &pdwStack[ulStackWords],
+                      (void *) pdwStack,
+                      iPriority) == OS_NO_ERR;
+}
+
+void MachineRuntime::delay(unsigned long ulTicks)
+{
+  OSTimeDly(ulTicks);
+}
+
+unsigned long MachineRuntime::microseconds( )
+{
+  return TimeTick * (1000000UL / TICKS_PER_SECOND);
+}
+
+int MachineRuntime::openSerial(int iPort, unsigned long ulBaud)
+{
+  SerialClose( iPort );
+  return OpenSerial( iPort, ulBaud, 2, 8, eParityNone );
+}
+
+bool MachineRuntime::waitReadable(int iDescriptor, unsigned long ulTicks)
+{
+  fd_set read_fds;
+
+  FD_ZERO( &read_fds );
+  FD_SET( iDescriptor, &read_fds );
+
+  if ( select( FD_SETSIZE,
+               &read_fds,
+               ( fd_set * ) 0,
+               ( fd_set * ) 0,
+               ulTicks ) )
+  {
+    return FD_ISSET( iDescriptor, &read_fds );
+  }
+
+  return false;
+}
+
+void MachineRuntime::dumpTasks( )
+{
+  OSDumpTCBStacks();
+  OSDumpTasks();
+}
+
+MachineMapping::MachineMapping( )
+{
+  pucBytes = NULL;
+  ulSize   = 0;
+}
+
+MachineMapping::~MachineMapping( )
+{
+}
+
+bool MachineMapping::map(const char * pcPath)
+{
+  /* warn that there is no file system to map from */
+  iprintf("Unable to map %s on the %s runtime\n", pcPath,
+          MachineRuntime::getName( ));
+  return false;
+}
+
+void MachineMapping::unmap( )
+{
+}
+
+const unsigned char * MachineMapping::getBytes( ) const
+{
+  return pucBytes;
+}
+
+unsigned long MachineMapping::getSize( ) const
+{
+  return ulSize;
+}
+
+#else
+
+/*
+ * **************************************************************************
+ *
+ *     POSIX backend
+ *
+ * **************************************************************************
+ */
+
+/* thread entry adapting the uC/OS task signature */
+struct MachineTaskStart
+{
+  void (*pfTask)(void *);
+  void * pvArgument;
+};
+
+static void * startTask(void * pvStart)
+{
+  MachineTaskStart oStart = *(MachineTaskStart *)pvStart;
+
+  delete (MachineTaskStart *)pvStart;
+  oStart.pfTask(oStart.pvArgument);
+
+  return NULL;
+}
+
+MachineMailbox::MachineMailbox( )
+{
+  pvMessage = NULL;
+  bFull     = false;
+
+  pthread_mutex_init(&oMutex, NULL);
+  pthread_cond_init(&oPosted, NULL);
+}
+
+/* like the uC/OS objects, the primitives are never destroyed:  at    */
+/* exit, static instances may still have forever-running tasks pended */
+/* on them, and destroying a condition variable with waiters blocks    */
+MachineMailbox::~MachineMailbox( )
+{
+}
+
+void MachineMailbox::init( )
+{
+  pthread_mutex_lock(&oMutex);
+  pvMessage = NULL;
+  bFull     = false;
+  pthread_mutex_unlock(&oMutex);
+}
+
+bool MachineMailbox::post(void * pvLocalMessage)
+{
+  bool bPosted = false;
+
+  pthread_mutex_lock(&oMutex);
+  if (!bFull)
+  {
+    pvMessage = pvLocalMessage;
+    bFull     = true;
+    bPosted   = true;
+    pthread_cond_signal(&oPosted);
+  }
+  pthread_mutex_unlock(&oMutex);
+
+  return bPosted;
+}
+
+void * MachineMailbox::pend( )
+{
+  void * pvReceived;
+
+  pthread_mutex_lock(&oMutex);
+  while (!bFull)
+  {
+    pthread_cond_wait(&oPosted, &oMutex);
+  }
+
+  pvReceived = pvMessage;
+  pvMessage  = NULL;
+  bFull      = false;
+  pthread_mutex_unlock(&oMutex);
+
+  return pvReceived;
+}
+
+MachineSignal::MachineSignal( )
+{
+  ulCount = 0;
+
+  pthread_mutex_init(&oMutex, NULL);
+  pthread_cond_init(&oPosted, NULL);
+}
+
+MachineSignal::~MachineSignal( )
+{
+}
+
+void MachineSignal::init( )
+{
+  pthread_mutex_lock(&oMutex);
+  ulCount = 0;
+  pthread_mutex_unlock(&oMutex);
+}
+
+void MachineSignal::post( )
+{
+  pthread_mutex_lock(&oMutex);
+  ulCount++;
+  pthread_cond_signal(&oPosted);
+  pthread_mutex_unlock(&oMutex);
+}
+
+void MachineSignal::pend( )
+{
+  pthread_mutex_lock(&oMutex);
+  while (ulCount == 0)
+  {
+    pthread_cond_wait(&oPosted, &oMutex);
+  }
+  ulCount--;
+  pthread_mutex_unlock(&oMutex);
+}
+
+const char * MachineRuntime::getName( )
+{
+  return "POSIX";
+}
+
+bool MachineRuntime::createTask(void (*pfTask)(void *), void * pvArgument,
+                                DWORD * pdwStack, unsigned long ulStackWords,
+                                int iPriority)
+{
+  MachineTaskStart * poStart = new MachineTaskStart;
+  pthread_t oThread;
+
+  /* threads take the default stack & scheduling */
+  (void)pdwStack;
+  (void)ulStackWords;
+  (void)iPriority;
+
+  poStart->pfTask     = pfTask;
+  poStart->pvArgument = pvArgument;
+
+  if (pthread_create(&oThread, NULL, startTask, poStart))
+  {
+    delete poStart;
+    return false;
+  }
+
+  pthread_detach(oThread);
+
+  return true;
+}
+
+void MachineRuntime::delay(unsigned long ulTicks)
+{
+  usleep((useconds_t)(ulTicks * (1000000UL / TICKS_PER_SECOND)));
+}
+
+unsigned long MachineRuntime::microseconds( )
+{
+  struct timespec oNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &oNow);
+
+  return (unsigned long)oNow.tv_sec * 1000000UL +
+         (unsigned long)(oNow.tv_nsec / 1000);
+}
+
+int MachineRuntime::openSerial(int iPort, unsigned long ulBaud)
+{
+  const char * pcDevice = getenv(MACHINE_SERIAL_DEVICE);
+  int iDescriptor;
+
+  /* writes never block, as on a UART with nothing attached */
+  if (pcDevice)
+  {
+    iDescriptor = open(pcDevice, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  }
+  else
+  {
+    iDescriptor = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if ((iDescriptor >= 0) &&
+        (grantpt(iDescriptor) || unlockpt(iDescriptor)))
+    {
+      close(iDescriptor);
+      iDescriptor = -1;
+    }
+
+    if (iDescriptor >= 0)
+    {
+      fcntl(iDescriptor, F_SETFL, fcntl(iDescriptor, F_GETFL) | O_NONBLOCK);
+      pcDevice = ptsname(iDescriptor);
+    }
+  }
+
+  if (iDescriptor < 0)
+  {
+    /* warn that the port could not be opened */
+    printf("Unable to open device driver port %d within ", iPort);
+    printf("MachineRuntime::openSerial( )\n");
+    return -1;
+  }
+
+  /* raw bytes, no echo or line editing */
+  struct termios oTerminal;
+
+  if (tcgetattr(iDescriptor, &oTerminal) == 0)
+  {
+    cfmakeraw(&oTerminal);
+    tcsetattr(iDescriptor, TCSANOW, &oTerminal);
+  }
+
+  printf("Device driver port %d (%lu baud):  %s\n", iPort, ulBaud, pcDevice);
+
+  return iDescriptor;
+}
+
+bool MachineRuntime::waitReadable(int iDescriptor, unsigned long ulTicks)
+{
+  fd_set read_fds;
+  struct timeval oTimeout;
+
+  if (iDescriptor < 0)
+  {
+    delay(ulTicks);
+    return false;
+  }
+
+  FD_ZERO( &read_fds );
+  FD_SET( iDescriptor, &read_fds );
+  oTimeout.tv_sec  = ulTicks / TICKS_PER_SECOND;
+  oTimeout.tv_usec = (ulTicks % TICKS_PER_SECOND) * (1000000L / TICKS_PER_SECOND);
+
+  if ( select( iDescriptor + 1, &read_fds, NULL, NULL, &oTimeout ) > 0 )
+  {
+    return FD_ISSET( iDescriptor, &read_fds );
+  }
+
+  return false;
+}
+
+void MachineRuntime::dumpTasks( )
+{
+  iprintf("Task list is not available on the %s runtime\n", getName( ));
+}
+
+MachineMapping::MachineMapping( )
+{
+  pucBytes = NULL;
+  ulSize   = 0;
+}
+
+MachineMapping::~MachineMapping( )
+{
+  unmap( );
+}
+
+bool MachineMapping::map(const char * pcPath)
+{
+  struct stat oStat;
+  void * pvMapped;
+  int iDescriptor;
+
+  unmap( );
+
+  iDescriptor = open(pcPath, O_RDONLY);
+
+  if (iDescriptor < 0)
+  {
+    return false;
+  }
+
+  if ((fstat(iDescriptor, &oStat) != 0) || (oStat.st_size <= 0))
+  {
+    close(iDescriptor);
+    return false;
+  }
+
+  /* shared & read-only:  pages come straight from the page cache */
+  pvMapped = mmap(NULL, (size_t)oStat.st_size, PROT_READ, MAP_SHARED,
+                  iDescriptor, 0);
+
+  /* the mapping outlives the descriptor */
+  close(iDescriptor);
+
+  if (pvMapped == MAP_FAILED)
+  {
+    /* warn that the file could not be mapped */
+    iprintf("Unable to map %s within MachineMapping::map( )\n", pcPath);
+    return false;
+  }
+
+  pucBytes = (const unsigned char *)pvMapped;
+  ulSize   = (unsigned long)oStat.st_size;
+
+  return true;
+}
+
+void MachineMapping::unmap( )
+{
+  if (pucBytes)
+  {
+    munmap((void *)pucBytes, ulSize);
+  }
+
+  pucBytes = NULL;
+  ulSize   = 0;
+}
+
+const unsigned char * MachineMapping::getBytes( ) const
+{
+  return pucBytes;
+}
+
+unsigned long MachineMapping::getSize( ) const
+{
+  return ulSize;
+}
+
+#endif  // #if MACHINE_RUNTIME == MACHINE_RUNTIME_RTOS
@@ -0,0 +1,224 @@
+/***************************************************
+ *
+ * 	MachineRuntime.h
+ *
+ *	operating system services used by the
+ *	engine (tasks, mailboxes, delays & the
+ *	device driver port), backed by uC/OS on
+ *	the target or by POSIX on hosts
+ *
+ **************************************************/
+
+  #ifndef MACHINERUNTIME_H
+  #define MACHINERUNTIME_H 1
+
+  /* runtime backends, selected at build time with MACHINE_RUNTIME */
+  #define MACHINE_RUNTIME_RTOS   0
+  #define MACHINE_RUNTIME_POSIX  1
+
+  #ifndef MACHINE_RUNTIME
+  #if defined(__unix__) || defined(__APPLE__)
+  #define MACHINE_RUNTIME  MACHINE_RUNTIME_POSIX
+  #else
+  #define MACHINE_RUNTIME  MACHINE_RUNTIME_RTOS
+  #endif
+  #endif
+
+  #if MACHINE_RUNTIME == MACHINE_RUNTIME_RTOS
+
+  /* RTOS/HW specific include files */
+  #include "predef.h"
+  #include "string.h"
+  #include <basictypes.h>
+  #include <constants.h>
+  #include <stdio.h>
+  #include <stdlib.h>
+  #include <ucos.h>
+  #include <serial.h>
+  #include <cfinter.h>
+  #include <startnet.h>
+
+  #else
+
+  #include <string.h>
+  #include <stdio.h>
+  #include <stdlib.h>
+  #include <pthread.h>
+  #include <unistd.h>
+
+  /* the NetBurner types & constants the engine is written against */
+  typedef unsigned char  BYTE;
+  typedef unsigned short WORD;
+  typedef unsigned long  DWORD;
+
+  #ifndef TRUE
+  #define TRUE   1
+  #define FALSE  0
+  #endif
+
+  #define iprintf             printf
+  #define MAIN_PRIO           50
+  #define USER_TASK_STK_SIZE  2048
+
+  /* the target tick;  a faster tick paces the canned data faster */
+  #ifndef TICKS_PER_SECOND
+  #define TICKS_PER_SECOND    20
+  #endif
+
+  /* environment variable naming the host device driver port;  when */
+  /* it is not set, a pseudo-terminal is opened and its name printed */
+  #define MACHINE_SERIAL_DEVICE  "MACHINE_SERIAL_DEVICE"
+
+  #endif  // #if MACHINE_RUNTIME == MACHINE_RUNTIME_RTOS
+
+  /* single message mailbox with the uC/OS semantics:  post( ) fails */
+  /* while a message is waiting, pend( ) blocks until one arrives     */
+  class MachineMailbox
+  {
+  public:
+		MachineMailbox( );
+		~MachineMailbox( );
+        void init( );
+        bool post(void * pvLocalMessage);
+        void * pend( );
+
+  private:
+  #if MACHINE_RUNTIME == MACHINE_RUNTIME_RTOS
+        OS_MBOX         oMbox;
+  #else
+        pthread_mutex_t oMutex;
+        pthread_cond_t  oPosted;
+        void *          pvMessage;
+        bool            bFull;
+  #endif
+  };
+
+  /* counting wakeup:  post( ) never blocks, pend( ) blocks until */
+  /* the count is non-zero and then takes one                      */
+  class MachineSignal
+  {
+  public:
+		MachineSignal( );
+		~MachineSignal( );
+        void init( );
+        void post( );
+        void pend( );
+
+  private:
+  #if MACHINE_RUNTIME == MACHINE_RUNTIME_RTOS
+        OS_SEM          oSem;
+  #else
+        pthread_mutex_t oMutex;
+        pthread_cond_t  oPosted;
+        unsigned long   ulCount;
+  #endif
+  };
+
+  /* ordered access to an index shared by exactly two tasks:  the  */
+  /* load sees every write made before the matching store          */
+  #if MACHINE_RUNTIME == MACHINE_RUNTIME_RTOS
+  /* uC/OS runs on one core, so only the compiler may reorder */
+  inline unsigned long machineLoadAcquire(const volatile unsigned long * pulValue)
+  {
+    unsigned long ulValue = *pulValue;
+
+    __asm__ __volatile__("" : : : "memory");
+    return ulValue;
+  }
+
+  inline void machineStoreRelease(volatile unsigned long * pulValue,
+                                  unsigned long ulValue)
+  {
+    __asm__ __volatile__("" : : : "memory");
+    *pulValue = ulValue;
+  }
+
+  /* returns the old value;  any number of tasks may increment */
+  inline unsigned long machineFetchIncrement(volatile unsigned long * pulValue)
+  {
+    unsigned long ulValue;
+
+    OSLock( );
+    ulValue = (*pulValue)++;
+    OSUnlock( );
+    return ulValue;
+  }
+
+  /* no load or store moves across it, in either direction */
+  inline void machineFullFence( )
+  {
+    __asm__ __volatile__("" : : : "memory");
+  }
+  #else
+  inline unsigned long machineLoadAcquire(const volatile unsigned long * pulValue)
+  {
+    return __atomic_load_n(pulValue, __ATOMIC_ACQUIRE);
+  }
+
+  inline void machineStoreRelease(volatile unsigned long * pulValue,
+                                  unsigned long ulValue)
+  {
+    __atomic_store_n(pulValue, ulValue, __ATOMIC_RELEASE);
+  }
+
+  inline unsigned long machineFetchIncrement(volatile unsigned long * pulValue)
+  {
+    return __atomic_fetch_add(pulValue, 1UL, __ATOMIC_RELAXED);
+  }
+
+  inline void machineFullFence( )
+  {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  }
+  #endif
+
+  /* read-only view of a whole file:  on POSIX hosts the pages are   */
+  /* mapped shared, so every process mapping the same file uses one   */
+  /* copy of them in the page cache;  the RTOS backend has no files   */
+  class MachineMapping
+  {
+  public:
+		MachineMapping( );
+		~MachineMapping( );
+        bool map(const char * pcPath);
+        void unmap( );
+
+        /* page aligned start of the file, NULL while nothing is mapped */
+        const unsigned char * getBytes( ) const;
+        unsigned long getSize( ) const;
+
+  private:
+        const unsigned char * pucBytes;
+        unsigned long         ulSize;
+  };
+
+  class MachineRuntime
+  {
+  public:
+        static const char * getName( );
+
+        /* runs pfTask(pvArgument) as a task of its own;  the stack & */
+        /* priority are used by the RTOS backend only                 */
+        static bool createTask(void (*pfTask)(void *), void * pvArgument,
+                               DWORD * pdwStack, unsigned long ulStackWords,
+                               int iPriority);
+
+        /* suspends the calling task for ulTicks system ticks */
+        static void delay(unsigned long ulTicks);
+
+        /* free-running microsecond clock for measuring intervals;  it */
+        /* wraps, so only differences are meaningful, and on the RTOS  */
+        /* backend it advances a whole tick at a time                  */
+        static unsigned long microseconds( );
+
+        /* file descriptor of the device driver port, or -1 */
+        static int openSerial(int iPort, unsigned long ulBaud);
+
+        /* true once iDescriptor is readable, false after ulTicks */
+        static bool waitReadable(int iDescriptor, unsigned long ulTicks);
+
+        /* task list & stacks, where the backend can provide them */
+        static void dumpTasks( );
+  };
+
+  #endif  // #ifndef MACHINERUNTIME_H
@@ -0,0 +1,212 @@
+/***************************************************
+ *
+ * 	MachineScalar.h
+ *
+ *	numeric type of the network:  double,
+ *	float, or MachineFixed (saturating
+ *	Q-format fixed point), selected by
+ *	MACHINE_NUMERIC_MODE
+ *
+ **************************************************/
+
+  #ifndef MACHINESCALAR_H
+  #define MACHINESCALAR_H 1
+
+  #include <math.h>
+
+  #define MACHINE_NUMERIC_DOUBLE  0
+  #define MACHINE_NUMERIC_FLOAT   1
+  #define MACHINE_NUMERIC_FIXED   2
+
+  /* build flag:  double reproduces the original arithmetic */
+  #ifndef MACHINE_NUMERIC_MODE
+  #define MACHINE_NUMERIC_MODE    MACHINE_NUMERIC_DOUBLE
+  #endif
+
+  /* Q4.27 by default:  weights saturate at +/-16 (the format limit */
+  /* takes the place of checkWeightBoundary( )), nets saturate where */
+  /* the sigmoid is flat anyway, and the resolution (7.5e-9) still   */
+  /* resolves momentum & learning rate sized weight changes          */
+  #ifndef MACHINE_FIXED_FRACTION_BITS
+  #define MACHINE_FIXED_FRACTION_BITS 27
+  #endif
+
+  class MachineFixed
+  {
+  public:
+        MachineFixed( )                 { lRaw = 0; }
+        MachineFixed(int iValue)        { lRaw = saturate((long long)iValue <<
+                                                 MACHINE_FIXED_FRACTION_BITS); }
+        MachineFixed(double dValue)     { lRaw = fromDouble(dValue); }
+
+        double toDouble( ) const
+        {
+          return (double)lRaw / (double)(1L << MACHINE_FIXED_FRACTION_BITS);
+        }
+
+        /* the Q-format value itself, for integer-only table lookups */
+        long getRaw( ) const            { return lRaw; }
+        static MachineFixed fromRaw(long lValue)
+        {
+          MachineFixed oResult;
+          oResult.lRaw = saturate(lValue);
+          return oResult;
+        }
+
+        MachineFixed & operator+=(const MachineFixed & oOther)
+        {
+          lRaw = saturate((long long)lRaw + oOther.lRaw);
+          return *this;
+        }
+        MachineFixed & operator-=(const MachineFixed & oOther)
+        {
+          lRaw = saturate((long long)lRaw - oOther.lRaw);
+          return *this;
+        }
+        MachineFixed & operator*=(const MachineFixed & oOther)
+        {
+          lRaw = multiply(lRaw, oOther.lRaw);
+          return *this;
+        }
+        MachineFixed operator-( ) const
+        {
+          MachineFixed oResult;
+          oResult.lRaw = saturate(-(long long)lRaw);
+          return oResult;
+        }
+
+        friend MachineFixed operator+(MachineFixed oA, const MachineFixed & oB)
+        {
+          return oA += oB;
+        }
+        friend MachineFixed operator-(MachineFixed oA, const MachineFixed & oB)
+        {
+          return oA -= oB;
+        }
+        friend MachineFixed operator*(MachineFixed oA, const MachineFixed & oB)
+        {
+          return oA *= oB;
+        }
+        friend MachineFixed operator/(const MachineFixed & oA, const MachineFixed & oB)
+        {
+          MachineFixed oResult;
+          if (oB.lRaw == 0)
+          {
+            oResult.lRaw = (oA.lRaw < 0) ? MINIMUM_RAW : MAXIMUM_RAW;
+          }
+          else
+          {
+            oResult.lRaw = saturate(((long long)oA.lRaw <<
+                                     MACHINE_FIXED_FRACTION_BITS) / oB.lRaw);
+          }
+          return oResult;
+        }
+
+        friend bool operator==(const MachineFixed & oA, const MachineFixed & oB)
+        {
+          return oA.lRaw == oB.lRaw;
+        }
+        friend bool operator!=(const MachineFixed & oA, const MachineFixed & oB)
+        {
+          return oA.lRaw != oB.lRaw;
+        }
+        friend bool operator<(const MachineFixed & oA, const MachineFixed & oB)
+        {
+          return oA.lRaw < oB.lRaw;
+        }
+        friend bool operator>(const MachineFixed & oA, const MachineFixed & oB)
+        {
+          return oA.lRaw > oB.lRaw;
+        }
+        friend bool operator<=(const MachineFixed & oA, const MachineFixed & oB)
+        {
+          return oA.lRaw <= oB.lRaw;
+        }
+        friend bool operator>=(const MachineFixed & oA, const MachineFixed & oB)
+        {
+          return oA.lRaw >= oB.lRaw;
+        }
+
+  private:
+        static const long MAXIMUM_RAW =  0x7FFFFFFFL;
+        static const long MINIMUM_RAW = -0x7FFFFFFFL - 1;
+
+        static long saturate(long long llValue)
+        {
+          if (llValue > MAXIMUM_RAW)
+          {
+            return MAXIMUM_RAW;
+          }
+          if (llValue < MINIMUM_RAW)
+          {
+            return MINIMUM_RAW;
+          }
+          return (long)llValue;
+        }
+
+        static long multiply(long lA, long lB)
+        {
+          /* round to nearest, then saturate */
+          long long llProduct = (long long)lA * lB;
+          llProduct += 1LL << (MACHINE_FIXED_FRACTION_BITS - 1);
+          return saturate(llProduct >> MACHINE_FIXED_FRACTION_BITS);
+        }
+
+        static long fromDouble(double dValue)
+        {
+          double dScaled = dValue * (double)(1L << MACHINE_FIXED_FRACTION_BITS);
+
+          if (dScaled >= (double)MAXIMUM_RAW)
+          {
+            return MAXIMUM_RAW;
+          }
+          if (dScaled <= (double)MINIMUM_RAW)
+          {
+            return MINIMUM_RAW;
+          }
+          return (long)((dScaled < 0) ? dScaled - 0.5 : dScaled + 0.5);
+        }
+
+        long lRaw;   /* only the low 32 bits are ever used */
+  };
+
+  #if MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_FIXED
+  typedef MachineFixed MachineScalar;
+  #elif MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_FLOAT
+  typedef float        MachineScalar;
+  #else
+  typedef double       MachineScalar;
+  #endif
+
+  /* conversion for display, error totals & the host-side tools */
+  inline double machineToDouble(double dValue)
+  {
+    return dValue;
+  }
+  inline double machineToDouble(float fValue)
+  {
+    return fValue;
+  }
+  inline double machineToDouble(const MachineFixed & oValue)
+  {
+    return oValue.toDouble( );
+  }
+
+  /* logistic activation in the precision of each type */
+  inline double machineSigmoid(double dNet)
+  {
+    return 1 / ( 1 + exp(-1 * dNet) );
+  }
+  inline float machineSigmoid(float fNet)
+  {
+    return 1 / ( 1 + expf(-1 * fNet) );
+  }
+  /* reference only:  on an FPU-less target this is a soft-float exp( ) */
+  /* per unit, so fixed point builds activate from the lookup table by   */
+  /* default (MACHINE_ACTIVATION_DEFAULT), indexed in integer arithmetic */
+  inline MachineFixed machineSigmoid(const MachineFixed & oNet)
+  {
+    return MachineFixed(1 / ( 1 + exp(-1 * oNet.toDouble( )) ));
+  }
+
+  #endif  // #ifndef MACHINESCALAR_H
@@ -0,0 +1,166 @@
+/***************************************************
+ *
+ *  MachineSchedule.cpp
+ *
+ *  MachineSchedule class - learning rate
+ *		schedules & plateau detection driven by
+ *		the epoch error, used by the
+ *		MachineVariables class.
+ *
+ **************************************************/
+#include <math.h>
+#include "MachineSchedule.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+MachineSchedule::MachineSchedule( )
+{
+  iMode      = MACHINE_SCHEDULE_DEFAULT_MODE;
+  usPeriod   = MACHINE_SCHEDULE_DEFAULT_PERIOD;
+  dFactor    = MACHINE_SCHEDULE_DEFAULT_FACTOR;
+  dMinimum   = MACHINE_SCHEDULE_DEFAULT_MINIMUM;
+  usPatience = MACHINE_PLATEAU_DEFAULT_PATIENCE;
+  dDelta     = MACHINE_PLATEAU_DEFAULT_DELTA;
+  usStall    = MACHINE_PLATEAU_DEFAULT_STALL;
+
+  reset( );
+}
+
+void MachineSchedule::configure(int iLocalMode, unsigned short usLocalPeriod,
+                                double dLocalFactor, double dLocalMinimum)
+{
+  iMode    = iLocalMode;
+  usPeriod = usLocalPeriod ? usLocalPeriod : 1;
+  dFactor  = dLocalFactor;
+  dMinimum = dLocalMinimum;
+
+  reset( );
+}
+
+void MachineSchedule::setPlateau(unsigned short usLocalPatience,
+                                 double dLocalDelta,
+                                 unsigned short usLocalStall)
+{
+  usPatience = usLocalPatience ? usLocalPatience : 1;
+  dDelta     = dLocalDelta;
+  usStall    = usLocalStall;
+
+  reset( );
+}
+
+void MachineSchedule::reset( )
+{
+  dScale        = 1;
+  dBestError    = 0;
+  bBest         = false;
+  usIdle        = 0;
+  usPlateauIdle = 0;
+  bStalled      = false;
+}
+
+bool MachineSchedule::endEpoch(unsigned long ulEpoch, double dEpochError)
+{
+  /* progress, measured against the best epoch rather than the last, */
+  /* so an error wandering up & down inside the delta is no progress */
+  if (!bBest || (dEpochError < dBestError - dDelta))
+  {
+    dBestError    = dEpochError;
+    bBest         = true;
+    usIdle        = 0;
+    usPlateauIdle = 0;
+  }
+  else
+  {
+    usIdle++;
+    usPlateauIdle++;
+  }
+
+  bStalled = (usStall != 0) && (usIdle >= usStall);
+
+  if (iMode == MACHINE_SCHEDULE_PLATEAU)
+  {
+    if (usPlateauIdle >= usPatience)
+    {
+      dScale        = dScale * dFactor;
+      usPlateauIdle = 0;
+    }
+
+    dScale = (dScale < dMinimum) ? dMinimum : dScale;
+  }
+  else
+  {
+    dScale = scheduledScale(ulEpoch);
+  }
+
+  return !bStalled;
+}
+
+void MachineSchedule::resume(unsigned long ulEpoch)
+{
+  reset( );
+
+  if (iMode != MACHINE_SCHEDULE_PLATEAU)
+  {
+    dScale = scheduledScale(ulEpoch);
+  }
+}
+
+double MachineSchedule::scheduledScale(unsigned long ulEpoch) const
+{
+  double dLocalScale;
+
+  switch (iMode)
+  {
+    case MACHINE_SCHEDULE_STEP:
+      dLocalScale = pow(dFactor, (double)(ulEpoch / usPeriod));
+      break;
+
+    case MACHINE_SCHEDULE_COSINE:
+    {
+      double dPhase = (ulEpoch < usPeriod) ? (double)ulEpoch / usPeriod : 1.0;
+
+      dLocalScale = dMinimum + (1 - dMinimum) * (1 + cos(M_PI * dPhase)) / 2;
+      break;
+    }
+
+    case MACHINE_SCHEDULE_RESTARTS:
+    {
+      /* periods of P, 2P, 4P, ... epochs, each from the full rate */
+      unsigned long ulCycle = usPeriod;
+      unsigned long ulStart = 0;
+
+      while (ulEpoch >= ulStart + ulCycle)
+      {
+        ulStart += ulCycle;
+        ulCycle *= 2;
+      }
+
+      dLocalScale = dMinimum + (1 - dMinimum) *
+                    (1 + cos(M_PI * (double)(ulEpoch - ulStart) / ulCycle)) / 2;
+      break;
+    }
+
+    default:
+      dLocalScale = 1;
+      break;
+  }
+
+  return (dLocalScale < dMinimum) ? dMinimum : dLocalScale;
+}
+
+double MachineSchedule::getScale( ) const
+{
+  return dScale;
+}
+
+bool MachineSchedule::isStalled( ) const
+{
+  return bStalled;
+}
+
+unsigned short MachineSchedule::getIdleEpochs( ) const
+{
+  return usIdle;
+}
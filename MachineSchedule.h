@@ -0,0 +1,91 @@
+/***************************************************
+ *
+ * 	MachineSchedule.h
+ *
+ *	learning rate schedule fed by the error of
+ *	each training epoch:  step decay, cosine,
+ *	warm restarts or reduce-on-plateau, and
+ *	the stall check that ends training early
+ *
+ **************************************************/
+
+  #ifndef MACHINESCHEDULE_H
+  #define MACHINESCHEDULE_H 1
+
+  /* learning rate schedules, see MachineParameters::setSchedule( );      */
+  /* each scales the optimizer's rate, starting from 1 at the first epoch */
+  /*   CONSTANT - the optimizer's rate throughout                         */
+  /*   STEP     - times the factor every period epochs                    */
+  /*   COSINE   - down a half cosine to the minimum over period epochs    */
+  /*   RESTARTS - the cosine, restarted with a doubled period each time   */
+  /*              the minimum is reached                                  */
+  /*   PLATEAU  - times the factor whenever the epoch error has not       */
+  /*              improved for the plateau patience                       */
+  #define MACHINE_SCHEDULE_CONSTANT  0
+  #define MACHINE_SCHEDULE_STEP      1
+  #define MACHINE_SCHEDULE_COSINE    2
+  #define MACHINE_SCHEDULE_RESTARTS  3
+  #define MACHINE_SCHEDULE_PLATEAU   4
+
+  /* defaults:  the original constant rate, no early stop */
+  #define MACHINE_SCHEDULE_DEFAULT_MODE      MACHINE_SCHEDULE_CONSTANT
+  #define MACHINE_SCHEDULE_DEFAULT_PERIOD    20
+  #define MACHINE_SCHEDULE_DEFAULT_FACTOR    0.5
+  #define MACHINE_SCHEDULE_DEFAULT_MINIMUM   0.01
+
+  /* an epoch improves on the best so far when its error is lower by */
+  /* more than the minimum delta;  training stalls after the given   */
+  /* epochs without improvement (0 never stalls)                     */
+  #define MACHINE_PLATEAU_DEFAULT_PATIENCE   10
+  #define MACHINE_PLATEAU_DEFAULT_DELTA      0.5
+  #define MACHINE_PLATEAU_DEFAULT_STALL      0
+
+  class MachineSchedule
+  {
+  public:
+		MachineSchedule( );
+        void configure(int iLocalMode, unsigned short usLocalPeriod,
+                       double dLocalFactor, double dLocalMinimum);
+        void setPlateau(unsigned short usLocalPatience, double dLocalDelta,
+                        unsigned short usLocalStall);
+
+        /* back to the first epoch, keeping the configuration */
+        void reset( );
+
+        /* picks up after ulEpoch epochs (a loaded checkpoint):  the */
+        /* timed schedules continue, plateau detection starts over   */
+        void resume(unsigned long ulEpoch);
+
+        /* error of the epoch just completed, ulEpoch of them so far;  */
+        /* false once training has stalled                             */
+        bool endEpoch(unsigned long ulEpoch, double dEpochError);
+
+        /* factor on the optimizer's rate for the next epoch */
+        double getScale( ) const;
+        bool   isStalled( ) const;
+
+        /* epochs since the error last improved */
+        unsigned short getIdleEpochs( ) const;
+
+  private:
+        /* rate scale of the timed schedules after ulEpoch epochs */
+        double scheduledScale(unsigned long ulEpoch) const;
+
+        int            iMode;
+        unsigned short usPeriod;
+        double         dFactor;
+        double         dMinimum;
+
+        unsigned short usPatience;
+        double         dDelta;
+        unsigned short usStall;
+
+        double         dScale;
+        double         dBestError;
+        bool           bBest;          /* dBestError holds an epoch's error */
+        unsigned short usIdle;         /* epochs without improvement        */
+        unsigned short usPlateauIdle;  /* the same, since the last decay    */
+        bool           bStalled;
+  };
+
+  #endif  // #ifndef MACHINESCHEDULE_H
@@ -0,0 +1,288 @@
+/***************************************************
+ *
+ *  MachineTrace.cpp
+ *
+ *  MachineTrace class - records hot loop
+ *		events into a ring instead of printing
+ *		them, and renders dumps of the ring.
+ *
+ **************************************************/
+#include "MachineTrace.h"
+
+#define TRACE_VERSION     2
+#define TRACE_BYTE_ORDER  0x01020304U
+
+/* dumps are rendered on the host that wrote them, or one of the */
+/* same byte order, which the header records                     */
+struct MachineTraceHeader
+{
+  unsigned char  aucMagic[4];     /* "MSTR" */
+  unsigned short usVersion;
+  unsigned short usRecordBytes;
+  unsigned int   uiByteOrder;
+  unsigned int   uiRecords;       /* records following the header */
+  unsigned int   uiOverwritten;   /* older records lost to the ring */
+};
+
+/* the ring index wraps with a mask */
+typedef char MachineTraceRecordsCheck
+  [((MACHINE_TRACE_RECORDS & (MACHINE_TRACE_RECORDS - 1)) == 0) ? 1 : -1];
+typedef char MachineTraceRecordCheck
+  [(sizeof(MachineTraceRecord) == 20) ? 1 : -1];
+typedef char MachineTraceValueCheck
+  [(sizeof(float) == sizeof(unsigned int)) ? 1 : -1];
+
+volatile unsigned long MachineTrace::ulNext = 0;
+unsigned int           MachineTrace::uiLevels = MACHINE_TRACE_ALL;
+MachineTraceSlot       MachineTrace::aoSlots[MACHINE_TRACE_RECORDS];
+
+/* record ulIndex of the ring, or false (and a cleared record) when */
+/* its slot is being written or already holds a later record        */
+static bool copySlot(const MachineTraceSlot & oSlot, unsigned long ulIndex,
+                     MachineTraceRecord & oRecord)
+{
+  unsigned long ulSequence = machineLoadAcquire(&oSlot.ulSequence);
+  unsigned long aulWords[4];
+
+  for (int w = 0; w < 4; w++)
+  {
+    aulWords[w] = machineLoadAcquire(&oSlot.aulWords[w]);
+  }
+
+  memset(&oRecord, 0, sizeof(oRecord));
+
+  /* a writer that started meanwhile has changed the sequence */
+  if ((ulSequence != ulIndex + 1) ||
+      (machineLoadAcquire(&oSlot.ulSequence) != ulSequence))
+  {
+    return false;
+  }
+
+  unsigned int uiValue = (unsigned int)aulWords[3];
+
+  oRecord.uiTimestamp = (unsigned int)aulWords[0];
+  oRecord.usEvent     = (unsigned short)(aulWords[1] & 0xFFFF);
+  oRecord.usIndex     = (unsigned short)(aulWords[1] >> 16);
+  oRecord.uiData      = (unsigned int)aulWords[2];
+  memcpy(&oRecord.fValue, &uiValue, sizeof(oRecord.fValue));
+  oRecord.uiSequence  = (unsigned int)ulSequence;
+
+  return true;
+}
+
+void MachineTrace::setLevels(unsigned int uiLocalLevels)
+{
+  uiLevels = uiLocalLevels;
+}
+
+unsigned int MachineTrace::getLevels( )
+{
+  return uiLevels;
+}
+
+void MachineTrace::record(unsigned short usEvent, unsigned short usIndex,
+                          unsigned int uiData, float fValue)
+{
+  /* each caller claims its own index;  a slot is shared only by */
+  /* indices a whole ring apart                                   */
+  unsigned long ulIndex = machineFetchIncrement(&ulNext);
+  MachineTraceSlot & oSlot = aoSlots[ulIndex & (MACHINE_TRACE_RECORDS - 1)];
+  unsigned int uiValue;
+
+  memcpy(&uiValue, &fValue, sizeof(uiValue));
+
+  /* readers skip the slot until its sequence is published again */
+  machineStoreRelease(&oSlot.ulSequence, 0);
+  machineStoreRelease(&oSlot.aulWords[0],
+                      (unsigned int)MachineRuntime::microseconds( ));
+  machineStoreRelease(&oSlot.aulWords[1],
+                      usEvent | ((unsigned long)usIndex << 16));
+  machineStoreRelease(&oSlot.aulWords[2], uiData);
+  machineStoreRelease(&oSlot.aulWords[3], uiValue);
+  machineStoreRelease(&oSlot.ulSequence, ulIndex + 1);
+}
+
+void MachineTrace::reset( )
+{
+  for (int r = 0; r < MACHINE_TRACE_RECORDS; r++)
+  {
+    machineStoreRelease(&aoSlots[r].ulSequence, 0);
+  }
+
+  machineStoreRelease(&ulNext, 0);
+}
+
+unsigned long MachineTrace::getDumpSize( )
+{
+  unsigned long ulRecords = machineLoadAcquire(&ulNext);
+
+  if (ulRecords > MACHINE_TRACE_RECORDS)
+  {
+    ulRecords = MACHINE_TRACE_RECORDS;
+  }
+
+  return sizeof(MachineTraceHeader) + ulRecords * sizeof(MachineTraceRecord);
+}
+
+unsigned long MachineTrace::dump(unsigned char * pucBuffer,
+                                 unsigned long ulCapacity)
+{
+  unsigned long ulNextLocal = machineLoadAcquire(&ulNext);
+  unsigned long ulRecords = (ulNextLocal > MACHINE_TRACE_RECORDS) ?
+                            MACHINE_TRACE_RECORDS : ulNextLocal;
+  unsigned long ulBytes = sizeof(MachineTraceHeader) +
+                          ulRecords * sizeof(MachineTraceRecord);
+  MachineTraceHeader oHeader;
+
+  if (ulCapacity < ulBytes)
+  {
+    /* warn that the buffer cannot hold the dump */
+    printf("Trace dump needs %lu bytes within MachineTrace::dump( )\n", ulBytes);
+    return 0;
+  }
+
+  memcpy(oHeader.aucMagic, "MSTR", 4);
+  oHeader.usVersion     = TRACE_VERSION;
+  oHeader.usRecordBytes = sizeof(MachineTraceRecord);
+  oHeader.uiByteOrder   = TRACE_BYTE_ORDER;
+  oHeader.uiRecords     = (unsigned int)ulRecords;
+  oHeader.uiOverwritten = (unsigned int)(ulNextLocal - ulRecords);
+  memcpy(pucBuffer, &oHeader, sizeof(oHeader));
+  pucBuffer += sizeof(oHeader);
+
+  /* oldest first;  records still being written or already */
+  /* overwritten are left cleared, with sequence 0           */
+  for (unsigned long r = ulNextLocal - ulRecords; r < ulNextLocal; r++)
+  {
+    MachineTraceRecord oRecord;
+
+    copySlot(aoSlots[r & (MACHINE_TRACE_RECORDS - 1)], r, oRecord);
+    memcpy(pucBuffer, &oRecord, sizeof(oRecord));
+    pucBuffer += sizeof(oRecord);
+  }
+
+  return ulBytes;
+}
+
+bool MachineTrace::render(const unsigned char * pucDump, unsigned long ulBytes)
+{
+  MachineTraceHeader oHeader;
+  unsigned int uiFirst   = 0;
+  unsigned int uiShown   = 0;
+  unsigned int uiSkipped = 0;
+
+  if (ulBytes < sizeof(oHeader))
+  {
+    /* warn that this is not a trace dump */
+    printf("Truncated trace dump within MachineTrace::render( )\n");
+    return false;
+  }
+
+  memcpy(&oHeader, pucDump, sizeof(oHeader));
+
+  if (memcmp(oHeader.aucMagic, "MSTR", 4) ||
+      (oHeader.usVersion     != TRACE_VERSION) ||
+      (oHeader.usRecordBytes != sizeof(MachineTraceRecord)) ||
+      (oHeader.uiByteOrder   != TRACE_BYTE_ORDER) ||
+      (ulBytes < sizeof(oHeader) +
+                 (unsigned long)oHeader.uiRecords * sizeof(MachineTraceRecord)))
+  {
+    /* warn that the dump was written by another version or host */
+    printf("Unsupported trace dump within MachineTrace::render( )\n");
+    return false;
+  }
+
+  printf("%u events, %u older events overwritten\n",
+         oHeader.uiRecords, oHeader.uiOverwritten);
+
+  for (unsigned int r = 0; r < oHeader.uiRecords; r++)
+  {
+    MachineTraceRecord oRecord;
+
+    memcpy(&oRecord, pucDump + sizeof(oHeader) + r * sizeof(oRecord),
+           sizeof(oRecord));
+
+    /* record r of the dump is record uiOverwritten + r of the ring */
+    if (oRecord.uiSequence != oHeader.uiOverwritten + r + 1)
+    {
+      uiSkipped++;
+      continue;
+    }
+
+    if (!uiShown++)
+    {
+      uiFirst = oRecord.uiTimestamp;
+    }
+
+    /* microseconds since the first event shown (the clock wraps) */
+    printf("%10u us  ", oRecord.uiTimestamp - uiFirst);
+
+    switch (oRecord.usEvent)
+    {
+      case MACHINE_TRACE_FRAME_RECEIVED:
+        printf("frame received   0x%08x\n", oRecord.uiData);
+        break;
+
+      case MACHINE_TRACE_FRAME_DECODED:
+        printf("frame decoded    0x%08x\n", oRecord.uiData);
+        break;
+
+      case MACHINE_TRACE_FORWARD_DONE:
+        printf("forward done     decision 0x%02x\n", oRecord.uiData);
+        break;
+
+      case MACHINE_TRACE_OUTPUT:
+        printf("output #%u        %f\n", oRecord.usIndex, oRecord.fValue);
+        break;
+
+      case MACHINE_TRACE_ERROR:
+        printf("error #%u         %f\n", oRecord.usIndex, oRecord.fValue);
+        break;
+
+      case MACHINE_TRACE_EPOCH_END:
+        printf("epoch %u end      error %f\n", oRecord.uiData, oRecord.fValue);
+        break;
+
+      default:
+        printf("event %u         %u 0x%08x %f\n", oRecord.usEvent,
+               oRecord.usIndex, oRecord.uiData, oRecord.fValue);
+        break;
+    }
+  }
+
+  if (uiSkipped)
+  {
+    printf("%u incomplete events skipped\n", uiSkipped);
+  }
+
+  return true;
+}
+
+#if MACHINE_RUNTIME == MACHINE_RUNTIME_POSIX
+bool MachineTrace::dumpFile(const char * pcPath)
+{
+  /* records made while the buffer is filled are left out */
+  unsigned long ulCapacity = sizeof(MachineTraceHeader) +
+                             MACHINE_TRACE_RECORDS * sizeof(MachineTraceRecord);
+  unsigned char * pucBuffer = new unsigned char[ulCapacity];
+  unsigned long ulBytes = dump(pucBuffer, ulCapacity);
+  bool bSaved = false;
+  FILE * pFile = fopen(pcPath, "wb");
+
+  if (pFile)
+  {
+    bSaved = (fwrite(pucBuffer, 1, ulBytes, pFile) == ulBytes);
+    bSaved = (fclose(pFile) == 0) && bSaved;
+  }
+
+  delete [] pucBuffer;
+
+  if (!bSaved)
+  {
+    /* warn that the dump could not be written */
+    printf("Unable to write %s within MachineTrace::dumpFile( )\n", pcPath);
+  }
+
+  return bSaved;
+}
+#endif
@@ -0,0 +1,118 @@
+/***************************************************
+ *
+ * 	MachineTrace.h
+ *
+ *	binary flight recorder for the hot loop:
+ *	fixed-size, timestamped event records in
+ *	a ring, filtered by compile-time & runtime
+ *	level masks and rendered as text offline
+ *
+ **************************************************/
+
+  #ifndef MACHINETRACE_H
+  #define MACHINETRACE_H 1
+
+  #include "MachineRuntime.h"
+
+  /* trace levels, one bit each */
+  #define MACHINE_TRACE_FRAMES   0x01   /* frames received & decoded   */
+  #define MACHINE_TRACE_FORWARD  0x02   /* forward passes & decisions  */
+  #define MACHINE_TRACE_UNITS    0x04   /* every output activation     */
+  #define MACHINE_TRACE_ERRORS   0x08   /* every training output error */
+  #define MACHINE_TRACE_EPOCHS   0x10   /* epoch ends                  */
+  #define MACHINE_TRACE_ALL      0x1F
+
+  /* levels compiled in at all;  the others cost nothing, not even */
+  /* evaluating their arguments                                    */
+  #ifndef MACHINE_TRACE_LEVELS
+  #define MACHINE_TRACE_LEVELS   MACHINE_TRACE_ALL
+  #endif
+
+  /* records kept, the oldest overwritten first;  a power of two */
+  #ifndef MACHINE_TRACE_RECORDS
+  #define MACHINE_TRACE_RECORDS  1024
+  #endif
+
+  /* file written by hosts on the way out */
+  #ifndef MACHINE_TRACE_FILE
+  #define MACHINE_TRACE_FILE     "MachineTrace.bin"
+  #endif
+
+  /* events;  usIndex, uiData & fValue carry, per event:             */
+  #define MACHINE_TRACE_FRAME_RECEIVED  1   /* -, frame bits, -       */
+  #define MACHINE_TRACE_FRAME_DECODED   2   /* -, frame bits, -       */
+  #define MACHINE_TRACE_FORWARD_DONE    3   /* -, decision bitmap, -  */
+  #define MACHINE_TRACE_OUTPUT          4   /* output, -, activation  */
+  #define MACHINE_TRACE_ERROR           5   /* output, -, error       */
+  #define MACHINE_TRACE_EPOCH_END       6   /* -, epoch, epoch error  */
+
+  /* 20 bytes on every target;  record n of the ring carries sequence */
+  /* n + 1 once it is complete                                         */
+  struct MachineTraceRecord
+  {
+    unsigned int   uiTimestamp;   /* MachineRuntime::microseconds( ) */
+    unsigned short usEvent;
+    unsigned short usIndex;
+    unsigned int   uiData;
+    float          fValue;
+    unsigned int   uiSequence;
+  };
+
+  /* a record as the ring holds it:  every word is written with a  */
+  /* release store, the sequence last, so a reader copying the     */
+  /* slot with acquire loads sees each word whole                  */
+  struct MachineTraceSlot
+  {
+    volatile unsigned long aulWords[4];
+    volatile unsigned long ulSequence;
+  };
+
+  #define MACHINE_TRACE(uiLevel, usEvent, usIndex, uiData, fValue)          \
+    do                                                                      \
+    {                                                                       \
+      if ((MACHINE_TRACE_LEVELS & (uiLevel)) &&                             \
+          MachineTrace::isEnabled(uiLevel))                                 \
+      {                                                                     \
+        MachineTrace::record((usEvent), (usIndex), (uiData), (fValue));     \
+      }                                                                     \
+    } while (0)
+
+  /* any task may record;  a dump taken while others record leaves */
+  /* out the records still being written or already overwritten    */
+  class MachineTrace
+  {
+  public:
+        /* runtime mask, MACHINE_TRACE_ALL until changed */
+        static void setLevels(unsigned int uiLocalLevels);
+        static unsigned int getLevels( );
+        static bool isEnabled(unsigned int uiLevel)
+        {
+          return (uiLevels & uiLevel) != 0;
+        }
+
+        static void record(unsigned short usEvent, unsigned short usIndex,
+                           unsigned int uiData, float fValue);
+        /* only while no task records */
+        static void reset( );
+
+        /* the recorded events, oldest first, behind a short header;  */
+        /* bytes written, or 0 when ulCapacity is too small           */
+        static unsigned long getDumpSize( );
+        static unsigned long dump(unsigned char * pucBuffer,
+                                  unsigned long ulCapacity);
+
+        /* prints a dump as one line per event, skipping records */
+        /* whose sequence does not match their place in the ring */
+        static bool render(const unsigned char * pucDump, unsigned long ulBytes);
+
+  #if MACHINE_RUNTIME == MACHINE_RUNTIME_POSIX
+        static bool dumpFile(const char * pcPath);
+  #endif
+
+  private:
+        static volatile unsigned long ulNext;
+        static unsigned int           uiLevels;
+        static MachineTraceSlot       aoSlots[MACHINE_TRACE_RECORDS];
+  };
+
+  #endif  // #ifndef MACHINETRACE_H
@@ -0,0 +1,447 @@
+/***************************************************
+ *
+ *  MachineTrainer.cpp
+ *
+ *  MachineTrainer class -
+ *		data-parallel training of the network
+ *		held by the MachineVariables class,
+ *		spreading every batch over a pool of
+ *		POSIX threads (host builds only).
+ *
+ **************************************************/
+#include "MachineTrainer.h"
+
+#if MACHINE_HOST_TRAINER
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "MachineVariables.h"
+#include "MachineDecoder.h"
+
+/* bytes of one plane (Wts or WED) of a matrix */
+static unsigned long planeBytes(unsigned short usRows, unsigned short usStride)
+{
+  return (unsigned long)usRows * usStride * sizeof(MachineScalar);
+}
+
+/* pdSum[i] += pdAddend[i] over a whole plane */
+static void addPlane(MachineScalar * pdSum, const MachineScalar * pdAddend,
+                     unsigned long ulLength)
+{
+  for (unsigned long i = 0; i < ulLength; i++)
+  {
+    pdSum[i] += pdAddend[i];
+  }
+}
+
+MachineTrainerWorker::MachineTrainerWorker( )
+{
+  poTrainer = NULL;
+  usIndex   = 0;
+  bStarted  = false;
+  usFirst   = 0;
+  usCount   = 0;
+  dError    = 0;
+}
+
+MachineTrainer::MachineTrainer( )
+{
+  poVars       = NULL;
+  usThreads    = 0;
+  poWorkers    = NULL;
+  pucFrames    = NULL;
+  usFrameBytes = 0;
+  uiGeneration = 0;
+  usFinished   = 0;
+  bShutdown    = false;
+
+  pthread_mutex_init(&oMutex, NULL);
+  pthread_cond_init(&oStart, NULL);
+  pthread_cond_init(&oDone, NULL);
+}
+
+MachineTrainer::~MachineTrainer( )
+{
+  release( );
+
+  pthread_cond_destroy(&oDone);
+  pthread_cond_destroy(&oStart);
+  pthread_mutex_destroy(&oMutex);
+}
+
+bool MachineTrainer::configure(MachineVariables * poLocalVars,
+                               unsigned short usLocalThreads)
+{
+  release( );
+
+  if (!poLocalVars || !poLocalVars->poKernels || !poLocalVars->oInputToHidden.Wts)
+  {
+    /* warn that the network has not been initialized */
+    printf("Uninitialized network within MachineTrainer::configure( )\n");
+    return false;
+  }
+
+  if (poLocalVars->usRecurrentWindow)
+  {
+    /* warn that a recurrent network trains its sequence in step order, */
+    /* which slices of a batch on separate threads cannot keep          */
+    printf("Recurrent network within MachineTrainer::configure( )\n");
+    return false;
+  }
+
+  if (usLocalThreads == 0)
+  {
+    usLocalThreads = 1;
+  }
+  else if (usLocalThreads > MACHINE_TRAINER_MAX_THREADS)
+  {
+    usLocalThreads = MACHINE_TRAINER_MAX_THREADS;
+  }
+
+  poVars     = poLocalVars;
+  usThreads  = usLocalThreads;
+  poWorkers  = new MachineTrainerWorker[usThreads];
+
+  for (unsigned short w = 0; w < usThreads; w++)
+  {
+    poWorkers[w].poTrainer = this;
+    poWorkers[w].usIndex   = w;
+
+    if (!configureWorker(poWorkers[w]))
+    {
+      release( );
+      return false;
+    }
+  }
+
+  /* worker 0 runs on the calling thread */
+  uiGeneration = 0;
+  bShutdown    = false;
+
+  for (unsigned short w = 1; w < usThreads; w++)
+  {
+    if (pthread_create(&poWorkers[w].oThread, NULL, workerEntry, &poWorkers[w]))
+    {
+      /* warn that the thread pool could not be started */
+      printf("Unable to start worker %u within MachineTrainer::configure( )\n",
+             (unsigned int)w);
+      release( );
+      return false;
+    }
+    poWorkers[w].bStarted = true;
+  }
+
+  return true;
+}
+
+bool MachineTrainer::configureWorker(MachineTrainerWorker & oWorker)
+{
+  oWorker.oInputUnits.configure(poVars->oInputUnits.usLength);
+  oWorker.oHiddenUnits.configure(poVars->oHiddenUnits.usLength);
+  oWorker.oOutputUnits.configure(poVars->oOutputUnits.usLength);
+  oWorker.oInputToHidden.configure(poVars->oInputToHidden.usRows,
+                                   poVars->oInputToHidden.usColumns);
+  oWorker.oHiddenToOutput.configure(poVars->oHiddenToOutput.usRows,
+                                    poVars->oHiddenToOutput.usColumns);
+
+  oWorker.oArena.reserve(oWorker.oInputUnits.getBytes( ));
+  oWorker.oArena.reserve(oWorker.oHiddenUnits.getBytes( ));
+  oWorker.oArena.reserve(oWorker.oOutputUnits.getBytes( ));
+  oWorker.oArena.reserve(oWorker.oInputToHidden.getBytes( ));
+  oWorker.oArena.reserve(oWorker.oHiddenToOutput.getBytes( ));
+
+  if (!oWorker.oArena.allocate( ))
+  {
+    /* warn that the worker storage could not be allocated */
+    printf("Unable to allocate worker storage within ");
+    printf("MachineTrainer::configureWorker( )\n");
+    return false;
+  }
+
+  oWorker.oInputUnits.bind(&oWorker.oArena);
+  oWorker.oHiddenUnits.bind(&oWorker.oArena);
+  oWorker.oOutputUnits.bind(&oWorker.oArena);
+  oWorker.oInputToHidden.bind(&oWorker.oArena);
+  oWorker.oHiddenToOutput.bind(&oWorker.oArena);
+
+  /* Bias Nodes of Input & Hidden Layers */
+  oWorker.oInputUnits.Activation[0]  = 1.0;
+  oWorker.oHiddenUnits.Activation[0] = 1.0;
+
+  return true;
+}
+
+void MachineTrainer::release( )
+{
+  if (poWorkers)
+  {
+    pthread_mutex_lock(&oMutex);
+    bShutdown = true;
+    pthread_cond_broadcast(&oStart);
+    pthread_mutex_unlock(&oMutex);
+
+    for (unsigned short w = 1; w < usThreads; w++)
+    {
+      if (poWorkers[w].bStarted)
+      {
+        pthread_join(poWorkers[w].oThread, NULL);
+      }
+    }
+
+    /* DEALLOCATION of the worker arenas */
+    delete [] poWorkers;
+  }
+
+  poVars     = NULL;
+  usThreads  = 0;
+  poWorkers  = NULL;
+  bShutdown  = false;
+}
+
+unsigned short MachineTrainer::getThreads( ) const
+{
+  return usThreads;
+}
+
+double MachineTrainer::trainEpoch(const unsigned char * pucLocalFrames,
+                                  unsigned short usLocalFrameBytes,
+                                  unsigned short usCount)
+{
+  double dEpochError = 0;
+
+  if (!poWorkers)
+  {
+    /* warn that configure( ) has not succeeded */
+    printf("Unconfigured trainer within MachineTrainer::trainEpoch( )\n");
+    return 0;
+  }
+
+  /* samples left over from MachineVariables::train( ) form their */
+  /* own (short) batch, so no derivative is lost or counted twice  */
+  if (poVars->usBatchCount)
+  {
+    poVars->updateWeights( );
+    poVars->usBatchCount = 0;
+  }
+
+  /* workers copy every weight, including columns the sparse path left idle */
+  poVars->settleWeights( );
+
+  unsigned short usBatch = (poVars->usBatchSize == MACHINE_BATCH_EPOCH) ?
+                           usCount : poVars->usBatchSize;
+
+  pucFrames    = pucLocalFrames;
+  usFrameBytes = usLocalFrameBytes;
+
+  for (unsigned long ulFirst = 0; ulFirst < usCount; ulFirst += usBatch)
+  {
+    unsigned short usSamples = (unsigned short)
+          ((usCount - ulFirst < usBatch) ? usCount - ulFirst : usBatch);
+
+    trainBatch((unsigned short)ulFirst, usSamples);
+
+    /* worker errors summed in worker order, independent of timing */
+    for (unsigned short w = 0; w < usThreads; w++)
+    {
+      dEpochError += poWorkers[w].dError;
+    }
+  }
+
+  pucFrames = NULL;
+  poVars->EpochError += dEpochError;
+
+  return dEpochError;
+}
+
+void MachineTrainer::trainBatch(unsigned short usFirst, unsigned short usCount)
+{
+  /* contiguous slices, fixed by the thread count alone */
+  pthread_mutex_lock(&oMutex);
+
+  for (unsigned short w = 0; w < usThreads; w++)
+  {
+    unsigned short usBegin = (unsigned short)
+          (((unsigned long)usCount * w) / usThreads);
+    unsigned short usEnd   = (unsigned short)
+          (((unsigned long)usCount * (w + 1)) / usThreads);
+
+    poWorkers[w].usFirst = usFirst + usBegin;
+    poWorkers[w].usCount = usEnd - usBegin;
+  }
+
+  usFinished = 0;
+  uiGeneration++;
+  pthread_cond_broadcast(&oStart);
+  pthread_mutex_unlock(&oMutex);
+
+  computeSlice(poWorkers[0]);
+
+  pthread_mutex_lock(&oMutex);
+  while (usFinished < usThreads - 1)
+  {
+    pthread_cond_wait(&oDone, &oMutex);
+  }
+  pthread_mutex_unlock(&oMutex);
+
+  /* combined derivatives become the network's WED, then one update */
+  reduce( );
+
+  poVars->usBatchCount = usCount;
+  poVars->updateWeights( );
+  poVars->usBatchCount = 0;
+
+  /* the perturbation schedule still counts samples */
+  for (unsigned short n = 0; n < usCount; n++)
+  {
+    poVars->regularize( );
+  }
+}
+
+void MachineTrainer::reduce( )
+{
+  MachineWeightMatrix & oInputToHidden   = poVars->oInputToHidden;
+  MachineWeightMatrix & oHiddenToOutput  = poVars->oHiddenToOutput;
+
+  unsigned long ulInputToHidden  = (unsigned long)oInputToHidden.usRows *
+                                   oInputToHidden.usStride;
+  unsigned long ulHiddenToOutput = (unsigned long)oHiddenToOutput.usRows *
+                                   oHiddenToOutput.usStride;
+
+  /* pairwise tree:  w += w + 1, w += w + 2, w += w + 4, ... */
+  for (unsigned short usStep = 1; usStep < usThreads; usStep *= 2)
+  {
+    for (unsigned short w = 0; w + usStep < usThreads; w += 2 * usStep)
+    {
+      MachineTrainerWorker & oSum    = poWorkers[w];
+      MachineTrainerWorker & oAddend = poWorkers[w + usStep];
+
+      addPlane(oSum.oInputToHidden.WED, oAddend.oInputToHidden.WED,
+               ulInputToHidden);
+      addPlane(oSum.oHiddenToOutput.WED, oAddend.oHiddenToOutput.WED,
+               ulHiddenToOutput);
+    }
+  }
+
+  memcpy((void *)oInputToHidden.WED, poWorkers[0].oInputToHidden.WED,
+         planeBytes(oInputToHidden.usRows, oInputToHidden.usStride));
+  memcpy((void *)oHiddenToOutput.WED, poWorkers[0].oHiddenToOutput.WED,
+         planeBytes(oHiddenToOutput.usRows, oHiddenToOutput.usStride));
+
+  /* the combined derivatives are dense, so every input column updates */
+  poVars->touchColumns(NULL, 0);
+}
+
+void MachineTrainer::computeSlice(MachineTrainerWorker & oWorker)
+{
+  MachineVariables & oVars = *poVars;
+  unsigned short usInputs      = oWorker.oInputUnits.usLength - 1;
+  unsigned short usFrameInputs = oVars.ucInputVectorLength - 1;
+  unsigned short usDecoded     = (usInputs < usFrameInputs) ? usInputs : usFrameInputs;
+
+  /* the network's weights are read-only until every slice is done */
+  memcpy((void *)oWorker.oInputToHidden.Wts, oVars.oInputToHidden.Wts,
+         planeBytes(oWorker.oInputToHidden.usRows,
+                    oWorker.oInputToHidden.usStride));
+  memcpy((void *)oWorker.oHiddenToOutput.Wts, oVars.oHiddenToOutput.Wts,
+         planeBytes(oWorker.oHiddenToOutput.usRows,
+                    oWorker.oHiddenToOutput.usStride));
+  memset((void *)oWorker.oInputToHidden.WED, 0,
+         planeBytes(oWorker.oInputToHidden.usRows,
+                    oWorker.oInputToHidden.usStride));
+  memset((void *)oWorker.oHiddenToOutput.WED, 0,
+         planeBytes(oWorker.oHiddenToOutput.usRows,
+                    oWorker.oHiddenToOutput.usStride));
+
+  oWorker.dError = 0;
+
+  for (unsigned short n = oWorker.usFirst;
+       n < oWorker.usFirst + oWorker.usCount; n++)
+  {
+    const unsigned char * pucFrame = pucFrames + (unsigned long)n * usFrameBytes;
+
+    /* set input unit activation based on the frame (storePattern( ) layout) */
+    MachineBitDecoder::decode(pucFrame, usFrameBytes, 0, usDecoded,
+                              oWorker.oInputUnits.Activation + 1);
+
+    for (unsigned short i = usDecoded; i < usInputs; i++)
+    {
+      oWorker.oInputUnits.Activation[i + 1] = 0;
+    }
+
+    MachineModel::propagate(oVars.poKernels, oVars.oActivation,
+                            oWorker.oInputUnits, oWorker.oHiddenUnits, NULL,
+                            oWorker.oOutputUnits,
+                            oWorker.oInputToHidden, oWorker.oHiddenToOutput,
+                            NULL);
+
+    /* set output unit error based on difference */
+    /* between target and actual output values   */
+    for (unsigned short i = 0; i < oWorker.oOutputUnits.usLength; i++)
+    {
+      unsigned int uiBit = usFrameInputs + i;
+      int iTarget = (uiBit < (unsigned int)usFrameBytes * 8) ?
+                    ((pucFrame[uiBit >> 3] >> (uiBit & 7)) & 1) : 0;
+      MachineScalar localUnitError = iTarget -
+                                     oWorker.oOutputUnits.Activation[i];
+
+      oWorker.oOutputUnits.Error[i] = localUnitError;
+      oWorker.dError               += fabs(machineToDouble(localUnitError));
+    }
+
+    for (unsigned short i = 0; i < oWorker.oHiddenUnits.usLength; i++)
+    {
+      oWorker.oHiddenUnits.Error[i] = 0.0;
+    }
+
+    MachineVariables::backpropagate(oVars.oActivation,
+                                    oWorker.oInputUnits, oWorker.oHiddenUnits,
+                                    oWorker.oOutputUnits,
+                                    oWorker.oInputToHidden,
+                                    oWorker.oHiddenToOutput);
+  }
+}
+
+void * MachineTrainer::workerEntry(void * pvWorker)
+{
+  MachineTrainerWorker * poWorker = (MachineTrainerWorker *)pvWorker;
+
+  poWorker->poTrainer->workerLoop(*poWorker);
+
+  return NULL;
+}
+
+void MachineTrainer::workerLoop(MachineTrainerWorker & oWorker)
+{
+  unsigned int uiSeen = 0;
+
+  for (;;)
+  {
+    pthread_mutex_lock(&oMutex);
+    while ((uiGeneration == uiSeen) && !bShutdown)
+    {
+      pthread_cond_wait(&oStart, &oMutex);
+    }
+
+    if (bShutdown)
+    {
+      pthread_mutex_unlock(&oMutex);
+      return;
+    }
+
+    uiSeen = uiGeneration;
+    pthread_mutex_unlock(&oMutex);
+
+    computeSlice(oWorker);
+
+    pthread_mutex_lock(&oMutex);
+    if (++usFinished == usThreads - 1)
+    {
+      pthread_cond_signal(&oDone);
+    }
+    pthread_mutex_unlock(&oMutex);
+  }
+}
+
+#endif  // #if MACHINE_HOST_TRAINER
@@ -0,0 +1,114 @@
+/***************************************************
+ *
+ * 	MachineTrainer.h
+ *
+ *	host-side data-parallel trainer:  each
+ *	batch of patterns is split across a pool
+ *	of threads, each with private weight error
+ *	derivatives, combined by a fixed-order
+ *	tree reduction before the weight update
+ *
+ **************************************************/
+
+  #ifndef MACHINETRAINER_H
+  #define MACHINETRAINER_H 1
+
+  #include "MachineWeights.h"
+  #include "MachineRuntime.h"
+
+  /* the trainer needs POSIX threads, so it is built on hosts only */
+  #ifndef MACHINE_HOST_TRAINER
+  #if MACHINE_RUNTIME == MACHINE_RUNTIME_POSIX
+  #define MACHINE_HOST_TRAINER 1
+  #else
+  #define MACHINE_HOST_TRAINER 0
+  #endif
+  #endif
+
+  #if MACHINE_HOST_TRAINER
+
+  #include <pthread.h>
+
+  #define MACHINE_TRAINER_MAX_THREADS  64
+
+  class MachineVariables;
+  class MachineTrainer;
+
+  /* per-thread state:  unit vectors, a copy of the weights taken at */
+  /* the start of each batch, and the private WED planes, all within */
+  /* the worker's own arena so no two threads share a cache line     */
+  class MachineTrainerWorker
+  {
+  public:
+		MachineTrainerWorker( );
+
+        MachineTrainer *    poTrainer;
+        unsigned short      usIndex;
+        pthread_t           oThread;
+        bool                bStarted;
+
+        /* slice of the current batch & its summed absolute error */
+        unsigned short      usFirst;
+        unsigned short      usCount;
+        double              dError;
+
+        MachineArena        oArena;
+        MachineUnitVector   oInputUnits;
+        MachineUnitVector   oHiddenUnits;
+        MachineUnitVector   oOutputUnits;
+        MachineWeightMatrix oInputToHidden;
+        MachineWeightMatrix oHiddenToOutput;
+  };
+
+  /* feed-forward networks only:  a recurrent network (see          */
+  /* MachineParameters::setRecurrentWindow( )) trains in step order */
+  /*                                                                 */
+  /* results depend on the thread count (the reduction tree is shaped */
+  /* by it) but never on thread timing:  every worker owns a fixed,    */
+  /* contiguous slice of each batch, and partial derivatives are        */
+  /* always added in the same order                                     */
+  class MachineTrainer
+  {
+  public:
+		MachineTrainer( );
+		~MachineTrainer( );
+        bool configure(MachineVariables * poLocalVars, unsigned short usLocalThreads);
+        void release( );
+
+        unsigned short getThreads( ) const;
+
+        /* one pass over usCount frames in the storePattern( ) layout    */
+        /* (inputs, then target outputs;  frame n at byte                */
+        /* n * usFrameBytes), updating the weights once per batch of the */
+        /* network's batch size;  returns the summed absolute output     */
+        /* error, which is also added to EpochError                      */
+        double trainEpoch(const unsigned char * pucFrames, unsigned short usFrameBytes,
+                          unsigned short usCount);
+
+  private:
+        static void * workerEntry(void * pvWorker);
+        void workerLoop(MachineTrainerWorker & oWorker);
+        bool configureWorker(MachineTrainerWorker & oWorker);
+        void computeSlice(MachineTrainerWorker & oWorker);
+        void trainBatch(unsigned short usFirst, unsigned short usCount);
+        void reduce( );
+
+        MachineVariables *     poVars;
+        unsigned short         usThreads;
+        MachineTrainerWorker * poWorkers;
+
+        /* current batch, published to the workers under oMutex */
+        const unsigned char *  pucFrames;
+        unsigned short         usFrameBytes;
+        unsigned int           uiGeneration;
+        unsigned short         usFinished;
+        bool                   bShutdown;
+
+        pthread_mutex_t        oMutex;
+        pthread_cond_t         oStart;
+        pthread_cond_t         oDone;
+  };
+
+  #endif  // #if MACHINE_HOST_TRAINER
+
+  #endif  // #ifndef MACHINETRAINER_H
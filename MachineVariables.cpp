@@ -19,10 +19,14 @@
 #define ENTRY_DEBUG        0
 #define MATH_DEBUG         0
 
-/* recurrent network flags */
-#define USING_RECURRENT_LAYER  0
+/* verify the selected forward pass kernel against the scalar kernel */
+#define KERNEL_CHECK       1
 
-/* define min & max weight values */
+/* report speed & accuracy of every activation type at initialize( ) */
+#define ACTIVATION_BENCHMARK  0
+
+/* define min & max weight values (MACHINE_NUMERIC_FIXED networks */
+/* are bounded by the saturating range of the fixed point format)  */
 #define MIN_WEIGHT_VALUE  -10.0
 #define MAX_WEIGHT_VALUE   10.0
 
@@ -32,6 +36,34 @@ MachineVariables::MachineVariables( )
   ucHiddenVectorLength = 0;
   ucOutputVectorLength = 0;
   EpochError           = 0; 
+  ulEpochs             = 0;
+  iKernelType          = MACHINE_KERNEL_AUTO;
+  poKernels            = NULL;
+  iActivationType      = MACHINE_ACTIVATION_DEFAULT;
+  dActivationErrorBound = MACHINE_ACTIVATION_ERROR_BOUND;
+  ulRandomSeed         = 0;
+  iPerturbMode         = MACHINE_PERTURB_DEFAULT_MODE;
+  ulPerturbInterval    = MACHINE_PERTURB_DEFAULT_INTERVAL;
+  dPerturbAmplitude    = MACHINE_PERTURB_DEFAULT_AMPLITUDE;
+  dPerturbDecay        = MACHINE_PERTURB_DEFAULT_DECAY;
+  ulTrainingSteps      = 0;
+  dPerturbCurrent      = 0;
+  iOptimizerType       = MACHINE_OPTIMIZER_MOMENTUM;
+  usBatchSize          = MACHINE_BATCH_ONLINE;
+  usBatchCount         = 0;
+  usEpochLength        = MACHINE_EPOCH_DEFAULT_LENGTH;
+  usRecurrentWindow    = 0;
+  pdHistory            = NULL;
+  usHistoryStride      = 0;
+  usHistoryNext        = 0;
+  usHistoryCount       = 0;
+  pdUnrollDelta        = NULL;
+  pdUnrollError        = NULL;
+  ulWeightUpdates      = 0;
+  pulColumnUpdates     = NULL;
+  pusTouched           = NULL;
+  usTouched            = 0;
+  pbTouched            = NULL;
 }
 
 MachineVariables::~MachineVariables( )
@@ -46,169 +78,203 @@ MachineVariables::~MachineVariables( )
 
 double MachineVariables::provideRandomUnitValue( )
 {
-  double random_value;
-
-  /* RNG * 10^-10 results in small positive pseudo-random value */
-  random_value = rand() *.000000001;
-    
-  /* 50% chance of changing sign of value */
-  if (rand() % 2)
-  {
-    random_value = random_value * -1;
-  }
-
   /* want random weight values between 1.0 and -1.0 */
-  random_value = (0.0 + random_value) / 2;
-
-  return random_value;  
+  return 2 * oRandom.uniform( ) - 1;
 }
 
 void MachineVariables::initialize( )
 {
   iprintf("MachineVariables::initialize( ) entry point\n");
   
-  int i, j, seed = 0;
-  BackpropagationNode *poTempBackpropagationNode;
+  int i, j;
 
-  /* initialize (or seed) random number generator */
-  seed = rand();
-  srand(seed);
+  /* seed the network's own generator;  without a configured seed */
+  /* it follows rand( ), as the network always has                */
+  oRandom.seed(ulRandomSeed ? ulRandomSeed : (unsigned long)rand( ));
+
+  ulTrainingSteps = 0;
+  ulEpochs        = 0;
+  dPerturbCurrent = dPerturbAmplitude;
+  usBatchCount    = 0;
   
-  /* ALLOCATION of memory for BackpropagationNode objects */
-  for (i = 0; i <= ucInputVectorLength; i++)
+  /* select the forward pass kernel for this CPU */
+  poKernels = MachineKernels::select(iKernelType);
+
+#if KERNEL_CHECK
+  if (poKernels->measureDeviation( ) > MACHINE_KERNEL_TOLERANCE)
   {
-    poTempBackpropagationNode = new BackpropagationNode( );
-    oInputLayer[i] = *poTempBackpropagationNode;
+    /* warn that the vector kernel is out of tolerance, use the reference */
+    printf("%s kernel exceeds tolerance, using scalar kernel\n",
+           poKernels->pcName);
+    poKernels = MachineKernels::select(MACHINE_KERNEL_SCALAR);
   }
-  
-  for (i = 0; i <= ucHiddenVectorLength; i++)
-  {
-    poTempBackpropagationNode = new BackpropagationNode( );
-    oHiddenLayer[i] = *poTempBackpropagationNode;
+#endif
+  printf("Forward pass kernel:  %s\n", poKernels->pcName);
+
+  /* activation & derivative (a failed table falls back to exact) */
+  oActivation.configure(iActivationType, dActivationErrorBound);
+  printf("Activation:  %s\n", oActivation.getName( ));
+
+  oOptimizer.configure(iOptimizerType);
+  printf("Optimizer:  %s\n", oOptimizer.getName( ));
+
+  oSchedule.reset( );
+  oOptimizer.setRateScale(oSchedule.getScale( ));
+
+#if ACTIVATION_BENCHMARK
+  MachineActivation::benchmark(dActivationErrorBound);
+#endif
+
+  /* size every layer, then ALLOCATION of one arena for the network */
+  oArena.release( );
+
+  pulColumnUpdates = NULL;
+  pusTouched       = NULL;
+  pbTouched        = NULL;
+
+  /* lazy update bookkeeping, one entry per input (bias included) */
+  unsigned long ulColumnBytes  = MachineArena::alignedBytes(
+                                   (ucInputVectorLength + 1) * sizeof(unsigned long));
+  unsigned long ulTouchedBytes = MachineArena::alignedBytes(
+                                   (ucInputVectorLength + 1) * sizeof(unsigned short));
+  unsigned long ulFlagBytes    = MachineArena::alignedBytes(
+                                   (ucInputVectorLength + 1) * sizeof(bool));
+
+  oInputUnits.configure(ucInputVectorLength + 1);
+  oHiddenUnits.configure(ucHiddenVectorLength + 1);
+  oOutputUnits.configure(ucOutputVectorLength);
+  oInputToHidden.configure(ucHiddenVectorLength + 1, ucInputVectorLength + 1);
+  oHiddenToOutput.configure(ucOutputVectorLength, ucHiddenVectorLength + 1);
+  oInputToHiddenState.configure(oInputToHidden, oOptimizer.getPlanes( ));
+  oHiddenToOutputState.configure(oHiddenToOutput, oOptimizer.getPlanes( ));
+
+  oArena.reserve(oInputUnits.getBytes( ));
+  oArena.reserve(oHiddenUnits.getBytes( ));
+  oArena.reserve(oOutputUnits.getBytes( ));
+  oArena.reserve(oInputToHidden.getBytes( ));
+  oArena.reserve(oHiddenToOutput.getBytes( ));
+  oArena.reserve(oInputToHiddenState.getBytes( ));
+  oArena.reserve(oHiddenToOutputState.getBytes( ));
+  oArena.reserve(ulColumnBytes);
+  oArena.reserve(ulTouchedBytes);
+  oArena.reserve(ulFlagBytes);
+
+  /* the context layer, its weights & the step history exist only */
+  /* in a recurrent network                                         */
+  oContextUnits.release( );
+  oContextToHidden.release( );
+  oContextToHiddenState.release( );
+  usHistoryStride = (ucInputVectorLength + 1) + 3 * (ucHiddenVectorLength + 1);
+
+  if (usRecurrentWindow)
+  {
+    oContextUnits.configure(ucHiddenVectorLength + 1);
+    oContextToHidden.configure(ucHiddenVectorLength + 1, ucHiddenVectorLength + 1);
+    oContextToHiddenState.configure(oContextToHidden, oOptimizer.getPlanes( ));
+
+    oArena.reserve(oContextUnits.getBytes( ));
+    oArena.reserve(oContextToHidden.getBytes( ));
+    oArena.reserve(oContextToHiddenState.getBytes( ));
+    oArena.reserve((unsigned long)usRecurrentWindow * usHistoryStride *
+                   sizeof(MachineScalar));
+    oArena.reserve(2 * (ucHiddenVectorLength + 1) * sizeof(MachineScalar));
   }
-  
-  for (i = 0; i <= ucHiddenVectorLength; i++)
+
+  if (!oArena.allocate( ))
   {
-    poTempBackpropagationNode = new BackpropagationNode( );
-    oContextLayer[i] = *poTempBackpropagationNode;
+    /* warn that the network storage could not be allocated */
+    iprintf("Unable to allocate network storage within ");
+    iprintf("MachineVariables::initialize( )\n");
+    return;
   }
-  
-  for (i = 0; i < ucOutputVectorLength; i++)
-  {
-    poTempBackpropagationNode = new BackpropagationNode( );
-    oOutputLayer[i] = *poTempBackpropagationNode;
+
+  oInputUnits.bind(&oArena);
+  oHiddenUnits.bind(&oArena);
+  oOutputUnits.bind(&oArena);
+  oInputToHidden.bind(&oArena);
+  oHiddenToOutput.bind(&oArena);
+  oInputToHiddenState.bind(&oArena);
+  oHiddenToOutputState.bind(&oArena);
+
+  /* the arena starts zeroed:  no column has missed an update */
+  pulColumnUpdates = (unsigned long *)oArena.carve(ulColumnBytes);
+  pusTouched       = (unsigned short *)oArena.carve(ulTouchedBytes);
+  pbTouched        = (bool *)oArena.carve(ulFlagBytes);
+
+  pdHistory     = NULL;
+  pdUnrollDelta = NULL;
+  pdUnrollError = NULL;
+
+  if (usRecurrentWindow)
+  {
+    oContextUnits.bind(&oArena);
+    oContextToHidden.bind(&oArena);
+    oContextToHiddenState.bind(&oArena);
+    pdHistory     = oArena.carve((unsigned long)usRecurrentWindow *
+                                 usHistoryStride * sizeof(MachineScalar));
+    pdUnrollDelta = oArena.carve(2 * (ucHiddenVectorLength + 1) *
+                                 sizeof(MachineScalar));
+    pdUnrollError = pdUnrollDelta + (ucHiddenVectorLength + 1);
   }
-  
+
+  usHistoryNext  = 0;
+  usHistoryCount = 0;
+
+  ulWeightUpdates = 0;
+  usTouched       = 0;
+
+#if ENTRY_DEBUG
+  printf("Network arena:  %lu bytes\n", oArena.getSize( ));
+#endif
+
+  /* all Net, Activation, Error, WED, DeltaWts & optimizer state     */
+  /* values start at zero;  weights are visited source unit first so  */
+  /* that the pseudo-random sequence does not depend on the layout    */
+
   /* Bias Node of Input Layer */
-  oInputLayer[0].Net = 0;
-  oInputLayer[0].Activation = 1.0;
-  oInputLayer[0].Error = 0;
+  oInputUnits.Activation[0] = 1.0;
 
-  for (j = 0; j <= ucHiddenVectorLength; j++)
-  {
-    /* assign pseudo-random value to weight vector data element */
-    oInputLayer[0].Wts[j] = provideRandomUnitValue( );
-    oInputLayer[0].WED[j] = 0.0;
-    oInputLayer[0].DeltaWts[j] = 0.0;
-  }
-  
-  /* Input Layer */
-  
-  for (i = 1; i <= ucInputVectorLength; i++)
+  /* Input Layer (including bias) to Hidden Layer weights */
+  for (i = 0; i <= ucInputVectorLength; i++)
   {
-    oInputLayer[i].Net = 0;
-    oInputLayer[i].Activation = 0;
-    oInputLayer[i].Error = 0;
     for (j = 0; j <= ucHiddenVectorLength; j++)
     {
       /* assign pseudo-random value to weight vector data element */
-      oInputLayer[i].Wts[j] = provideRandomUnitValue( );
-      oInputLayer[i].WED[j] = 0.0;
-      oInputLayer[i].DeltaWts[j] = 0.0;
+      oInputToHidden.rowWts(j)[i] = provideRandomUnitValue( );
     }
   }
   
   /* Bias Node of Hidden Layer */
-  oHiddenLayer[0].Net = 0;
-  oHiddenLayer[0].Activation = 1.0;
-  oHiddenLayer[0].Error = 0;
-
-  for (j = 0; j < ucOutputVectorLength; j++)
-  {
-    /* assign pseudo-random value to weight vector data element */
-    oHiddenLayer[0].Wts[j] = provideRandomUnitValue( );
-    oHiddenLayer[0].WED[j] = 0.0;
-    oHiddenLayer[0].DeltaWts[j] = 0.0;
-  }
+  oHiddenUnits.Activation[0] = 1.0;
 
-  /* Hidden Layer */
-  
-  for (i = 1; i <= ucHiddenVectorLength; i++)
+  /* Hidden Layer (including bias) to Output Layer weights */
+  for (i = 0; i <= ucHiddenVectorLength; i++)
   {
-    oHiddenLayer[i].Net = 0;
-    oHiddenLayer[i].Activation = 0;
-    oHiddenLayer[i].Error = 0; 
     for (j = 0; j < ucOutputVectorLength; j++)
     {
       /* assign pseudo-random value to weight vector data element */
-      oHiddenLayer[i].Wts[j] = provideRandomUnitValue( );
-      oHiddenLayer[i].WED[j] = 0.0;
-      oHiddenLayer[i].DeltaWts[j] = 0.0;
+      oHiddenToOutput.rowWts(j)[i] = provideRandomUnitValue( );
     }
   }
 
-#if USING_RECURRENT_LAYER
-  /* Context Layer */
-  for (i = 0; i <= ucHiddenVectorLength; i++)
+  /* Context Layer to Hidden Layer weights */
+  for (i = 0; usRecurrentWindow && (i <= ucHiddenVectorLength); i++)
   {
-    oContextLayer[i].Net = 0;
-    oContextLayer[i].Activation   = 0;
-    oContextLayer[i].Error = 0;
     for (j = 0; j <= ucHiddenVectorLength; j++)
     {
       /* assign pseudo-random value to weight vector data element */
-      oContextLayer[i].Wts[j] = provideRandomUnitValue( );
-      oContextLayer[i].WED[j] = 0.0;
-      oContextLayer[i].DeltaWts[j] = 0.0;
+      oContextToHidden.rowWts(j)[i] = provideRandomUnitValue( );
     }
   }
-#endif
-  
-  /* error vectors (for communication between iterate and training threads) */
-  for (i = 0; i < ucOutputVectorLength; i++)
-  {
-    oOutputLayer[i].Net = 0;
-    oOutputLayer[i].Activation = 0;
-    oOutputLayer[i].Error = 0;
-  }  
 }
 
-double MachineVariables::perturbWeight(double weightValue)
+MachineScalar MachineVariables::checkWeightBoundary(MachineScalar weightValue) const
 {
-#if 1
-  double resultingWeightValue, randomValue;
-
-  /* RNG * 10^-10 results in small positive pseudo-random value */
-  randomValue = rand() *.00000000001;
-    
-  /* 50% chance of changing sign of value */
-  if (rand() % 2)
-  {
-    randomValue = randomValue * -1;
-  }
-
-  /* set initial weights to maximal point of change (i.e., 0.5) */
-  resultingWeightValue = weightValue + randomValue;
-
-  return resultingWeightValue;  
-#else
+#if MACHINE_NUMERIC_MODE == MACHINE_NUMERIC_FIXED
+  /* the saturating arithmetic already bounded the weight */
   return weightValue;
-#endif
-}
-
-double MachineVariables::checkWeightBoundary(double weightValue)
-{
-  double resultingWeightValue;
+#else
+  MachineScalar resultingWeightValue;
   
   if (weightValue > MAX_WEIGHT_VALUE)
   {
@@ -223,63 +289,204 @@ double MachineVariables::checkWeightBoundary(double weightValue)
     resultingWeightValue = weightValue;
   }
   return resultingWeightValue;
+#endif
 }
 
 void MachineVariables::iterate( )
 {
-  /* set hidden unit activation based on input & recurrent layer activations */      
-  for (int i = 1; i <= ucHiddenVectorLength; i++)
+  MachineUnitVector   * poContextUnits    = NULL;
+  MachineWeightMatrix * poContextToHidden = NULL;
+  MachineScalar       * pdStep            = NULL;
+  unsigned short        usInput           = ucInputVectorLength + 1;
+  unsigned short        usHidden          = ucHiddenVectorLength + 1;
+
+  if (usRecurrentWindow)
+  {
+    poContextUnits    = &oContextUnits;
+    poContextToHidden = &oContextToHidden;
+
+    /* the step's input & the context it reads, before the forward */
+    /* pass moves the hidden activations into the context          */
+    pdStep = pdHistory + (unsigned long)usHistoryNext * usHistoryStride;
+    memcpy(pdStep, oInputUnits.Activation, usInput * sizeof(MachineScalar));
+    memcpy(pdStep + usInput, oContextUnits.Activation,
+           usHidden * sizeof(MachineScalar));
+  }
+
+  /* the forward pass reads the active input columns (all, when dense) */
+  unsigned short ausActive[MACHINE_SPARSE_MAX_ACTIVE];
+  unsigned short usActive = MachineModel::findActive(oInputUnits, ausActive);
+
+  settleColumns(ausActive, usActive);
+
+  /* same forward pass as the compiled (read-only) model */
+  MachineModel::propagate(poKernels, oActivation,
+                          oInputUnits, oHiddenUnits, poContextUnits,
+                          oOutputUnits, oInputToHidden, oHiddenToOutput,
+                          poContextToHidden);
+
+  if (pdStep)
   {
-    /* cumulative sum of input (in this case formal input) unit activations */
-    /* multiplied by weights creates hidden unit net                        */
-    for (int j = 0; j <= ucInputVectorLength; j++)
-    {
-      oHiddenLayer[i].Net += oInputLayer[j].Activation *
-                                     oInputLayer[j].Wts[i];
-    }
-#if USING_RECURRENT_LAYER
-    /* cumulative sum of input (in this case recurrent) unit activations */
-    /* multiplied by weights creates hidden unit net                     */
-    for (int j = 0; j <= ucHiddenVectorLength; j++)
+    memcpy(pdStep + usInput + usHidden, oHiddenUnits.Net,
+           usHidden * sizeof(MachineScalar));
+    memcpy(pdStep + usInput + 2 * usHidden, oHiddenUnits.Activation,
+           usHidden * sizeof(MachineScalar));
+
+    usHistoryNext = (usHistoryNext + 1) % usRecurrentWindow;
+
+    if (usHistoryCount < usRecurrentWindow)
     {
-      oHiddenLayer[i].Net += oContextLayer[j].Activation *
-                                     oContextLayer[j].Wts[i];
+      usHistoryCount++;
     }
-#endif
-    oHiddenLayer[i].Activation = 
-        1 / ( 1 + exp(-1 * oHiddenLayer[i].Net) );
-  }  
-
-#if USING_RECURRENT_LAYER
-  /* set context layer activation at time (t + 1) to be hidden layer */
-  /* activation at time (t)                                          */
-  for (int i = 1; i <= ucHiddenVectorLength; i++)
-  {
-    oContextLayer[i].Activation = oHiddenLayer[i].Activation;
   }
-#endif  
-  /* set output unit activation based on hidden activations & weight vectors */      
+
+#if MATH_DEBUG
   for (int i = 0; i < ucOutputVectorLength; i++)
   {
-    /* cumulative addition of hidden unit activations */
-    /* multiplied by weights creates output unit net  */
-    for (int j = 0; j <= ucHiddenVectorLength; j++)
-    {
-      oOutputLayer[i].Net += oHiddenLayer[j].Activation *
-                                     oHiddenLayer[j].Wts[i];
-    }
-    oOutputLayer[i].Activation = 
-        1 / ( 1 + exp(-1 * oOutputLayer[i].Net) );
-#if MATH_DEBUG
-    printf("NET: %f\n", oOutputLayer[i].Net);
-    printf("\n1 / ( 1 + exp(-1 * oOutputLayer[i].Net) ): %f\n\n",
-           ( 1 / ( 1 + exp(-1 * oOutputLayer[i].Net) ) ) );
-#endif
+    printf("NET: %f\n", machineToDouble(oOutputUnits.Net[i]));
+    printf("\n1 / ( 1 + exp(-1 * oOutputUnits.Net[i]) ): %f\n\n",
+           machineToDouble(machineSigmoid(oOutputUnits.Net[i])));
   }  
+#endif
 }
 
 void MachineVariables::train( )
 {
+    unsigned short usSamples = (usBatchSize == MACHINE_BATCH_EPOCH) ?
+                               usEpochLength : usBatchSize;
+
+    /* weight error derivatives sum over the batch;  the weights are */
+    /* only written (and clamped) once the batch is complete         */
+    accumulateGradients( );
+
+    if (++usBatchCount >= usSamples)
+    {
+      updateWeights( );
+      usBatchCount = 0;
+    }
+
+    resetUnits( true );
+    regularize( );
+}
+
+void MachineVariables::accumulateGradients( )
+{
+    /* only columns of non-zero inputs receive derivatives */
+    unsigned short ausActive[MACHINE_SPARSE_MAX_ACTIVE];
+    unsigned short usActive = MachineModel::findActive(oInputUnits, ausActive);
+
+    touchColumns(ausActive, usActive);
+
+    backpropagate(oActivation, oInputUnits, oHiddenUnits,
+                  oOutputUnits, oInputToHidden, oHiddenToOutput);
+
+    if (usRecurrentWindow)
+    {
+      backpropagateThroughTime( );
+    }
+}
+
+void MachineVariables::backpropagateThroughTime( )
+{
+    unsigned short usInput  = ucInputVectorLength + 1;
+    unsigned short usHidden = ucHiddenVectorLength + 1;
+    unsigned short usSlot   = (usHistoryNext + usRecurrentWindow - 1) %
+                              usRecurrentWindow;
+
+    /* the newest step is the current one, whose hidden deltas came */
+    /* from the output error                                        */
+    for (unsigned short i = 1; i < usHidden; i++)
+    {
+      pdUnrollDelta[i] = oHiddenUnits.Delta[i];
+    }
+
+    for (unsigned short s = 0; s < usHistoryCount; s++)
+    {
+      const MachineScalar * pdStep    = pdHistory +
+                                        (unsigned long)usSlot * usHistoryStride;
+      const MachineScalar * pdContext = pdStep + usInput;
+
+      /* context to hidden weight error derivatives of this step */
+      for (unsigned short j = 1; j < usHidden; j++)
+      {
+        MachineScalar* pdWED = oContextToHidden.rowWED(j);
+
+        for (unsigned short i = 1; i < usHidden; i++)
+        {
+          pdWED[i] += pdUnrollDelta[j] * pdContext[i];
+        }
+      }
+
+      /* input to hidden weight error derivatives of an earlier step; */
+      /* zero inputs contribute nothing                               */
+      for (unsigned short i = 0; (s > 0) && (i < usInput); i++)
+      {
+        if (machineToDouble(pdStep[i]) == 0)
+        {
+          continue;
+        }
+
+        touchColumns(&i, 1);
+
+        for (unsigned short j = 1; j < usHidden; j++)
+        {
+          oInputToHidden.rowWED(j)[i] += pdUnrollDelta[j] * pdStep[i];
+        }
+      }
+
+      if (s + 1 == usHistoryCount)
+      {
+        break;
+      }
+
+      /* the error of the step before reaches it through the context */
+      /* weights, the transpose of the forward product               */
+      for (unsigned short i = 1; i < usHidden; i++)
+      {
+        pdUnrollError[i] = 0.0;
+      }
+
+      for (unsigned short j = 1; j < usHidden; j++)
+      {
+        const MachineScalar* pdWts = oContextToHidden.rowWts(j);
+
+        for (unsigned short i = 1; i < usHidden; i++)
+        {
+          pdUnrollError[i] += pdUnrollDelta[j] * pdWts[i];
+        }
+      }
+
+      usSlot = (usSlot + usRecurrentWindow - 1) % usRecurrentWindow;
+      pdStep = pdHistory + (unsigned long)usSlot * usHistoryStride;
+
+      oActivation.delta(pdStep + usInput + usHidden + 1,
+                        pdStep + usInput + 2 * usHidden + 1,
+                        &pdUnrollError[1], &pdUnrollDelta[1], usHidden - 1);
+    }
+}
+
+void MachineVariables::resetHistory( )
+{
+    usHistoryNext  = 0;
+    usHistoryCount = 0;
+
+    for (unsigned short i = 0; i < oContextUnits.usLength; i++)
+    {
+      oContextUnits.Activation[i] = 0.0;
+    }
+}
+
+void MachineVariables::backpropagate(const MachineActivation & oActivation,
+                                     MachineUnitVector & oInputUnits,
+                                     MachineUnitVector & oHiddenUnits,
+                                     MachineUnitVector & oOutputUnits,
+                                     MachineWeightMatrix & oInputToHidden,
+                                     MachineWeightMatrix & oHiddenToOutput)
+{
+    unsigned short usInput  = oInputUnits.usLength;    /* including the bias */
+    unsigned short usHidden = oHiddenUnits.usLength;   /* including the bias */
+    unsigned short usOutput = oOutputUnits.usLength;
+
     /* first thing we do in backpropagation is set delta for each unit */
 
     /* Delta is equal to the error for the unit */
@@ -287,324 +494,360 @@ void MachineVariables::train( )
     /*     of the activation function           */
     
     /* set output layer delta based on output layer error*/
-    for (int j = 0; j < ucOutputVectorLength; j++)
-    {
-      /* the derivative of the activation function is the activation */
-      /*     of the unit multiplied by (one minus its activation)    */
-      oOutputLayer[j].Delta = oOutputLayer[j].Error *
-                                      oOutputLayer[j].Activation *
-                                      (1 - oOutputLayer[j].Activation);
-    }
+    oActivation.delta(oOutputUnits.Net, oOutputUnits.Activation,
+                      oOutputUnits.Error, oOutputUnits.Delta, usOutput);
 
     /* determine hidden layer error based on output layer delta */
-    for (int i = 0; i <= ucHiddenVectorLength; i++)
+    /*     (output rows in order, so each hidden unit sums its   */
+    /*     contributions in output unit order)                   */
+    for (int j = 0; j < usOutput; j++)
     {
-      for (int j = 0; j < ucOutputVectorLength; j++)
+      MachineScalar* pdWts = oHiddenToOutput.rowWts(j);
+
+      for (int i = 0; i < usHidden; i++)
       {
-        oHiddenLayer[i].Error += oOutputLayer[j].Delta *
-                                         oHiddenLayer[i].Wts[j];
+        oHiddenUnits.Error[i] += oOutputUnits.Delta[j] * pdWts[i];
       }
     }
     
     /* set hidden layer delta based on hidden layer error */
-    for (int j = 0; j <= ucHiddenVectorLength; j++)
-    {
-      /* the derivative of the activation function is the activation */
-      /*     of the unit multiplied by (one minus its activation)    */
-      oHiddenLayer[j].Delta = oHiddenLayer[j].Error *
-                                      oHiddenLayer[j].Activation *
-                                      (1 - oHiddenLayer[j].Activation);
-    }
+    /*     (the bias unit has a constant activation)       */
+    oHiddenUnits.Delta[0] = 0.0;
+    oActivation.delta(&oHiddenUnits.Net[1], &oHiddenUnits.Activation[1],
+                      &oHiddenUnits.Error[1], &oHiddenUnits.Delta[1],
+                      usHidden - 1);
 
     /* determine weight error derivatives for hidden to output layer weights */    
-    for (int i = 0; i <= ucHiddenVectorLength; i++)
+    for (int j = 0; j < usOutput; j++)
     {
-      for (int j = 0; j < ucOutputVectorLength; j++)
+      MachineScalar* pdWED = oHiddenToOutput.rowWED(j);
+
+      for (int i = 0; i < usHidden; i++)
       {
-        oHiddenLayer[i].WED[j] += oOutputLayer[j].Delta *
-                                          oHiddenLayer[i].Activation;
+        pdWED[i] += oOutputUnits.Delta[j] * oHiddenUnits.Activation[i];
       }
     }
     
     /* determine weight error derivatives for input to hidden layer weights */    
-    for (int i = 0; i <= ucInputVectorLength; i++)
+    /*     (zero inputs contribute nothing, so a sparse input layer only  */
+    /*     visits its active columns)                                     */
+    unsigned short ausActive[MACHINE_SPARSE_MAX_ACTIVE];
+    unsigned short usActive = MachineModel::findActive(oInputUnits, ausActive);
+
+    for (int j = 0; j < usHidden; j++)
     {
-      for (int j = 0; j <= ucHiddenVectorLength; j++)
+      MachineScalar* pdWED = oInputToHidden.rowWED(j);
+
+      if (usActive)
       {
-        oInputLayer[i].WED[j] += oHiddenLayer[j].Delta *
-                                         oInputLayer[i].Activation;
+        for (int a = 0; a < usActive; a++)
+        {
+          pdWED[ausActive[a]] += oHiddenUnits.Delta[j] *
+                                 oInputUnits.Activation[ausActive[a]];
+        }
+      }
+      else
+      {
+        for (int i = 0; i < usInput; i++)
+        {
+          pdWED[i] += oHiddenUnits.Delta[j] * oInputUnits.Activation[i];
+        }
       }
     }
+}
 
-#if USING_RECURRENT_LAYER
-    /* determine weight error derivatives for context to hidden layer weights */    
-    for (int i = 1; i <= ucHiddenVectorLength; i++)
+void MachineVariables::updateWeights( )
+{
+    unsigned short usSamples = (usBatchCount > 0) ? usBatchCount : 1;
+
+    /* optimizers other than momentum SGD move every weight on every */
+    /* update, so no column may sit one out                          */
+    if (!oOptimizer.isLazy( ))
     {
-      for (int j = 1; j <= ucHiddenVectorLength; j++)
-      {
-        oContextLayer[i].WED[j] += oHiddenLayer[j].Delta *
-                                           oContextLayer[i].Activation;
-      }
+      touchColumns(NULL, 0);
     }
-#endif
-    
-    /* use weight error derivatives to determine delta weights */
-    /*     for hidden to output layer weights                  */
-    for (int i = 0; i <= ucHiddenVectorLength; i++)
+
+    oOptimizer.beginUpdate(usSamples, ulWeightUpdates + 1);
+
+    /* use weight error derivatives to determine delta weights, */
+    /*     then use delta weights to set new weight values      */
+    /*     for hidden to output layer weights                   */
+    for (int j = 0; j < ucOutputVectorLength; j++)
     {
-      for (int j = 0; j < ucOutputVectorLength; j++)
-      {
-        double oldDeltaWeight = oHiddenLayer[i].DeltaWts[j];
-        
-        oHiddenLayer[i].DeltaWts[j] = 
-            LearningRate * oHiddenLayer[i].WED[j] +
-            Momentum     * oldDeltaWeight;
-      }
+      applySteps(oHiddenToOutput, oHiddenToOutputState, j,
+                 NULL, 0, ucHiddenVectorLength + 1);
     }
     
-    /* use weight error derivatives to determine delta weights */
-    /*     for input to hidden layer weights                   */
-    for (int i = 0; i <= ucInputVectorLength; i++)
+    /* use weight error derivatives to determine delta weights, */
+    /*     then use delta weights to set new weight values      */
+    /*     for input to hidden layer weights;  only the columns */
+    /*     given derivatives this batch are visited, after      */
+    /*     catching up on the updates they sat out              */
+    if (usTouched)
     {
-      for (int j = 0; j <= ucHiddenVectorLength; j++)
-      {
-        double oldDeltaWeight = oInputLayer[i].DeltaWts[j];
-        
-        oInputLayer[i].DeltaWts[j] = 
-            LearningRate * oInputLayer[i].WED[j] +
-            Momentum     * oldDeltaWeight;
-      }
+      settleColumns(pusTouched, usTouched);
     }
-    
-#if USING_RECURRENT_LAYER
-    /* use weight error derivatives to determine delta weights */
-    /*     for context to hidden layer weights                   */
-    for (int i = 1; i <= ucHiddenVectorLength; i++)
+
+    for (int j = 0; j <= ucHiddenVectorLength; j++)
     {
-      for (int j = 1; j <= ucHiddenVectorLength; j++)
-      {
-        double oldDeltaWeight = oContextLayer[i].DeltaWts[j];
-        
-        oContextLayer[i].DeltaWts[j] = 
-            LearningRate * oContextLayer[i].WED[j] +
-            Momentum     * oldDeltaWeight;
-      }
+      applySteps(oInputToHidden, oInputToHiddenState, j,
+                 pusTouched, 0, usTouched);
     }
-#endif
 
-    /* use delta weights to set new weight values */
-    /*     for hidden to output layer weights     */
-    for (int i = 0; i <= ucHiddenVectorLength; i++)
+    ulWeightUpdates++;
+
+    for (int t = 0; t < usTouched; t++)
     {
-      for (int j = 0; j < ucOutputVectorLength; j++)
-      {
-        oHiddenLayer[i].Wts[j] += oHiddenLayer[i].DeltaWts[j];
-        oHiddenLayer[i].Wts[j] = checkWeightBoundary(oHiddenLayer[i].Wts[j]);
-      }
+      pulColumnUpdates[pusTouched[t]] = ulWeightUpdates;
+      pbTouched[pusTouched[t]]        = false;
     }
+    usTouched = 0;
     
-    /* use delta weights to set new weight values */
-    /*     for input to hidden layer weights      */
-    for (int i = 0; i <= ucInputVectorLength; i++)
+    /* use weight error derivatives to determine delta weights, */
+    /*     then use delta weights to set new weight values      */
+    /*     for context to hidden layer weights                  */
+    for (int j = 1; usRecurrentWindow && (j <= ucHiddenVectorLength); j++)
     {
-      for (int j = 0; j <= ucHiddenVectorLength; j++)
-      {
-        oInputLayer[i].Wts[j] += oInputLayer[i].DeltaWts[j];
-        oInputLayer[i].Wts[j] = checkWeightBoundary(oInputLayer[i].Wts[j]);
-      }
+      applySteps(oContextToHidden, oContextToHiddenState, j,
+                 NULL, 1, ucHiddenVectorLength);
     }
-    
-#if USING_RECURRENT_LAYER
-    /* use delta weights to set new weight values */
-    /*     for context to hidden layer weights      */
-    for (int i = 1; i <= ucHiddenVectorLength; i++)
+}
+
+void MachineVariables::applySteps(MachineWeightMatrix & oMatrix,
+                                  MachineOptimizerState & oState,
+                                  unsigned short usRow,
+                                  const unsigned short * pusColumns,
+                                  unsigned short usFirst,
+                                  unsigned short usCount)
+{
+    MachineScalar* pdWts      = oMatrix.rowWts(usRow);
+    MachineScalar* pdWED      = oMatrix.rowWED(usRow);
+    MachineScalar* pdDeltaWts = oMatrix.rowDeltaWts(usRow);
+
+    oOptimizer.computeSteps(oMatrix, oState, usRow, pusColumns, usFirst, usCount);
+
+    /* derivatives are cleared as their weights update, so the next */
+    /* batch starts from zero                                       */
+    for (unsigned short c = 0; c < usCount; c++)
     {
-      for (int j = 1; j <= ucHiddenVectorLength; j++)
-      {
-        oContextLayer[i].Wts[j] += oContextLayer[i].DeltaWts[j];
-        oContextLayer[i].Wts[j] = checkWeightBoundary(oContextLayer[i].Wts[j]);
-      }
+      unsigned short i = pusColumns ? pusColumns[c] : usFirst + c;
+
+      pdWts[i] = checkWeightBoundary(pdWts[i] + pdDeltaWts[i]);
+
+      pdWED[i] = 0.0;
     }
-#endif
+}
 
-    for (int i = 0; i < ucOutputVectorLength; i++)
+void MachineVariables::settleColumns(const unsigned short * pusColumns,
+                                     unsigned short usColumns)
+{
+    unsigned short usCount = usColumns ? usColumns : ucInputVectorLength + 1;
+
+    if (!pulColumnUpdates)
     {
-      /* reset net for output layer weights    */
-      oOutputLayer[i].Net = 0.0;
+      return;
     }
 
-    for (int i = 0; i <= ucHiddenVectorLength; i++)
+    for (unsigned short c = 0; c < usCount; c++)
     {
-      /* reset net for hidden layer weights    */
-      /* reset error for hidden layer weights  */
-      oHiddenLayer[i].Net   = 0.0;
-      oHiddenLayer[i].Error = 0.0;
+      unsigned short i = usColumns ? pusColumns[c] : c;
+      unsigned long ulIdle = ulWeightUpdates - pulColumnUpdates[i];
 
-      for (int j = 0; j < ucOutputVectorLength; j++)
+      if (ulIdle == 0)
       {
-        /* reset weight error derivative values */
-        /*   for hidden to output layer weights */
-        oHiddenLayer[i].WED[j] = 0.0;
-        
-        /* perturb weight                       */
-        /*   for hidden to output layer weights */
-        oHiddenLayer[i].Wts[j] = perturbWeight(oHiddenLayer[i].Wts[j]);
+        continue;
+      }
+
+      /* the momentum closed form below does not describe the */
+      /* steps of other optimizers, whose columns never idle    */
+      if (!oOptimizer.isLazy( ))
+      {
+        pulColumnUpdates[i] = ulWeightUpdates;
+        continue;
+      }
+
+      /* each update without a derivative scales the delta weight by */
+      /* the momentum m and adds it, so n of them move the weight by  */
+      /* delta * (m + m^2 + ... + m^n);  the steps share one sign, so */
+      /* clamping once matches clamping after each step               */
+      const double dMomentum = MachineOptimizer::Momentum;
+      double dDecay = pow(dMomentum, (double)ulIdle);
+      const MachineScalar localDecay  = dDecay;
+      const MachineScalar localTravel = dMomentum * (1 - dDecay) / (1 - dMomentum);
+
+      for (unsigned short j = 0; j < oInputToHidden.usRows; j++)
+      {
+        unsigned long ulIndex = (unsigned long)j * oInputToHidden.usStride + i;
+        MachineScalar * pdWts      = oInputToHidden.Wts      + ulIndex;
+        MachineScalar * pdDeltaWts = oInputToHidden.DeltaWts + ulIndex;
+
+        *pdWts      = checkWeightBoundary(*pdWts + localTravel * *pdDeltaWts);
+        *pdDeltaWts = localDecay * *pdDeltaWts;
       }
+
+      pulColumnUpdates[i] = ulWeightUpdates;
+    }
+}
+
+void MachineVariables::settleWeights( )
+{
+    settleColumns(NULL, 0);
+}
+
+void MachineVariables::settledCopy(MachineScalar * pdWts) const
+{
+    if (!pulColumnUpdates)
+    {
+      return;
     }
 
-    for (int i = 0; i <= ucInputVectorLength; i++)
+    for (unsigned short i = 0; i <= ucInputVectorLength; i++)
     {
-      for (int j = 0; j <= ucHiddenVectorLength; j++)
+      unsigned long ulIdle = ulWeightUpdates - pulColumnUpdates[i];
+
+      if (ulIdle == 0)
+      {
+        continue;
+      }
+
+      /* as in settleColumns( ), only momentum columns idle */
+      if (!oOptimizer.isLazy( ))
+      {
+        continue;
+      }
+
+      /* the closed form of settleColumns( ) */
+      const double dMomentum = MachineOptimizer::Momentum;
+      double dDecay = pow(dMomentum, (double)ulIdle);
+      const MachineScalar localTravel = dMomentum * (1 - dDecay) / (1 - dMomentum);
+
+      for (unsigned short j = 0; j < oInputToHidden.usRows; j++)
       {
-        /* reset weight error derivative values */
-        /*   for input to hidden layer weights  */
-        oInputLayer[i].WED[j] = 0.0;
-        
-        /* perturb weight                       */
-        /*   for hidden to output layer weights */
-        oInputLayer[i].Wts[j] = perturbWeight(oInputLayer[i].Wts[j]);
+        unsigned long ulIndex = (unsigned long)j * oInputToHidden.usStride + i;
+
+        pdWts[ulIndex] = checkWeightBoundary(oInputToHidden.Wts[ulIndex] +
+                                             localTravel *
+                                             oInputToHidden.DeltaWts[ulIndex]);
       }
     }
-#if USING_RECURRENT_LAYER
-    for (int i = 0; i <= ucHiddenVectorLength; i++)
+}
+
+void MachineVariables::touchColumns(const unsigned short * pusColumns,
+                                    unsigned short usColumns)
+{
+    unsigned short usCount = usColumns ? usColumns : ucInputVectorLength + 1;
+
+    for (unsigned short c = 0; c < usCount; c++)
     {
-      /* reset error for hidden layer weights  */
-      oContextLayer[i].Net   = 0.0;
-      oContextLayer[i].Error = 0.0;
+      unsigned short i = usColumns ? pusColumns[c] : c;
 
-      for (int j = 0; j <= ucHiddenVectorLength; j++)
+      if (!pbTouched[i])
       {
-        /* reset weight error derivative values */
-        /*   for context to hidden layer weights  */
-        oContextLayer[i].WED[j] = 0.0;
-        
-        /* perturb weight                       */
-        /*   for hidden to output layer weights */
-        oContextLayer[i].Wts[j] = perturbWeight(oContextLayer[i].Wts[j]);
+        pbTouched[i]            = true;
+        pusTouched[usTouched++] = i;
       }
     }
-#endif
 }
 
-void MachineVariables::endOfIteration( )
+void MachineVariables::resetUnits( bool bIncludeContext )
 {
-/* this routine conducts cleanup typically done in train( )    */
-/* that was not being done when iterate( ) was used on its own */
     for (int i = 0; i < ucOutputVectorLength; i++)
     {
       /* reset net for output layer weights    */
-      oOutputLayer[i].Net = 0.0;
+      oOutputUnits.Net[i] = 0.0;
     }
 
     for (int i = 0; i <= ucHiddenVectorLength; i++)
     {
       /* reset net for hidden layer weights    */
       /* reset error for hidden layer weights  */
-      oHiddenLayer[i].Net   = 0.0;
-      oHiddenLayer[i].Error = 0.0;
-
-      for (int j = 0; j < ucOutputVectorLength; j++)
-      {
-        /* reset weight error derivative values */
-        /*   for hidden to output layer weights */
-        oHiddenLayer[i].WED[j] = 0.0;
-        
-        /* perturb weight                       */
-        /*   for hidden to output layer weights */
-        oHiddenLayer[i].Wts[j] = perturbWeight(oHiddenLayer[i].Wts[j]);
-      }
+      oHiddenUnits.Net[i]   = 0.0;
+      oHiddenUnits.Error[i] = 0.0;
+    }
+    if (!usRecurrentWindow || !bIncludeContext)
+    {
+      return;
     }
 
-    for (int i = 0; i <= ucInputVectorLength; i++)
+    for (int i = 0; i <= ucHiddenVectorLength; i++)
     {
-      for (int j = 0; j <= ucHiddenVectorLength; j++)
-      {
-        /* reset weight error derivative values */
-        /*   for input to hidden layer weights  */
-        oInputLayer[i].WED[j] = 0.0;
-        
-        /* perturb weight                       */
-        /*   for hidden to output layer weights */
-        oInputLayer[i].Wts[j] = perturbWeight(oInputLayer[i].Wts[j]);
-      }
+      /* reset error for context layer weights  */
+      oContextUnits.Net[i]   = 0.0;
+      oContextUnits.Error[i] = 0.0;
     }
-    
-    /* Output State bitmap specification 
-    Output 0: OUTPUT_VELOCITY_BACK  
-    Output 1: OUTPUT_VELOCITY_STOP  
-    Output 2: OUTPUT_VELOCITY_FWD1  
-    Output 3: OUTPUT_VELOCITY_FWD2 
-    Output 4: OUTPUT_STEER_LEFT     
-    Output 5: OUTPUT_STEER_STRAIGHT  
-    Output 6: OUTPUT_STEER_RIGHT     
-    */
-
-    double velocity_outcome = 0;
-    for (int i = 0; i < 4; i++)
-    {
-      if (oOutputLayer[i].Activation > velocity_outcome)
-      {
-        velocity_outcome = oOutputLayer[i].Activation;
-      }
+}
+
+void MachineVariables::perturbWeights( MachineWeightMatrix & oMatrix )
+{
+    for (unsigned short j = 0; j < oMatrix.usRows; j++)
+    {
+      oRandom.addNoise(oMatrix.rowWts(j), oMatrix.usColumns, dPerturbCurrent);
     }
-  
-    for (int i = 0; i < 4; i++)
+}
+
+void MachineVariables::regularize( )
+{
+    /* scheduled perturbation of the weights (see MachineRandom.h) */
+    ulTrainingSteps++;
+
+    if ((iPerturbMode == MACHINE_PERTURB_OFF) || (ulPerturbInterval == 0) ||
+        (ulTrainingSteps % ulPerturbInterval))
     {
-      if (oOutputLayer[i].Activation == velocity_outcome)
-      {
-        oOutputLayer[i].Activation = 1;
-      }
+      return;
     }
-  
-    double direction_outcome = 0;
-    for (int i = 4; i < 7; i++)
+
+    /* noise lands on every weight, so idle columns catch up first */
+    settleWeights( );
+
+    perturbWeights(oHiddenToOutput);
+    perturbWeights(oInputToHidden);
+    if (usRecurrentWindow)
     {
-      if (oOutputLayer[i].Activation > direction_outcome)
-      {
-        direction_outcome = oOutputLayer[i].Activation;
-      }
+      perturbWeights(oContextToHidden);
     }
-  
-    for (int i = 4; i < 7; i++)
+
+    if (iPerturbMode == MACHINE_PERTURB_ANNEALED)
     {
-      if (oOutputLayer[i].Activation == direction_outcome)
-      {
-        oOutputLayer[i].Activation = 1;
-      }
+      dPerturbCurrent *= dPerturbDecay;
     }
-  
 }
+
+bool MachineVariables::endEpoch( )
+{
+    bool bProgress;
+
+    ulEpochs++;
+    bProgress = oSchedule.endEpoch(ulEpochs, EpochError);
+    oOptimizer.setRateScale(oSchedule.getScale( ));
+
+    return bProgress;
+}
+
 void MachineVariables::cleanup( )
 {
   iprintf("MachineVariables::cleanup( ) entry point\n");
   
-  int i;
-  BackpropagationNode *poTempBackpropagationNode = NULL;
-
-  /* DEALLOCATION of memory for BackpropagationNode objects */
-  for (i = 0; i <= ucInputVectorLength; i++)
-  {
-    *poTempBackpropagationNode = oInputLayer[i];
-    delete poTempBackpropagationNode;
-  }
-  
-  for (i = 0; i <= ucHiddenVectorLength; i++)
-  {
-    *poTempBackpropagationNode = oHiddenLayer[i];
-    delete poTempBackpropagationNode;
-  }
-  
-  for (i = 0; i <= ucHiddenVectorLength; i++)
-  {
-    *poTempBackpropagationNode = oContextLayer[i];
-    delete poTempBackpropagationNode;
-  }
-  
-  for (i = 0; i < ucOutputVectorLength; i++)
-  {
-    *poTempBackpropagationNode = oOutputLayer[i];
-    delete poTempBackpropagationNode;
-  }
+  /* DEALLOCATION of the network arena */
+  oInputToHidden.release( );
+  oHiddenToOutput.release( );
+  oContextToHidden.release( );
+  oInputToHiddenState.release( );
+  oHiddenToOutputState.release( );
+  oContextToHiddenState.release( );
+
+  oInputUnits.release( );
+  oHiddenUnits.release( );
+  oContextUnits.release( );
+  oOutputUnits.release( );
+
+  oArena.release( );
+
+  oActivation.release( );
+
+  pulColumnUpdates = NULL;
+  pusTouched       = NULL;
+  pbTouched        = NULL;
+  usTouched        = 0;
 }
   
 void MachineVariables::display( )
@@ -616,21 +859,23 @@ void MachineVariables::display( )
 #if VIEW_INTERNALS
   int i, j;
 
+  settleWeights( );
+
   /* Bias Node of Input Layer */
 #if VIEW_ADDRESSES
-  printf("\nInput layer bias node address:  0x%x\n", &oInputLayer[0]);
+  printf("\nInput layer bias node address:  0x%x\n", &oInputUnits.Activation[0]);
 #endif
-  printf("Input layer bias node NET:  %f\n", oInputLayer[0].Net);
+  printf("Input layer bias node NET:  %f\n", machineToDouble(oInputUnits.Net[0]));
   printf("Input layer bias node ACTIVATION:  %f\n",   
-             oInputLayer[0].Activation);
+             machineToDouble(oInputUnits.Activation[0]));
   printf("Input layer bias node ERROR:  %f\n",   
-             oInputLayer[0].Error);
+             machineToDouble(oInputUnits.Error[0]));
 
   for (j = 1; j <= ucHiddenVectorLength; j++)
   {
     /* weight to hidden layer */
     printf("Weight from bias to hidden layer node  %i\n%f\n\n", j,
-               oInputLayer[0].Wts[j]);
+               machineToDouble(oInputToHidden.rowWts(j)[0]));
   }
 
   /* Input Layer */
@@ -638,38 +883,38 @@ void MachineVariables::display( )
   for (i = 1; i <= ucInputVectorLength; i++)
   {
 #if VIEW_ADDRESSES
-    printf("\nInput layer node %i address:  0x%x\n", i, &oInputLayer[i]);
+    printf("\nInput layer node %i address:  0x%x\n", i, &oInputUnits.Activation[i]);
 #endif
     printf("\nInput layer node %i NET:  %f\n", 
-               i, oInputLayer[i].Net);
+               i, machineToDouble(oInputUnits.Net[i]));
     printf("Input layer node %i ACTIVATION:  %f\n", 
-               i, oInputLayer[i].Activation);
+               i, machineToDouble(oInputUnits.Activation[i]));
     printf("Input layer node %i ERROR:  %f\n", 
-               i, oInputLayer[i].Error);
+               i, machineToDouble(oInputUnits.Error[i]));
 
     for (j = 0; j < ucHiddenVectorLength; j++)
     {
       /* weights to hidden layer */
       iprintf("Weight from input layer node %i to hidden layer node  ", i);
-      printf("%i\n%f\n\n", j, oInputLayer[i].Wts[j]);
+      printf("%i\n%f\n\n", j, machineToDouble(oInputToHidden.rowWts(j)[i]));
     }
   }
 
   /* Bias Node of Hidden Layer */
 #if VIEW_ADDRESSES
-  printf("\nHidden layer bias node address:  0x%x\n", &oHiddenLayer[0]);
+  printf("\nHidden layer bias node address:  0x%x\n", &oHiddenUnits.Activation[0]);
 #endif
-  printf("Hidden layer bias node NET:  %f\n", oHiddenLayer[0].Net);
+  printf("Hidden layer bias node NET:  %f\n", machineToDouble(oHiddenUnits.Net[0]));
   printf("Hidden layer bias node ACTIVATION:  %f\n",   
-             oHiddenLayer[0].Activation);
+             machineToDouble(oHiddenUnits.Activation[0]));
   printf("Hidden layer bias node ERROR:  %f\n",   
-             oHiddenLayer[0].Error);
+             machineToDouble(oHiddenUnits.Error[0]));
 
   for (j = 0; j < ucOutputVectorLength; j++)
   {
     /* weight to hidden layer */
     printf("Weight from bias to output layer node  %i\n%f\n\n", j,
-               oHiddenLayer[0].Wts[j]);
+               machineToDouble(oHiddenToOutput.rowWts(j)[0]));
   }
 
   /* Hidden Layer */
@@ -677,59 +922,57 @@ void MachineVariables::display( )
   for (i = 1; i <= ucHiddenVectorLength; i++)
   {
 #if VIEW_ADDRESSES
-    printf("\nHidden layer node %i address:  0x%x\n", i, &oHiddenLayer[i]);
+    printf("\nHidden layer node %i address:  0x%x\n", i, &oHiddenUnits.Activation[i]);
 #endif
     printf("\nHidden layer node %i NET:  %f\n", 
-               i, oHiddenLayer[i].Net);
+               i, machineToDouble(oHiddenUnits.Net[i]));
     printf("Hidden layer node %i ACTIVATION:  %f\n", 
-               i, oHiddenLayer[i].Activation);
+               i, machineToDouble(oHiddenUnits.Activation[i]));
     printf("Hidden layer node %i ERROR:  %f\n", 
-               i, oHiddenLayer[i].Error);
+               i, machineToDouble(oHiddenUnits.Error[i]));
 
     for (j = 0; j < ucOutputVectorLength; j++)
     {
       /* weights to output layer */
       iprintf("Weight from hidden layer node %i to output layer node  ", i);
-      printf("%i\n%f\n\n", j, oHiddenLayer[i].Wts[j]);
+      printf("%i\n%f\n\n", j, machineToDouble(oHiddenToOutput.rowWts(j)[i]));
     }
   }
 
   /* Context Layer */
 
-#if USING_RECURRENT_LAYER
-  for (i = 0; i <= ucHiddenVectorLength; i++)
+  for (i = 0; usRecurrentWindow && (i <= ucHiddenVectorLength); i++)
   {
 #if VIEW_ADDRESSES
-    printf("\nContext layer node %i address:  0x%x\n", i, &oContextLayer[i]);
+    printf("\nContext layer node %i address:  0x%x\n", i, &oContextUnits.Activation[i]);
 #endif
     printf("\nContext layer node %i NET:  %f\n", 
-               i, oContextLayer[i].Net);
+               i, machineToDouble(oContextUnits.Net[i]));
     printf("Context layer node %i ACTIVATION:  %f\n", 
-               i, oContextLayer[i].Activation);
+               i, machineToDouble(oContextUnits.Activation[i]));
     printf("Context layer node %i ERROR:  %f\n", 
-               i, oContextLayer[i].Error);
+               i, machineToDouble(oContextUnits.Error[i]));
 
     for (j = 1; j <= ucHiddenVectorLength; j++)
     {
       /* weights to hidden layer */
       iprintf("Weight from context layer node %i to hidden layer node  ", i);
-      printf("%i\n%f\n\n", j, oContextLayer[i].Wts[j]);
+      printf("%i\n%f\n\n", j, machineToDouble(oContextToHidden.rowWts(j)[i]));
     }
   }
-#endif
   
   /* Output Layer */
   
   for (i = 0; i < ucOutputVectorLength; i++)
   {
 #if VIEW_ADDRESSES
-    printf("\nOutput layer node %i address:  0x%x\n", i, &oOutputLayer[i]);
+    printf("\nOutput layer node %i address:  0x%x\n", i, &oOutputUnits.Activation[i]);
 #endif
-    printf("Output layer node %i NET:  %f\n", i, oOutputLayer[i].Net);
+    printf("Output layer node %i NET:  %f\n", i, machineToDouble(oOutputUnits.Net[i]));
     printf("Output layer node %i ACTIVATION:  %f\n", 
-               i, oOutputLayer[i].Activation);
+               i, machineToDouble(oOutputUnits.Activation[i]));
     printf("Output layer node %i ERROR:  %f\n", 
-               i, oOutputLayer[i].Error);
+               i, machineToDouble(oOutputUnits.Error[i]));
   }
   
   iprintf("\n\n");
@@ -739,19 +982,19 @@ void MachineVariables::display( )
   
   for (i = 1; i <= ucInputVectorLength; i++)
   {
-    printf("Input #%i:  %f\n", i, oInputLayer[i].Activation);
+    printf("Input #%i:  %f\n", i, machineToDouble(oInputUnits.Activation[i]));
   }
 
   for (i = 0; i < ucOutputVectorLength; i++)
   {
-    printf("Output #%i:  %f\n", i, oOutputLayer[i].Activation);
-    printf("Output #%i ERROR:  %f\n", i, oOutputLayer[i].Error);
+    printf("Output #%i:  %f\n", i, machineToDouble(oOutputUnits.Activation[i]));
+    printf("Output #%i ERROR:  %f\n", i, machineToDouble(oOutputUnits.Error[i]));
   }
   iprintf("\n\n");
 #elif VIEW_ERROR_ONLY
   for (int i = 0; i < ucOutputVectorLength; i++)
   {
-    printf("Output ERROR:  %f\n", oOutputLayer[i].Error);
+    printf("Output ERROR:  %f\n", machineToDouble(oOutputUnits.Error[i]));
   }
 #endif
 }
@@ -760,9 +1003,10 @@ void MachineVariables::parseOutputForDisplay(unsigned char* msg)
 {
   unsigned long ulTempPattern = 0x00000000;
 
-  for (int i=0; i < MAXIMUM_BYTES; i++)
+  /* the flags below sit in the first 32 bits of the bitmap */
+  for (int i=0; (i < MAXIMUM_BYTES) && (i < 4); i++)
   {
-    ulTempPattern = ulTempPattern | (msg[i] << (8*i));
+    ulTempPattern = ulTempPattern | ((unsigned long)msg[i] << (8*i));
   }
 
   if (ulTempPattern & OUTPUT_VELOCITY_BACK)
@@ -806,9 +1050,10 @@ void MachineVariables::parseInputForDisplay(unsigned char* msg)
 {
   unsigned long ulTempPattern = 0x00000000;
   
-  for (int i=0; i < MAXIMUM_BYTES; i++)
+  /* the flags below sit in the first 32 bits of the bitmap */
+  for (int i=0; (i < MAXIMUM_BYTES) && (i < 4); i++)
   {
-    ulTempPattern = ulTempPattern | (msg[i] << (8*i));
+    ulTempPattern = ulTempPattern | ((unsigned long)msg[i] << (8*i));
   }
 
   printf("\n");
@@ -13,12 +13,19 @@
 
   #include <stdlib.h>   
   #include <stdio.h>
+  #include <string.h>
   #include <time.h>
   
-  #include "BackpropagationNode.h"
+  #include "MachineWeights.h"
+  #include "MachineKernels.h"
+  #include "MachineActivation.h"
+  #include "MachineOptimizer.h"
+  #include "MachineSchedule.h"
+  #include "MachineRandom.h"
+  #include "MachineModel.h"
+  #include "MachineTrainer.h"
+  #include "MachineCheckpoint.h"
   #include "MachineEngine.h"  /* for temporary inspection of TCB/uCos facility */
-  
-  #define MAXIMUM_NODES_PER_LAYER 33
 
   class MachineVariables
   {
@@ -37,22 +44,152 @@
         
         double         EpochError;
 
-        BackpropagationNode oInputLayer[MAXIMUM_NODES_PER_LAYER];
-        BackpropagationNode oHiddenLayer[MAXIMUM_NODES_PER_LAYER];
-        BackpropagationNode oContextLayer[MAXIMUM_NODES_PER_LAYER];  /* specific to recurrent net */
-        BackpropagationNode oOutputLayer[MAXIMUM_NODES_PER_LAYER];
+        /* complete training passes over the canned set */
+        unsigned long  ulEpochs;
+
+        /* requested forward pass kernel (MACHINE_KERNEL_*) & the one in use */
+        int                    iKernelType;
+        const MachineKernels * poKernels;
+
+        /* requested activation (MACHINE_ACTIVATION_*), table error bound */
+        int                    iActivationType;
+        double                 dActivationErrorBound;
+        MachineActivation      oActivation;
+
+        /* per-network generator, 0 seeds it from rand( ) */
+        unsigned long          ulRandomSeed;
+        MachineRandom          oRandom;
+
+        /* weight perturbation schedule (MACHINE_PERTURB_*) */
+        int                    iPerturbMode;
+        unsigned long          ulPerturbInterval;
+        double                 dPerturbAmplitude;
+        double                 dPerturbDecay;
+        unsigned long          ulTrainingSteps;
+        double                 dPerturbCurrent;
+
+        /* weight update rule (MACHINE_OPTIMIZER_*) */
+        int                    iOptimizerType;
+        MachineOptimizer       oOptimizer;
+
+        /* scales the optimizer's rate epoch by epoch, and tells when */
+        /* training has stopped making progress                       */
+        MachineSchedule        oSchedule;
+
+        /* samples per weight update (MACHINE_BATCH_EPOCH for one pass */
+        /* over the data) & samples accumulated so far;  the engine    */
+        /* sets the epoch length of the data it is training on         */
+        unsigned short         usBatchSize;
+        unsigned short         usBatchCount;
+        unsigned short         usEpochLength;
+
+        /* Elman context layer:  0 leaves the network feed-forward, */
+        /* else the steps backpropagation through time reaches back */
+        unsigned short         usRecurrentWindow;
+
+        /* the last usRecurrentWindow steps, the oldest overwritten   */
+        /* first, in one contiguous block:  per step the input & the  */
+        /* context it read, then the hidden net & activation it made  */
+        MachineScalar *        pdHistory;
+        unsigned short         usHistoryStride;   /* scalars per step  */
+        unsigned short         usHistoryNext;     /* slot of next step */
+        unsigned short         usHistoryCount;    /* steps held        */
+
+        /* hidden deltas & errors of the step being unrolled */
+        MachineScalar *        pdUnrollDelta;
+        MachineScalar *        pdUnrollError;
+
+        /* lazy input to hidden updates:  a column whose input stayed */
+        /* zero through a batch only decays its momentum, which is    */
+        /* applied (in closed form) once the column is next used;     */
+        /* per column, the weight updates already applied to it       */
+        unsigned long          ulWeightUpdates;
+        unsigned long *        pulColumnUpdates;
+
+        /* columns given derivatives in the current batch */
+        unsigned short *       pusTouched;
+        unsigned short         usTouched;
+        bool *                 pbTouched;
+
+        /* single allocation backing every vector & matrix below */
+        MachineArena        oArena;
+
+        /* unit state, index 0 of input & hidden layers is the bias unit */
+        MachineUnitVector   oInputUnits;
+        MachineUnitVector   oHiddenUnits;
+        MachineUnitVector   oContextUnits;     /* specific to recurrent net */
+        MachineUnitVector   oOutputUnits;
+
+        /* weights, one matrix per layer pair */
+        MachineWeightMatrix oInputToHidden;
+        MachineWeightMatrix oHiddenToOutput;
+        MachineWeightMatrix oContextToHidden;  /* specific to recurrent net */
+
+        /* optimizer state, one per weight matrix */
+        MachineOptimizerState oInputToHiddenState;
+        MachineOptimizerState oHiddenToOutputState;
+        MachineOptimizerState oContextToHiddenState;
   private:
         double provideRandomUnitValue( );
-        double checkWeightBoundary(double weightValue);
-        double perturbWeight(double weightValue);
+        MachineScalar checkWeightBoundary(MachineScalar weightValue) const;
         void iterate( );
         void train( );
-        void endOfIteration( );
-  
-        static const double LearningRate = 0.33;
-        static const double Momentum     = 0.85;
+        void accumulateGradients( );
+
+        /* starts a new sequence:  the context & step history cleared */
+        void resetHistory( );
+
+        /* context to hidden derivatives of every step in the history, */
+        /* and input to hidden derivatives of the steps before the     */
+        /* current one, from the hidden deltas backpropagate( ) left   */
+        void backpropagateThroughTime( );
+
+        /* brings input to hidden columns up to date with every weight  */
+        /* update so far:  the listed ones, or all when usColumns is 0; */
+        /* only momentum SGD leaves columns idle (see isLazy( ))        */
+        void settleColumns(const unsigned short * pusColumns,
+                           unsigned short usColumns);
+        void settleWeights( );
+
+        /* input to hidden weights as settleWeights( ) would leave them, */
+        /* written over pdWts (a copy in the matrix's layout) while the  */
+        /* network itself is left as it is                               */
+        void settledCopy(MachineScalar * pdWts) const;
+
+        /* marks the listed columns (all, when usColumns is 0) as given */
+        /* derivatives in the current batch                             */
+        void touchColumns(const unsigned short * pusColumns,
+                          unsigned short usColumns);
+
+        /* backward pass of one sample through the feed-forward layers, */
+        /* adding its weight error derivatives into the WED planes of   */
+        /* the matrices;  shared with the per-thread gradients of       */
+        /* MachineTrainer                                               */
+        static void backpropagate(const MachineActivation & oActivation,
+                                  MachineUnitVector & oInputUnits,
+                                  MachineUnitVector & oHiddenUnits,
+                                  MachineUnitVector & oOutputUnits,
+                                  MachineWeightMatrix & oInputToHidden,
+                                  MachineWeightMatrix & oHiddenToOutput);
+        void updateWeights( );
+        void applySteps(MachineWeightMatrix & oMatrix,
+                        MachineOptimizerState & oState,
+                        unsigned short usRow,
+                        const unsigned short * pusColumns,
+                        unsigned short usFirst,
+                        unsigned short usCount);
+        void resetUnits( bool bIncludeContext );
+        void perturbWeights( MachineWeightMatrix & oMatrix );
+        void regularize( );
+
+        /* counts the epoch just completed & feeds its error to the */
+        /* schedule;  false once training has stalled               */
+        bool endEpoch( );
 
   friend class MachineEngine;
+  friend class MachineModel;
+  friend class MachineTrainer;
+  friend class MachineCheckpoint;
   };
 
   #endif  // #ifndef MACHINEVARIABLES_H
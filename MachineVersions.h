@@ -0,0 +1,126 @@
+/***************************************************
+ *
+ * 	MachineVersions.h
+ *
+ *	versioned store of one item:  a writer
+ *	task fills a shadow copy and publishes
+ *	it atomically, while any of a fixed
+ *	number of reader tasks pin the latest
+ *	version without ever waiting
+ *
+ **************************************************/
+
+  #ifndef MACHINEVERSIONS_H
+  #define MACHINEVERSIONS_H 1
+
+  #include "MachineRuntime.h"
+
+  /* exactly one task writes, and each reader number belongs to one   */
+  /* task;  a reader pins the current copy for as long as it uses it, */
+  /* announcing it in a slot of its own.  A copy is reclaimed as the  */
+  /* next shadow only once it is no longer current & no reader        */
+  /* announces it;  with a copy per reader, plus the current one,     */
+  /* plus the shadow, the writer always finds one and never waits     */
+  template <class Item, unsigned long Readers>
+  class MachineVersionStore
+  {
+  public:
+		MachineVersionStore( )
+		{
+		  reset( );
+		}
+
+        /* only while no task is using the store */
+        void reset( )
+        {
+          ulCurrent = 0;
+          ulVersion = 0;
+          ulShadow  = 1;
+
+          for (unsigned long r = 0; r < Readers; r++)
+          {
+            aulPinned[r] = 0;
+          }
+        }
+
+        /* reader ulReader (0 .. Readers - 1):  the current copy, */
+        /* unchanged until unpin( )                               */
+        const Item & pin(unsigned long ulReader)
+        {
+          unsigned long ulCopy;
+
+          /* a publish( ) between reading the current copy & announcing */
+          /* it may already have handed the copy back to the writer     */
+          do
+          {
+            ulCopy = machineLoadAcquire(&ulCurrent);
+            machineStoreRelease(&aulPinned[ulReader], ulCopy + 1);
+            machineFullFence( );
+          }
+          while (machineLoadAcquire(&ulCurrent) != ulCopy);
+
+          return aoItems[ulCopy];
+        }
+
+        void unpin(unsigned long ulReader)
+        {
+          machineStoreRelease(&aulPinned[ulReader], 0);
+        }
+
+        /* writer:  the shadow copy, which no reader can reach */
+        Item & getShadow( )
+        {
+          return aoItems[ulShadow];
+        }
+
+        /* writer:  the shadow becomes the current copy, and the next */
+        /* shadow is a copy no reader holds                           */
+        void publish( )
+        {
+          machineStoreRelease(&ulCurrent, ulShadow);
+          machineFullFence( );
+          machineStoreRelease(&ulVersion, ulVersion + 1);
+
+          ulShadow = reclaim( );
+        }
+
+        /* publish( )es so far;  0 while no copy has been filled */
+        unsigned long getVersion( ) const
+        {
+          return machineLoadAcquire(&ulVersion);
+        }
+
+  private:
+        unsigned long reclaim( ) const
+        {
+          for (unsigned long c = 0; c < Readers + 2; c++)
+          {
+            bool bFree = (c != ulCurrent);
+
+            for (unsigned long r = 0; bFree && (r < Readers); r++)
+            {
+              bFree = (machineLoadAcquire(&aulPinned[r]) != c + 1);
+            }
+
+            if (bFree)
+            {
+              return c;
+            }
+          }
+
+          /* unreachable:  Readers pins & the current copy leave one */
+          return ulShadow;
+        }
+
+        /* written by the writer only */
+        volatile unsigned long ulCurrent;
+        volatile unsigned long ulVersion;
+        unsigned long          ulShadow;
+
+        /* each written by its reader only:  the pinned copy + 1, or 0 */
+        volatile unsigned long aulPinned[Readers];
+
+        Item                   aoItems[Readers + 2];
+  };
+
+  #endif  // #ifndef MACHINEVERSIONS_H
@@ -0,0 +1,230 @@
+/***************************************************
+ *
+ *  MachineWeights.cpp
+ *
+ *  MachineArena, MachineUnitVector &
+ *  MachineWeightMatrix classes -
+ *		contiguous, aligned storage for the
+ *		unit state and weights of the network,
+ *		used by the MachineVariables class.
+ *
+ **************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "MachineWeights.h"
+
+/* number of scalars that fill one alignment boundary */
+#define SCALARS_PER_ALIGNMENT (MACHINE_ALIGNMENT_BYTES / sizeof(MachineScalar))
+
+static unsigned short padToAlignment(unsigned short usCount)
+{
+  return (unsigned short)(((usCount + SCALARS_PER_ALIGNMENT - 1) /
+                           SCALARS_PER_ALIGNMENT) * SCALARS_PER_ALIGNMENT);
+}
+
+MachineArena::MachineArena( )
+{
+  pucBlock   = NULL;
+  pucBase    = NULL;
+  ulReserved = 0;
+  ulCarved   = 0;
+}
+
+MachineArena::~MachineArena( )
+{
+  release( );
+}
+
+void MachineArena::reserve(unsigned long ulBytes)
+{
+  ulReserved += ulBytes;
+}
+
+bool MachineArena::allocate( )
+{
+  unsigned long ulAddress;
+
+  if (pucBlock)
+  {
+    delete [] pucBlock;
+  }
+
+  /* one block for the whole network, plus alignment slack */
+  pucBlock = new unsigned char[ulReserved + MACHINE_ALIGNMENT_BYTES];
+  ulCarved = 0;
+
+  if (!pucBlock)
+  {
+    pucBase = NULL;
+    return false;
+  }
+
+  ulAddress = ((unsigned long)pucBlock + MACHINE_ALIGNMENT_BYTES - 1) &
+              ~((unsigned long)MACHINE_ALIGNMENT_BYTES - 1);
+  pucBase   = (unsigned char *)ulAddress;
+
+  memset(pucBase, 0, ulReserved);
+
+  return true;
+}
+
+MachineScalar * MachineArena::carve(unsigned long ulBytes)
+{
+  MachineScalar * pdPlane;
+
+  if (!pucBase || (ulCarved + ulBytes > ulReserved))
+  {
+    /* carve( ) calls must match the reserve( ) calls */
+    return NULL;
+  }
+
+  pdPlane   = (MachineScalar *)(pucBase + ulCarved);
+  ulCarved += ulBytes;
+
+  return pdPlane;
+}
+
+void MachineArena::release( )
+{
+  if (pucBlock)
+  {
+    delete [] pucBlock;
+  }
+
+  pucBlock   = NULL;
+  pucBase    = NULL;
+  ulReserved = 0;
+  ulCarved   = 0;
+}
+
+unsigned long MachineArena::getSize( )
+{
+  return ulReserved;
+}
+
+unsigned short MachineArena::alignedLength(unsigned short usCount)
+{
+  return padToAlignment(usCount);
+}
+
+unsigned long MachineArena::alignedBytes(unsigned long ulBytes)
+{
+  return ((ulBytes + MACHINE_ALIGNMENT_BYTES - 1) / MACHINE_ALIGNMENT_BYTES) *
+         MACHINE_ALIGNMENT_BYTES;
+}
+
+MachineUnitVector::MachineUnitVector( )
+{
+  usLength   = 0;
+  usStride   = 0;
+  Net        = NULL;
+  Activation = NULL;
+  Error      = NULL;
+  Delta      = NULL;
+}
+
+MachineUnitVector::~MachineUnitVector( )
+{
+  release( );
+}
+
+void MachineUnitVector::configure(unsigned short usLocalLength)
+{
+  usLength = usLocalLength;
+  usStride = padToAlignment(usLocalLength);
+}
+
+unsigned long MachineUnitVector::getBytes( )
+{
+  /* Net, Activation, Error & Delta planes */
+  return 4 * (unsigned long)usStride * sizeof(MachineScalar);
+}
+
+void MachineUnitVector::bind(MachineArena * poArena)
+{
+  Net = poArena->carve(getBytes( ));
+
+  if (Net)
+  {
+    Activation = Net        + usStride;
+    Error      = Activation + usStride;
+    Delta      = Error      + usStride;
+  }
+}
+
+void MachineUnitVector::release( )
+{
+  /* storage belongs to the arena */
+  usLength   = 0;
+  usStride   = 0;
+  Net        = NULL;
+  Activation = NULL;
+  Error      = NULL;
+  Delta      = NULL;
+}
+
+MachineWeightMatrix::MachineWeightMatrix( )
+{
+  usRows    = 0;
+  usColumns = 0;
+  usStride  = 0;
+  bTrainable = true;
+  Wts       = NULL;
+  WED       = NULL;
+  DeltaWts  = NULL;
+}
+
+MachineWeightMatrix::~MachineWeightMatrix( )
+{
+  release( );
+}
+
+void MachineWeightMatrix::configure(unsigned short usLocalRows,
+                                    unsigned short usLocalColumns,
+                                    bool bLocalTrainable)
+{
+  usRows     = usLocalRows;
+  usColumns  = usLocalColumns;
+  usStride   = padToAlignment(usLocalColumns);
+  bTrainable = bLocalTrainable;
+}
+
+unsigned long MachineWeightMatrix::getBytes( )
+{
+  /* Wts, WED & DeltaWts planes (Wts only when not trainable) */
+  return (bTrainable ? 3 : 1) *
+         (unsigned long)usRows * usStride * sizeof(MachineScalar);
+}
+
+void MachineWeightMatrix::bind(MachineArena * poArena)
+{
+  unsigned long ulPlane = (unsigned long)usRows * usStride;
+
+  Wts = poArena->carve(getBytes( ));
+
+  if (Wts && bTrainable)
+  {
+    WED      = Wts + ulPlane;
+    DeltaWts = WED + ulPlane;
+  }
+}
+
+void MachineWeightMatrix::attach(const MachineScalar * pdWts)
+{
+  if (!bTrainable)
+  {
+    Wts = (MachineScalar *)pdWts;
+  }
+}
+
+void MachineWeightMatrix::release( )
+{
+  /* storage belongs to the arena */
+  usRows    = 0;
+  usColumns = 0;
+  usStride  = 0;
+  Wts       = NULL;
+  WED       = NULL;
+  DeltaWts  = NULL;
+}
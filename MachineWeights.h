@@ -0,0 +1,128 @@
+/***************************************************
+ *
+ * 	MachineWeights.h
+ *
+ *	contiguous layer storage:
+ *		MachineArena        - single block per network
+ *		MachineUnitVector   - per-layer unit state
+ *		MachineWeightMatrix - per-layer-pair weights
+ *
+ **************************************************/
+
+  #ifndef MACHINEWEIGHTS_H
+  #define MACHINEWEIGHTS_H 1
+
+  #include "MachineScalar.h"
+
+  /* every block (and every matrix row) starts on this byte boundary */
+  #define MACHINE_ALIGNMENT_BYTES 64
+
+  /* the arena is sized in two passes:  every storage object first */
+  /* reserve( )s its bytes, then the arena is allocated once and    */
+  /* each object carve( )s its planes out of it in the same order   */
+  class MachineArena
+  {
+  public:
+		MachineArena( );
+		~MachineArena( );
+        void reserve(unsigned long ulBytes);
+        bool allocate( );
+        MachineScalar * carve(unsigned long ulBytes);
+        void release( );
+        unsigned long getSize( );
+
+        /* usCount scalars padded to the alignment, as used for strides */
+        static unsigned short alignedLength(unsigned short usCount);
+
+        /* ulBytes padded to the alignment, so later carves stay aligned */
+        static unsigned long alignedBytes(unsigned long ulBytes);
+
+  private:
+        unsigned char * pucBlock;
+        unsigned char * pucBase;
+        unsigned long   ulReserved;
+        unsigned long   ulCarved;
+  };
+
+  class MachineUnitVector
+  {
+  public:
+		MachineUnitVector( );
+		~MachineUnitVector( );
+        void configure(unsigned short usLocalLength);
+        unsigned long getBytes( );
+        void bind(MachineArena * poArena);
+        void release( );
+
+  protected:
+        unsigned short usLength;
+        unsigned short usStride;   /* length padded to the alignment */
+
+        MachineScalar * Net;
+        MachineScalar * Activation;
+        MachineScalar * Error;
+        MachineScalar * Delta;
+
+  friend class MachineEngine;
+  friend class MachineVariables;
+  friend class MachineModel;
+  friend class MachineContext;
+  friend class MachineBatch;
+  friend class MachineTrainer;
+  };
+
+  /* one row per destination unit, one column per source unit    */
+  /* (column 0 is the source layer bias unit);  Wts, WED and      */
+  /* DeltaWts are separate row-major planes within the arena;     */
+  /* a matrix configured without training carries only Wts        */
+  class MachineWeightMatrix
+  {
+  public:
+		MachineWeightMatrix( );
+		~MachineWeightMatrix( );
+        void configure(unsigned short usLocalRows, unsigned short usLocalColumns,
+                       bool bLocalTrainable = true);
+        unsigned long getBytes( );
+        void bind(MachineArena * poArena);
+        void release( );
+
+        /* Wts plane held outside any arena (e.g. a mapped model image); */
+        /* only for matrices configured without training, never written  */
+        void attach(const MachineScalar * pdWts);
+
+        MachineScalar * rowWts(unsigned short usRow)
+        {
+          return Wts + (unsigned long)usRow * usStride;
+        }
+        MachineScalar * rowWED(unsigned short usRow)
+        {
+          return WED + (unsigned long)usRow * usStride;
+        }
+        MachineScalar * rowDeltaWts(unsigned short usRow)
+        {
+          return DeltaWts + (unsigned long)usRow * usStride;
+        }
+        const MachineScalar * rowWts(unsigned short usRow) const
+        {
+          return Wts + (unsigned long)usRow * usStride;
+        }
+
+  protected:
+        unsigned short usRows;
+        unsigned short usColumns;
+        unsigned short usStride;   /* columns padded to the alignment */
+        bool           bTrainable; /* WED & DeltaWts planes present   */
+
+        MachineScalar * Wts;
+        MachineScalar * WED;
+        MachineScalar * DeltaWts;
+
+  friend class MachineEngine;
+  friend class MachineVariables;
+  friend class MachineModel;
+  friend class MachineTrainer;
+  friend class MachineCheckpoint;
+  friend class MachineOptimizerState;
+  };
+
+  #endif  // #ifndef MACHINEWEIGHTS_H
@@ -1,21 +0,0 @@
-/***************************************************
- *
- * 	BackpropagationNode.cpp
- *
- *	BackpropagationNode class:
- *
- **************************************************/
-
-  #include "BackpropagationNode.h"
-
-  BackpropagationNode::BackpropagationNode( )
-  {
-
-  }
-
-  BackpropagationNode::~BackpropagationNode( )
-  {
-
-  }
-
-
@@ -9,20 +9,17 @@
  *****************************************************************************/
 
 
-#include "predef.h"
-#include <stdio.h>
+#include "MachineEngine.h"
+
+#if MACHINE_RUNTIME == MACHINE_RUNTIME_RTOS
 #include <ctype.h>
-#include <startnet.h>
 #include <http.h>
 #include <ucosmcfc.h>
 #include <system.h>
 #include <iosys.h>
-#include <serial.h>
 #include <dhcpclient.h>
 #include <taskmon.h>
 
-#include "MachineEngine.h"
-
 extern const char *PlatformName;
 
 extern "C"
@@ -30,18 +27,30 @@ extern "C"
    void UserMain( void *pd );
    void OSDumpTCBs();
 }
+#else
+static const char *PlatformName = "POSIX host";
+#endif
 
 
 const char *AppName = "Machine Training test application";
 
-void UserMain( void *pd )
+/* advise & keep learning from labelled frames, rather than stopping */
+/* after one epoch of advice (MachineParameters::setOnlineLearning) */
+#ifndef MACHINE_ONLINE_LEARNING
+#define MACHINE_ONLINE_LEARNING  0
+#endif
+
+/* steps of backpropagation through time for the Elman context layer, */
+/* or 0 for a feed-forward network                                     */
+/* (MachineParameters::setRecurrentWindow)                             */
+#ifndef MACHINE_RECURRENT_WINDOW
+#define MACHINE_RECURRENT_WINDOW  MACHINE_RECURRENT_OFF
+#endif
+
+/* train on the canned data (or resume from a checkpoint), then */
+/* advise;  shared by both runtimes                             */
+static void runMachine( )
 {
-   InitializeStack();
-   OSChangePrio( MAIN_PRIO );
-
-   iprintf( "Machine Training application started on %s\r\n", PlatformName );
-
-  /* This routine is the entry point for application */
   iprintf("Calling MachineEngine class constructor\n");
   MachineEngine * poME = new MachineEngine();
   iprintf("Calling MachineParameters class constructor\n");
@@ -52,27 +61,96 @@ void UserMain( void *pd )
   
   poMP->setInputVectorLength( ucInputVectorLength+1 );
   poMP->setOutputVectorLength( ucOutputVectorLength );
+  poMP->setRecurrentWindow( MACHINE_RECURRENT_WINDOW );
   poMP->setMachineTraining( TRUE );
 
   /* Set parameters before calling configure & start */
   iprintf("Calling MachineEngine::configure( )\n");
   poME->configure(poMP);
 
-  iprintf("Calling MachineEngine::start( )\n");
-  poME->start();
-
-  iprintf("Training completed.  Error threshold reached.\n");
-  iprintf("Control returned to application.\n");
+#if MACHINE_CHECKPOINT_FILES
+  if (poME->loadCheckpointFile(MACHINE_CHECKPOINT_FILE))
+  {
+    iprintf("Loaded %s, skipping training\n", MACHINE_CHECKPOINT_FILE);
+
+    /* advise straight from the shared model image when there is one */
+    if (poME->mapModelFile(MACHINE_MODEL_FILE))
+    {
+      iprintf("Mapped %s for inference\n", MACHINE_MODEL_FILE);
+    }
+  }
+  else
+#endif
+  {
+    /* canned vectors train straight from memory;  should they not reach */
+    /* the threshold, training carries on through the I/O pipeline       */
+    iprintf("Calling MachineEngine::trainCanned( )\n");
+
+    if (!poME->trainCanned(MAXIMUM_EPOCHS) && !poME->stalled( ))
+    {
+      iprintf("Calling MachineEngine::start( )\n");
+      poME->start();
+    }
+
+    bool bConverged = !poME->stalled( );
+
+    if (!bConverged)
+    {
+      iprintf("Training stopped.  Epoch error no longer improving.\n");
+    }
+    else
+    {
+      iprintf("Training completed.  Error threshold reached.\n");
+    }
+    iprintf("Control returned to application.\n");
+
+#if MACHINE_CHECKPOINT_FILES
+    /* a saved checkpoint skips training at the next start-up, so only */
+    /* a network that reached the threshold is saved                   */
+    if (bConverged)
+    {
+      poME->saveCheckpointFile(MACHINE_CHECKPOINT_FILE);
+      poME->saveModelFile(MACHINE_MODEL_FILE);
+    }
+#endif
+  }
 
   poMP->setMachineTraining( FALSE );
+  poMP->setOnlineLearning( MACHINE_ONLINE_LEARNING );
   poME->start();
 
+#if MACHINE_RUNTIME == MACHINE_RUNTIME_POSIX
+  /* hot loop events, for tools/MachineTraceDecoder */
+  MachineTrace::dumpFile(MACHINE_TRACE_FILE);
+#endif
+
   iprintf("End bumper.  We only get here is there is a problem");
   iprintf(" in MachineEngine::start( )\n");
+}
+
+#if MACHINE_RUNTIME == MACHINE_RUNTIME_RTOS
+void UserMain( void *pd )
+{
+   InitializeStack();
+   OSChangePrio( MAIN_PRIO );
+
+   iprintf( "Machine Training application started on %s\r\n", PlatformName );
+
+   runMachine( );
   
    while ( 1 )
    {
      /* empty while loop as backup */
    }//While
 }
+#else
+int main( )
+{
+   iprintf( "Machine Training application started on %s\r\n", PlatformName );
+
+   runMachine( );
+
+   return 1;
+}
+#endif
 
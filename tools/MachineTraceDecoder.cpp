@@ -0,0 +1,51 @@
+/***************************************************
+ *
+ *  MachineTraceDecoder.cpp
+ *
+ *  offline decoder for MachineTrace dumps -
+ *		prints one line per recorded event.
+ *		Built on its own, from the top of
+ *		the tree:
+ *
+ *		g++ -I. tools/MachineTraceDecoder.cpp
+ *		    MachineTrace.cpp MachineRuntime.cpp
+ *		    -pthread -o tracedecode
+ *
+ **************************************************/
+#include "MachineTrace.h"
+
+int main(int argc, char ** argv)
+{
+  const char * pcPath = (argc > 1) ? argv[1] : MACHINE_TRACE_FILE;
+  unsigned char * pucDump;
+  long lBytes;
+  bool bRendered;
+  FILE * pFile = fopen(pcPath, "rb");
+
+  if (!pFile)
+  {
+    printf("Unable to open %s\n", pcPath);
+    return 1;
+  }
+
+  fseek(pFile, 0, SEEK_END);
+  lBytes = ftell(pFile);
+  fseek(pFile, 0, SEEK_SET);
+
+  if (lBytes <= 0)
+  {
+    printf("Empty trace dump %s\n", pcPath);
+    fclose(pFile);
+    return 1;
+  }
+
+  pucDump = new unsigned char[lBytes];
+  lBytes  = (long)fread(pucDump, 1, lBytes, pFile);
+  fclose(pFile);
+
+  bRendered = MachineTrace::render(pucDump, (unsigned long)lBytes);
+
+  delete [] pucDump;
+
+  return bRendered ? 0 : 1;
+}